@@ -8,6 +8,9 @@
  * saves it to an SD card using an attached RV-8803 RTC to name and date the files with
  * the current date/time.
  *
+ * The date/time and the camera settings are also written into an EXIF segment inside
+ * each image as it is transferred.
+ *
  * This example also write some metadata about the image process to a metadata csv file.
  *
  * @note This example does **NOT** set the time on the RTC, it assumes the RTC time has
@@ -21,6 +24,8 @@
 // ---------------------------------------------------------------------------
 #include <Arduino.h>
 #include <GeoluxCamera.h>
+#include <GeoluxExif.h>
+#include <GeoluxFileSink.h>
 #include <SdFat.h>
 #include <SparkFun_RV8803.h>
 
@@ -391,8 +396,19 @@ void loop() {
     // dump anything in the camera stream, just in case
     while (cameraSerial.available()) { cameraSerial.read(); }
 
-    // transfer the image from the camera to a file on the SD card
-    uint32_t bytes_transferred = camera.transferImage(imgFile, image_size);
+    // read the camera settings once to describe the image with
+    GeoluxCamera::geolux_info camera_info;
+    camera.getCameraInfo(camera_info);
+
+    // transfer the image from the camera to a file on the SD card, adding the time
+    // stamp and settings to the image as EXIF data on the way; the file is
+    // preallocated from the image size and written in whole sectors
+    GeoluxFileSink<decltype(imgFile)> file_sink(imgFile);
+    GeoluxExifSink                    exif(file_sink);
+    exif.setCameraInfo(camera_info);
+    exif.setTimestamp(rtc.getYear(), rtc.getMonth(), rtc.getDate(), rtc.getHours(),
+                      rtc.getMinutes(), rtc.getSeconds());
+    uint32_t bytes_transferred = camera.transferImage(exif, image_size);
     // Close the image file
     imgFile.close();
     // See how long it took us
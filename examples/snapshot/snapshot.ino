@@ -113,6 +113,11 @@ uint32_t                    start_millis = 0;  // for tracking timing
 GeoluxCamera::geolux_status camera_status;     // for the current status
 uint32_t                    wait_time;         // for tracking how long operations take
 
+// decodes each image as it is written to the card, to score its sharpness
+GeoluxJpegSink jpeg_sink(imgFile);
+// the sharpness of the first image after the last autofocus
+uint16_t reference_sharpness = 0;
+
 void autofocus_camera() {
     Serial.println("Asking camera to autofocus");
     if (camera.runAutofocus() == GeoluxCamera::OK) {
@@ -134,6 +139,8 @@ void autofocus_camera() {
         Serial.println("Autofocus timed out!");
         return;
     }
+    // measure the sharpness again on the next image
+    reference_sharpness = 0;
     Serial.print("New focus point is: ");
     Serial.print(camera.getAutofocusX());
     Serial.print(',');
@@ -291,10 +298,6 @@ void loop() {
         }
     } while (file_exits);
 
-    // run the autofocus before each image
-    // NOTE: The autofocus takes an *absurd* 30s to complete!
-    // autofocus_camera();
-
     start_millis = millis();
     Serial.print("Requesting that the camera take a picture ... ");
     if (camera.takeSnapshot() == GeoluxCamera::OK) {
@@ -330,7 +333,7 @@ void loop() {
     while (cameraSerial.available()) { cameraSerial.read(); }
 
     // transfer the image from the camera to a file on the SD card
-    uint32_t bytes_transferred = camera.transferImage(imgFile, image_size);
+    uint32_t bytes_transferred = camera.transferImage(jpeg_sink, image_size);
     // Close the image file
     imgFile.close();
     // See how long it took us
@@ -347,6 +350,22 @@ void loop() {
     Serial.print(transfer_time);
     Serial.println("ms");
 
+    // The autofocus takes an *absurd* 30s to complete on older firmware and ~7s on
+    // newer, so instead of running it before each image only run it when the images
+    // get noticeably less sharp than the first one after the last autofocus.
+    if (jpeg_sink.wasDecoded()) {
+        Serial.print("Scene change since the last image: ");
+        Serial.println(jpeg_sink.getDifference());
+        Serial.print("Image sharpness: ");
+        Serial.println(jpeg_sink.getSharpness());
+        if (!reference_sharpness) {
+            reference_sharpness = jpeg_sink.getSharpness();
+        } else if (jpeg_sink.getSharpness() < reference_sharpness * 3 / 4) {
+            Serial.println("Image is less sharp than after the last autofocus");
+            autofocus_camera();
+        }
+    }
+
     image_number++;
     Serial.print(F("Wait "));
     Serial.print(seconds_between_images);
@@ -0,0 +1,85 @@
+/** =========================================================================
+ * @example{lineno} footprint.ino
+ * @author Sara Damiano <sdamiano@stroudcenter.org>
+ * @copyright Stroud Water Research Center
+ * @license This example is published under the BSD-3 license.
+ *
+ * @brief A capture sketch that calls every enabled group of camera commands, built by
+ * footprint.py to measure the flash and RAM cost of each feature profile.
+ *
+ * @m_examplenavigation{extra_footprint,}
+ * ======================================================================= */
+
+// ---------------------------------------------------------------------------
+// Include the base required libraries
+// ---------------------------------------------------------------------------
+#include <Arduino.h>
+#include <GeoluxCamera.h>
+
+// Construct the camera instance
+GeoluxCamera  camera(Serial1);
+const int32_t serialBaud = 115200;  // Baud rate for serial monitor
+#if GEOLUX_LOG_LEVEL
+GeoluxEventLog eventLog;
+#endif
+
+void setup() {
+    Serial.begin(serialBaud);
+    Serial1.begin(GEOLUX_CAMERA_RS232_BAUD);
+#if GEOLUX_LOG_LEVEL
+    camera.setEventLog(&eventLog);
+#endif
+
+    // the settings every profile keeps
+    camera.setResolution("1280x720");
+    camera.setQuality(70);
+    camera.setJPEGMaximumSize(200);
+    Serial.println(camera.getResolution());
+    Serial.println(camera.getQuality());
+
+#if GEOLUX_ENABLE_INFO
+    camera.printCameraInfo(Serial);
+    GeoluxCamera::geolux_info info;
+    camera.getCameraInfo(info);
+    Serial.println(camera.getDeviceType());
+    Serial.println(camera.getCameraFirmware());
+    Serial.println(camera.getCameraSerialNumber());
+#endif
+#if GEOLUX_ENABLE_OPTICS
+    camera.setAutofocusPoint(50, 50);
+    camera.runAutofocus();
+    camera.waitForReady(5000L);
+    camera.moveZoom(1);
+    camera.moveFocus(-5);
+    Serial.println(camera.getAutofocusX());
+    Serial.println(camera.getAutofocusY());
+    Serial.println(camera.getFocusPosition());
+    Serial.println(camera.getZoomPosition());
+#endif
+#if GEOLUX_ENABLE_COLOR
+    camera.setNightMode(GeoluxCamera::AUTO);
+    camera.setIRLEDMode(GeoluxCamera::IR_AUTO);
+    camera.setAutoexposureRegion(50, 50, 100, 100);
+    camera.setWhiteBalanceOffset(0, 0, 0);
+    camera.setColorCorrectionMode(1);
+    Serial.println(camera.getNightMode());
+    Serial.println(camera.getIRLEDMode());
+    Serial.println(camera.getIRFilterStatus());
+    Serial.println(camera.getAutoexposureX());
+    Serial.println(camera.getExposureTime());
+    Serial.println(camera.getImageBrightness());
+    Serial.println(camera.getWhiteBalanceOffsetRed());
+    Serial.println(camera.getColorCorrectionMode());
+#endif
+}
+
+void loop() {
+    if (camera.takeSnapshot() == GeoluxCamera::OK && camera.waitForReady(500L)) {
+        camera.transferImage(Serial, camera.getImageSize());
+    }
+#if GEOLUX_LOG_LEVEL
+    eventLog.printEvents(Serial);
+    eventLog.clear();
+#endif
+    delay(60000L);
+}
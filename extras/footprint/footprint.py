@@ -0,0 +1,80 @@
+"""
+Build the footprint sketch once for each feature profile and report the flash and RAM
+each one uses.
+
+The feature switches are passed as build flags, so they reach the library sources as
+well as the sketch. Needs PlatformIO; the default board is the EnviroDIY Mayfly
+(ATmega1284P).
+
+Usage: python footprint.py [--board mayfly]
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+LIBRARY = os.path.abspath(os.path.join(HERE, "..", ".."))
+
+CAPTURE_ONLY = [
+    "-DGEOLUX_ENABLE_OPTICS=0",
+    "-DGEOLUX_ENABLE_COLOR=0",
+    "-DGEOLUX_ENABLE_INFO=0",
+]
+
+PROFILES = [
+    ("full", []),
+    ("no optics", ["-DGEOLUX_ENABLE_OPTICS=0"]),
+    ("no color", ["-DGEOLUX_ENABLE_COLOR=0"]),
+    ("no info", ["-DGEOLUX_ENABLE_INFO=0"]),
+    ("capture only", CAPTURE_ONLY),
+    ("capture only, no event log", CAPTURE_ONLY + ["-DGEOLUX_LOG_LEVEL=0"]),
+    ("capture only, debug", CAPTURE_ONLY + ["-DGEOLUX_DEBUG=Serial"]),
+    ("full, log level 3", ["-DGEOLUX_LOG_LEVEL=3"]),
+]
+
+RAM_PATTERN = re.compile(r"RAM:.*\(used (\d+) bytes from (\d+) bytes\)")
+FLASH_PATTERN = re.compile(r"Flash:.*\(used (\d+) bytes from (\d+) bytes\)")
+
+
+def build(board, flags):
+    """Build the sketch and return the flash and RAM used, in bytes."""
+    command = [
+        "pio",
+        "ci",
+        os.path.join(HERE, "footprint.ino"),
+        "--lib",
+        LIBRARY,
+        "--board",
+        board,
+        "--project-option",
+        "build_flags=" + " ".join(flags),
+    ]
+    result = subprocess.run(command, capture_output=True, text=True)
+    ram = RAM_PATTERN.search(result.stdout)
+    flash = FLASH_PATTERN.search(result.stdout)
+    if result.returncode or not ram or not flash:
+        sys.stderr.write(result.stdout + result.stderr)
+        raise RuntimeError("Build failed with flags: " + " ".join(flags))
+    return int(flash.group(1)), int(ram.group(1))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--board", default="mayfly")
+    args = parser.parse_args()
+
+    print("| Profile | Flash | RAM | Flash vs full | RAM vs full |")
+    print("| --- | ---: | ---: | ---: | ---: |")
+    full = None
+    for name, flags in PROFILES:
+        flash, ram = build(args.board, flags)
+        if full is None:
+            full = (flash, ram)
+        print(
+            "| {} | {} | {} | {:+d} | {:+d} |".format(
+                name, flash, ram, flash - full[0], ram - full[1]
+            )
+        )
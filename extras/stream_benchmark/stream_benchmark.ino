@@ -0,0 +1,182 @@
+/** =========================================================================
+ * @example{lineno} stream_benchmark.ino
+ * @author Sara Damiano <sdamiano@stroudcenter.org>
+ * @copyright Stroud Water Research Center
+ * @license This example is published under the BSD-3 license.
+ *
+ * @brief This compares the CPU cycles per image byte read and transferred by a
+ * GeoluxCamera and by a GeoluxCameraT.
+ *
+ * @m_examplenavigation{extra_stream_benchmark,}
+ * ======================================================================= */
+
+// ---------------------------------------------------------------------------
+// Include the base required libraries
+// ---------------------------------------------------------------------------
+#include <Arduino.h>
+#include <GeoluxCamera.h>
+#include <GeoluxCameraT.h>
+
+const int32_t serialBaud  = 115200;  // Baud rate for serial monitor
+const int32_t bench_bytes = 65536;   // The number of bytes to read for each test
+const int32_t chunk_size  = 1024;    // The chunk size for the transfer tests
+
+/**
+ * @brief A stream in memory that always has bytes waiting, standing in for a UART
+ * with a full receive buffer.
+ */
+class PatternStream : public Stream {
+ public:
+    int available() override {
+        return 64;
+    }
+    int read() override {
+        return _next++;
+    }
+    int peek() override {
+        return _next;
+    }
+    size_t write(uint8_t) override {
+        return 1;
+    }
+    using Print::write;
+
+ private:
+    uint8_t _next = 0;
+};
+
+/**
+ * @brief A stream in memory that answers image requests the way the camera does, with
+ * two bytes of junk and then the requested part of a #bench_bytes image.
+ */
+class CameraStream : public Stream {
+ public:
+    int available() override {
+        return _remaining < 64 ? _remaining : 64;
+    }
+    int read() override {
+        if (!_remaining) { return -1; }
+        int b = peek();
+        _remaining--;
+        if (_junk) {
+            _junk--;
+        } else {
+            _offset++;
+        }
+        return b;
+    }
+    int peek() override {
+        if (!_remaining) { return -1; }
+        if (_junk) { return _junk == 2 ? '\r' : '\n'; }
+        // start and end tags around a pattern that never contains 0xFF
+        if (_offset == 0 || _offset == bench_bytes - 2) { return 0xFF; }
+        if (_offset == 1) { return 0xD8; }
+        if (_offset == bench_bytes - 1) { return 0xD9; }
+        return _offset < bench_bytes ? (_offset & 0x7F) : 0;
+    }
+    size_t write(uint8_t c) override {
+        // collect a request up to its line ending: #get_image=<offset>,<length>,RAW
+        if (c != '\n') {
+            if (_request_length < sizeof(_request) - 1) {
+                _request[_request_length++] = c;
+            }
+            return 1;
+        }
+        _request[_request_length] = '\0';
+        _request_length           = 0;
+        char* args                = strchr(_request, '=');
+        if (!args) { return 1; }
+        char* length = nullptr;
+        _offset      = strtol(args + 1, &length, 10);
+        _remaining   = strtol(length + 1, nullptr, 10) + 2;
+        _junk        = 2;
+        return 1;
+    }
+    using Print::write;
+
+ private:
+    char    _request[48];
+    uint8_t _request_length = 0;
+    int32_t _offset         = 0;
+    int32_t _remaining      = 0;
+    uint8_t _junk           = 0;
+};
+
+PatternStream                pattern;
+GeoluxCamera                 generic_camera(pattern);
+GeoluxCameraT<PatternStream> typed_camera(pattern);
+
+CameraStream                simulated;
+GeoluxCamera                generic_sim_camera(simulated);
+GeoluxCameraT<CameraStream> typed_sim_camera(simulated);
+GeoluxImageSink             discard;  // a sink with no output, dropping the image
+
+uint8_t batch[GEOLUX_XFER_BATCH_SIZE];
+
+// readImageData() of a GeoluxCameraT hides the one of GeoluxCamera, so call it on the
+// camera's own class
+template <class CameraT>
+uint32_t timeReads(CameraT& camera) {
+    uint32_t checksum   = 0;
+    int32_t  bytes_read = 0;
+    uint32_t start      = micros();
+    while (bytes_read < bench_bytes) {
+        size_t n = camera.readImageData(batch, sizeof(batch));
+        // touch the data so the reads can't be optimized away
+        checksum += batch[n - 1];
+        bytes_read += n;
+    }
+    uint32_t elapsed = micros() - start;
+    if (checksum == 1) { Serial.print(' '); }
+    return elapsed;
+}
+
+// the whole transfer loop of a GeoluxCameraT is typed, even through a GeoluxCamera&
+uint32_t timeTransfer(GeoluxCamera& camera) {
+    uint32_t start   = micros();
+    uint32_t written = camera.transferImage(discard, bench_bytes, chunk_size);
+    uint32_t elapsed = micros() - start;
+    if (written != static_cast<uint32_t>(bench_bytes)) {
+        Serial.print(F("Only transferred "));
+        Serial.print(written);
+        Serial.print(F(" bytes! "));
+    }
+    return elapsed;
+}
+
+void printResult(const char* name, uint32_t elapsed_us) {
+    Serial.print(name);
+    Serial.print(elapsed_us);
+    Serial.print(F(" us for "));
+    Serial.print(bench_bytes);
+    Serial.print(F(" bytes"));
+#if defined(F_CPU)
+    Serial.print(F(", "));
+    Serial.print(static_cast<float>(elapsed_us) * (F_CPU / 1000000L) / bench_bytes);
+    Serial.print(F(" cycles per byte"));
+#endif
+    Serial.println();
+}
+
+void setup() {
+    Serial.begin(serialBaud);
+    // wait for Arduino Serial Monitor (native USB boards)
+    while (!Serial && (millis() < 10000L)) {}
+
+    Serial.print(F("Reading in batches of "));
+    Serial.print(sizeof(batch));
+    Serial.print(F(" bytes and transferring in chunks of "));
+    Serial.print(chunk_size);
+    Serial.println(F(" bytes"));
+}
+
+void loop() {
+    Serial.println(F("readImageData():"));
+    printResult("GeoluxCamera:                 ", timeReads(generic_camera));
+    printResult("GeoluxCameraT<PatternStream>: ", timeReads(typed_camera));
+    Serial.println(F("transferImage():"));
+    printResult("GeoluxCamera:                 ", timeTransfer(generic_sim_camera));
+    printResult("GeoluxCameraT<CameraStream>:  ", timeTransfer(typed_sim_camera));
+    Serial.println();
+    delay(5000L);
+}
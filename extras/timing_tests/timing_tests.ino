@@ -26,6 +26,9 @@ int16_t adapter_power_pin      = 22;  // power pin for the RS232 adapter
 int16_t seconds_between_images = 5;   // how long to wait between snapshot attempts
 bool    flip                   = 0;
 
+// Construct the latency histograms for the camera
+GeoluxLatencyStats latency_stats;
+
 // SDCARD_SS_PIN is defined for the built-in SD on some boards.
 #ifndef SDCARD_SS_PIN
 const uint8_t SD_CS_PIN = SS;
@@ -112,16 +115,10 @@ uint16_t                    image_number = 1;  // for file naming
 uint32_t                    start_millis = 0;  // for tracking timing
 GeoluxCamera::geolux_status camera_status;     // for the current status
 uint32_t                    wait_time;         // for tracking how long operations take
-uint32_t                    min_boot_time     = 120000;
-uint32_t                    max_boot_time     = 0;
-uint32_t                    min_ready_time    = 120000;
-uint32_t                    max_ready_time    = 0;
-uint32_t                    min_settings_time = 120000;
-uint32_t                    max_settings_time = 0;
-uint32_t                    min_image_time    = 120000;
-uint32_t                    max_image_time    = 0;
-uint32_t                    min_xfer_time     = 120000;
-uint32_t                    max_xfer_time     = 0;
+uint32_t                    min_boot_time = 120000;
+uint32_t                    max_boot_time = 0;
+uint32_t                    min_xfer_time = 120000;
+uint32_t                    max_xfer_time = 0;
 
 void autofocus_camera() {
     Serial.println("Asking camera to autofocus");
@@ -170,6 +167,7 @@ void setup() {
 
     cameraSerial.begin(serialBaud);
     camera.begin(cameraSerial);
+    camera.setLatencyStats(&latency_stats);
     camera.streamDump();  // dump anything in the stream, just in case
 
 
@@ -299,14 +297,6 @@ void loop() {
         delay(30000L);
         return;
     }
-    min_ready_time = min(min_ready_time, wait_time);
-    max_ready_time = max(max_ready_time, wait_time);
-    Serial.print(F("Minimum ready time is "));
-    Serial.print(min_ready_time);
-    Serial.println(F("ms"));
-    Serial.print(F("Maximum ready time is "));
-    Serial.print(max_ready_time);
-    Serial.println(F("ms"));
 
     // Reset resolution
     start_millis = millis();
@@ -322,14 +312,6 @@ void loop() {
     } else {
         Serial.print("Camera timed out!");
     }
-    min_settings_time = min(min_settings_time, wait_time);
-    max_settings_time = max(max_settings_time, wait_time);
-    Serial.print(F("Minimum setting change time is "));
-    Serial.print(min_settings_time);
-    Serial.println(F("ms"));
-    Serial.print(F("Maximum setting change time is "));
-    Serial.print(max_settings_time);
-    Serial.println(F("ms"));
 
     // dump anything in the camera stream, just in case
     while (cameraSerial.available()) { cameraSerial.read(); }
@@ -412,14 +394,6 @@ void loop() {
         delay(30000L);
         return;
     }
-    min_image_time = min(min_image_time, snapshot_time);
-    max_image_time = max(max_image_time, snapshot_time);
-    Serial.print("Minimum imaging time ");
-    Serial.print(min_image_time);
-    Serial.println(" milliseconds.");
-    Serial.print("Maximum imaging time ");
-    Serial.print(max_image_time);
-    Serial.println(" milliseconds.");
 
     int32_t image_size = camera.getImageSize();
     Serial.print("Completed image is ");
@@ -457,6 +431,9 @@ void loop() {
     Serial.print(max_xfer_time);
     Serial.println(" milliseconds.");
 
+    Serial.println("Camera command and wait latencies:");
+    latency_stats.printStats(Serial);
+
     image_number++;
     flip = !flip;
     Serial.print(F("Wait "));
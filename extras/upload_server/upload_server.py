@@ -0,0 +1,61 @@
+"""
+A minimal HTTP server for testing GeoluxUploadSink on a local network or loopback.
+
+It accepts multipart/form-data POSTs on any path, checks that the body matches the
+Content-Length the sink declared, saves each uploaded file into the output directory
+and answers 201 Created.
+
+Usage: python upload_server.py [--host 0.0.0.0] [--port 8080] [--out uploads]
+"""
+
+import argparse
+import email.parser
+import email.policy
+import http.server
+import os
+
+
+class UploadHandler(http.server.BaseHTTPRequestHandler):
+    out_dir = "uploads"
+
+    def do_POST(self):
+        length = int(self.headers.get("Content-Length", 0))
+        body = self.rfile.read(length)
+        if len(body) != length:
+            self.send_error(400, "Body shorter than Content-Length")
+            return
+        message = email.parser.BytesParser(policy=email.policy.HTTP).parsebytes(
+            b"Content-Type: "
+            + self.headers.get("Content-Type", "").encode()
+            + b"\r\n\r\n"
+            + body
+        )
+        saved = 0
+        for part in message.iter_parts():
+            filename = part.get_filename()
+            if not filename:
+                continue
+            data = part.get_payload(decode=True)
+            path = os.path.join(self.out_dir, os.path.basename(filename))
+            with open(path, "wb") as f:
+                f.write(data)
+            print(f"Saved {len(data)} bytes to {path}")
+            saved += 1
+        if not saved:
+            self.send_error(400, "No file in request")
+            return
+        self.send_response(201)
+        self.send_header("Content-Length", "0")
+        self.end_headers()
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--out", default="uploads")
+    args = parser.parse_args()
+    os.makedirs(args.out, exist_ok=True)
+    UploadHandler.out_dir = args.out
+    print(f"Listening on {args.host}:{args.port}, saving to {args.out}", flush=True)
+    http.server.HTTPServer((args.host, args.port), UploadHandler).serve_forever()
@@ -0,0 +1,245 @@
+/**
+ * @file       GeoluxArchive.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Contains an image sink that appends images to a single indexed archive file.
+ */
+
+#ifndef SRC_GEOLUXARCHIVE_H_
+#define SRC_GEOLUXARCHIVE_H_
+
+#include <Arduino.h>
+#include "GeoluxImageSink.h"
+
+/**
+ * @def GEOLUX_ARCHIVE_MAX_RECORDS
+ * @brief The maximum number of images in one archive file.
+ *
+ * The index is kept in RAM until the archive is finished, at 12 bytes per image.
+ */
+#ifndef GEOLUX_ARCHIVE_MAX_RECORDS
+#if defined(__AVR__)
+#define GEOLUX_ARCHIVE_MAX_RECORDS 16
+#else
+#define GEOLUX_ARCHIVE_MAX_RECORDS 256
+#endif
+#endif
+
+/**
+ * @brief An image sink that appends each image to one archive file, so a deployment
+ * does not create a new file - and grow the directory - for every capture.
+ *
+ * The file type is a template parameter so the library does not depend on SdFat, but
+ * the archive needs SdFat's preAllocate(), position(), seek(), truncate() and sync().
+ * It works with the SdFat File, File32, ExFile and FsFile classes.
+ *
+ * Open a new, empty file and call begin() with the size to preallocate. The clusters
+ * are allocated contiguously up front, so writing an image never has to search the
+ * FAT and the time to store an image stays the same however many have been taken.
+ * Transfer images to the sink as usual. When isFull() or on your own schedule, call
+ * finish() to write the index, trim the unused preallocated space and close the file,
+ * then start a new archive.
+ *
+ * The archive format, with all integers little-endian:
+ * - header: "GLXA", a version byte (1) and three reserved bytes
+ * - per image: the image length (uint32), the time stamp given with setTimestamp()
+ * (uint32), then the image bytes
+ * - end marker: a zero image length (uint32) after the last record, overwritten by
+ * the next record or the index
+ * - index, written by finish(): "GLXI", the image count (uint32), then for each image
+ * its record offset, image length and time stamp (3 x uint32)
+ * - trailer: the offset of the index (uint32) and "GLXE"
+ *
+ * If the archive is never finished, the images can still be recovered by walking the
+ * records from the header until a zero image length. Preallocated space isn't cleared
+ * and can hold old data from the card, so the end marker is written after every
+ * image, and the length of an image is only filled in once it is complete, from the
+ * number of bytes that reached the file. An image that was interrupted keeps a zero
+ * length and ends the walk.
+ *
+ * @tparam FileT The SdFat file class
+ */
+template <class FileT>
+class GeoluxArchiveSink : public GeoluxImageSink {
+
+ public:
+    /**
+     * @brief Construct a new GeoluxArchiveSink object
+     *
+     * @param file The file to write the archive to; it must already be open for
+     * writing
+     */
+    explicit GeoluxArchiveSink(FileT* file) : GeoluxImageSink(file), _file(file) {}
+    /** @copydoc GeoluxArchiveSink::GeoluxArchiveSink(FileT* file) */
+    explicit GeoluxArchiveSink(FileT& file) : GeoluxImageSink(file), _file(&file) {}
+
+    /**
+     * @brief Start a new archive in the attached file.
+     *
+     * @param preallocate_size The number of bytes to preallocate; 0 to allocate as the
+     * archive grows. The file must be empty to preallocate.
+     * @return True if the archive was started, otherwise false
+     */
+    bool begin(uint32_t preallocate_size = 0) {
+        _record_count = 0;
+        _started      = false;
+        if (preallocate_size && !_file->preAllocate(preallocate_size)) { return false; }
+        static const uint8_t header[8] = {'G', 'L', 'X', 'A', 1, 0, 0, 0};
+        if (_file->write(header, sizeof(header)) != sizeof(header)) { return false; }
+        if (!writeEndMarker()) { return false; }
+        _started = true;
+        return true;
+    }
+    /**
+     * @brief Attach a new file and start a new archive in it.
+     *
+     * @param file The file to write the archive to; it must already be open for
+     * writing
+     * @param preallocate_size The number of bytes to preallocate; 0 to allocate as the
+     * archive grows.
+     * @return True if the archive was started, otherwise false
+     */
+    bool begin(FileT* file, uint32_t preallocate_size = 0) {
+        _file = file;
+        setOutput(file);
+        return begin(preallocate_size);
+    }
+    /** @copydoc GeoluxArchiveSink::begin(FileT* file, uint32_t preallocate_size) */
+    bool begin(FileT& file, uint32_t preallocate_size = 0) {
+        return begin(&file, preallocate_size);
+    }
+
+    /**
+     * @brief Set the time stamp stored with the next image.
+     *
+     * @param timestamp The time stamp, in whatever form suits the deployment (for
+     * example seconds since the Unix epoch)
+     */
+    void setTimestamp(uint32_t timestamp) {
+        _timestamp = timestamp;
+    }
+
+    /**
+     * @brief Write the index and trailer, trim the unused preallocated space and sync
+     * the file.
+     *
+     * The caller closes the file afterwards and may begin a new archive.
+     *
+     * @return True if the archive was finished successfully, otherwise false
+     */
+    bool finish() {
+        if (!_started) { return false; }
+        _started              = false;
+        uint32_t index_offset = static_cast<uint32_t>(_file->position());
+        static const uint8_t index_tag[4]   = {'G', 'L', 'X', 'I'};
+        static const uint8_t trailer_tag[4] = {'G', 'L', 'X', 'E'};
+        bool                 success        = _file->write(index_tag, 4) == 4;
+        success &= writeU32(_record_count);
+        for (uint16_t i = 0; i < _record_count; i++) {
+            success &= writeU32(_records[i].offset);
+            success &= writeU32(_records[i].length);
+            success &= writeU32(_records[i].timestamp);
+        }
+        success &= writeU32(index_offset);
+        success &= _file->write(trailer_tag, 4) == 4;
+        success &= _file->truncate(_file->position());
+        success &= _file->sync();
+        return success;
+    }
+
+    /**
+     * @brief Check whether the archive has room for another image in its index.
+     *
+     * @return True if the archive is full and should be finished
+     */
+    bool isFull() {
+        return _record_count >= GEOLUX_ARCHIVE_MAX_RECORDS;
+    }
+    /**
+     * @brief Get the number of images in the archive.
+     *
+     * @return The number of images
+     */
+    uint16_t getRecordCount() {
+        return _record_count;
+    }
+
+    bool beginImage(int32_t image_size) override {
+        if (!_started || isFull()) { return false; }
+        _record_start = static_cast<uint32_t>(_file->position());
+        // the length stays zero, ending the walk of the archive, until the image is
+        // complete
+        if (!writeU32(0) || !writeU32(_timestamp)) { return false; }
+        return GeoluxImageSink::beginImage(image_size);
+    }
+
+    bool endImage(uint32_t bytes_written) override {
+        if (!_started) { return false; }
+        // use the length that actually reached the file, not the count from the
+        // transfer, or a short write would misalign every later record
+        uint32_t record_end = static_cast<uint32_t>(_file->position());
+        uint32_t length     = record_end - _record_start - 8;
+        if (!length) {
+            // drop the empty record; its zero length is the end marker
+            _file->seek(_record_start);
+            return false;
+        }
+        // mark the new end of the archive before the record is made walkable
+        if (!writeEndMarker()) { return false; }
+        _file->seek(_record_start);
+        bool success = writeU32(length);
+        _file->seek(record_end);
+        if (!success) { return false; }
+        _records[_record_count].offset    = _record_start;
+        _records[_record_count].length    = length;
+        _records[_record_count].timestamp = _timestamp;
+        _record_count++;
+        return GeoluxImageSink::endImage(length);
+    }
+
+ protected:
+    /**
+     * @brief Write a little-endian 32-bit value to the file.
+     *
+     * @param value The value to write
+     * @return True if all 4 bytes were written
+     */
+    bool writeU32(uint32_t value) {
+        uint8_t bytes[4] = {static_cast<uint8_t>(value),
+                            static_cast<uint8_t>(value >> 8),
+                            static_cast<uint8_t>(value >> 16),
+                            static_cast<uint8_t>(value >> 24)};
+        return _file->write(bytes, 4) == 4;
+    }
+    /**
+     * @brief Write the zero length that ends the records at the current position,
+     * leaving the position in front of it to be overwritten.
+     *
+     * @return True if the marker was written
+     */
+    bool writeEndMarker() {
+        uint32_t position = static_cast<uint32_t>(_file->position());
+        bool     success  = writeU32(0);
+        _file->seek(position);
+        return success;
+    }
+
+    /// @brief An entry in the archive index
+    typedef struct {
+        uint32_t offset;     ///< The offset of the record from the start of the file
+        uint32_t length;     ///< The length of the image
+        uint32_t timestamp;  ///< The time stamp of the image
+    } archive_record;
+
+    FileT*   _file;                   ///< The archive file
+    bool     _started       = false;  ///< True between begin() and finish()
+    uint16_t _record_count  = 0;      ///< The number of images in the archive
+    uint32_t _record_start  = 0;      ///< The offset of the current record
+    uint32_t _timestamp     = 0;      ///< The time stamp for the next image
+    /// The archive index
+    archive_record _records[GEOLUX_ARCHIVE_MAX_RECORDS];
+};
+
+#endif  // SRC_GEOLUXARCHIVE_H_
@@ -0,0 +1,122 @@
+/**
+ * @file       GeoluxBase64.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#include "GeoluxBase64.h"
+
+#if defined(__AVR__)
+static const char base64_table[64] PROGMEM = {
+#else
+static const char base64_table[64] = {
+#endif
+    'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
+    'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
+    'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
+    'w', 'x', 'y', 'z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '+', '/'};
+
+/**
+ * @brief Look up the character for a 6-bit value.
+ *
+ * @param value The value; only the low 6 bits are used
+ * @return The base64 character
+ */
+static inline char base64Char(uint32_t value) {
+#if defined(__AVR__)
+    return static_cast<char>(pgm_read_byte(&base64_table[value & 0x3F]));
+#else
+    return base64_table[value & 0x3F];
+#endif
+}
+
+GeoluxBase64Sink::GeoluxBase64Sink() : GeoluxImageSink() {}
+GeoluxBase64Sink::GeoluxBase64Sink(Print* output) : GeoluxImageSink(output) {}
+GeoluxBase64Sink::GeoluxBase64Sink(Print& output) : GeoluxImageSink(output) {}
+GeoluxBase64Sink::GeoluxBase64Sink(GeoluxImageSink* output)
+    : GeoluxImageSink(output) {}
+GeoluxBase64Sink::GeoluxBase64Sink(GeoluxImageSink& output)
+    : GeoluxImageSink(output) {}
+
+void GeoluxBase64Sink::setLineLength(uint8_t line_length) {
+    _line_length = line_length;
+}
+
+uint32_t GeoluxBase64Sink::getEncodedLength(uint32_t size, uint8_t line_length) {
+    uint32_t chars = (size + 2) / 3 * 4;
+    if (!line_length || !chars) { return chars; }
+    return chars + (chars - 1) / line_length * 2;
+}
+
+bool GeoluxBase64Sink::beginImage(int32_t image_size) {
+    _group         = 0;
+    _group_bytes   = 0;
+    _line_chars    = 0;
+    _buffered      = 0;
+    _encoded_bytes = 0;
+    _failed        = false;
+    if (image_size > 0) {
+        image_size = static_cast<int32_t>(
+            getEncodedLength(static_cast<uint32_t>(image_size), _line_length));
+    }
+    return GeoluxImageSink::beginImage(image_size);
+}
+
+bool GeoluxBase64Sink::endImage(uint32_t) {
+    // pad out the last group, then send everything left
+    if (_group_bytes) { encodeGroup(_group_bytes); }
+    writeBuffer();
+    return GeoluxImageSink::endImage(_encoded_bytes) && !_failed;
+}
+
+size_t GeoluxBase64Sink::write(const uint8_t* buffer, size_t size) {
+    if (_failed || !_output) { return 0; }
+    for (size_t i = 0; i < size; i++) {
+        // collect three bytes into one word, then split it into four characters
+        _group = (_group << 8) | buffer[i];
+        if (++_group_bytes == 3) { encodeGroup(3); }
+    }
+    return _failed ? 0 : size;
+}
+
+void GeoluxBase64Sink::flush() {
+    // a partial group can't be encoded until the image ends, so only the complete
+    // characters are sent
+    writeBuffer();
+    if (_output) { _output->flush(); }
+}
+
+void GeoluxBase64Sink::encodeGroup(uint8_t count) {
+    uint32_t group = _group << (8 * (3 - count));
+    putChar(base64Char(group >> 18));
+    putChar(base64Char(group >> 12));
+    putChar(count > 1 ? base64Char(group >> 6) : '=');
+    putChar(count > 2 ? base64Char(group) : '=');
+    _group       = 0;
+    _group_bytes = 0;
+}
+
+void GeoluxBase64Sink::putChar(char c) {
+    if (_line_length && _line_chars == _line_length) {
+        bufferChar('\r');
+        bufferChar('\n');
+        _line_chars = 0;
+    }
+    bufferChar(c);
+    _line_chars++;
+}
+
+void GeoluxBase64Sink::bufferChar(char c) {
+    if (_buffered == GEOLUX_BASE64_BUFFER_SIZE) { writeBuffer(); }
+    _buffer[_buffered++] = c;
+}
+
+void GeoluxBase64Sink::writeBuffer() {
+    if (!_buffered || _failed || !_output) { return; }
+    size_t written = _output->write(reinterpret_cast<const uint8_t*>(_buffer),
+                                    _buffered);
+    _encoded_bytes += written;
+    _failed   = written != _buffered;
+    _buffered = 0;
+}
@@ -0,0 +1,125 @@
+/**
+ * @file       GeoluxBase64.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Contains an image sink that base64 encodes the image as it is transferred.
+ */
+
+#ifndef SRC_GEOLUXBASE64_H_
+#define SRC_GEOLUXBASE64_H_
+
+#include <Arduino.h>
+#include "GeoluxImageSink.h"
+
+/**
+ * @def GEOLUX_BASE64_BUFFER_SIZE
+ * @brief The number of encoded characters collected before they are written on.
+ */
+#ifndef GEOLUX_BASE64_BUFFER_SIZE
+#define GEOLUX_BASE64_BUFFER_SIZE 64
+#endif
+
+/**
+ * @brief An image sink that base64 encodes the image (RFC 4648, with padding) and
+ * writes the text on to another output, for transports that only carry text - like
+ * MQTT publishes through modem AT commands or JSON bodies.
+ *
+ * Only the last incomplete group of up to two bytes is held between writes, so the
+ * image never needs to fit in RAM. The encoded text is collected in a small buffer
+ * and written on in blocks.
+ *
+ * The image sizes passed on to a following image sink are the encoded lengths, so,
+ * for example, a GeoluxUploadSink after this one declares the right Content-Length.
+ */
+class GeoluxBase64Sink : public GeoluxImageSink {
+
+ public:
+    /**
+     * @brief Construct a new GeoluxBase64Sink object with no output attached
+     */
+    GeoluxBase64Sink();
+    /**
+     * @brief Construct a new GeoluxBase64Sink object that writes on to another Print
+     *
+     * @param output The output to write the encoded text to
+     */
+    explicit GeoluxBase64Sink(Print* output);
+    /** @copydoc GeoluxBase64Sink::GeoluxBase64Sink(Print* output) */
+    explicit GeoluxBase64Sink(Print& output);
+    /**
+     * @brief Construct a new GeoluxBase64Sink object that writes on to another image
+     * sink
+     *
+     * @param output The image sink to write the encoded text to
+     */
+    explicit GeoluxBase64Sink(GeoluxImageSink* output);
+    /** @copydoc GeoluxBase64Sink::GeoluxBase64Sink(GeoluxImageSink* output) */
+    explicit GeoluxBase64Sink(GeoluxImageSink& output);
+
+    /**
+     * @brief Set the number of characters per line of encoded text.
+     *
+     * Lines are separated by "\r\n", as used by MIME (76 characters) and PEM (64
+     * characters). There is no line break after the last line.
+     *
+     * @param line_length The number of characters per line; 0 (the default) for no
+     * line breaks. Should be a multiple of 4.
+     */
+    void setLineLength(uint8_t line_length);
+
+    /**
+     * @brief Get the length of the encoded text for data of a given size.
+     *
+     * @param size The size of the data to encode
+     * @param line_length The number of characters per line, or 0 for no line breaks
+     * @return The length of the encoded text, including any line breaks
+     */
+    static uint32_t getEncodedLength(uint32_t size, uint8_t line_length = 0);
+
+    bool beginImage(int32_t image_size) override;
+    bool endImage(uint32_t bytes_written) override;
+
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using GeoluxImageSink::write;
+    void flush() override;
+
+ protected:
+    /**
+     * @brief Encode the held group of bytes into four characters.
+     *
+     * @param count The number of bytes in the group; less than 3 only at the end, when
+     * the missing characters are padded with '='
+     */
+    void encodeGroup(uint8_t count);
+    /**
+     * @brief Add one encoded character to the buffer, breaking the line if needed.
+     *
+     * @param c The character to add
+     */
+    void putChar(char c);
+    /**
+     * @brief Add one character to the buffer, writing the buffer out first if it is
+     * full.
+     *
+     * @param c The character to add
+     */
+    void bufferChar(char c);
+    /**
+     * @brief Write out whatever is in the buffer.
+     */
+    void writeBuffer();
+
+    uint32_t _group         = 0;      ///< The bytes of the group being collected
+    uint8_t  _group_bytes   = 0;      ///< The number of bytes in the group
+    uint8_t  _line_length   = 0;      ///< The characters per line, or 0
+    uint8_t  _line_chars    = 0;      ///< The characters on the current line
+    uint8_t  _buffered      = 0;      ///< The number of characters in the buffer
+    uint32_t _encoded_bytes = 0;      ///< The characters written for this image
+    bool     _failed        = false;  ///< True if a write to the output failed
+    /// The buffer of encoded text
+    char _buffer[GEOLUX_BASE64_BUFFER_SIZE];
+};
+
+#endif  // SRC_GEOLUXBASE64_H_
@@ -6,6 +6,66 @@
  */
 
 #include "GeoluxCamera.h"
+#include "GeoluxDigest.h"
+
+// the bits of geolux_settings::set for each setting to re-apply after a reset
+static const uint16_t SETTING_RESOLUTION    = 0x0001;
+static const uint16_t SETTING_QUALITY       = 0x0002;
+static const uint16_t SETTING_JPEG_MAX_SIZE = 0x0004;
+static const uint16_t SETTING_IR_LED_MODE   = 0x0008;
+static const uint16_t SETTING_AUTOFOCUS     = 0x0010;
+static const uint16_t SETTING_AUTOEXPOSURE  = 0x0020;
+static const uint16_t SETTING_WB_OFFSET     = 0x0040;
+static const uint16_t SETTING_COLOR_MODE    = 0x0080;
+static const uint16_t SETTING_AUTO_INTERVAL = 0x0100;
+static const uint16_t SETTING_NIGHT_MODE    = 0x0200;
+// the number of steps taken by sendSetting()
+static const uint8_t SETTING_STEPS = 10;
+
+// room for the longest \#get_info tag and its terminating null
+static const size_t GEOLUX_TAG_BUFFER = sizeof(GEOLUX_TAG_AUTO_SNAPSHOT_INTERVAL);
+
+/**
+ * @brief Copy a \#get_info tag into a string in RAM, where the stream can search for
+ * it.
+ *
+ * @param dest The string to copy to
+ * @param size The size of the destination, including the terminating null
+ * @param tag The tag to copy
+ */
+static inline void copyTag(char* dest, size_t size, const char* tag) {
+    strncpy(dest, tag, size - 1);
+    dest[size - 1] = '\0';
+}
+/** @copydoc copyTag(char* dest, size_t size, const char* tag) */
+static inline void copyTag(char* dest, size_t size, const __FlashStringHelper* tag) {
+    strncpy_P(dest, reinterpret_cast<const char*>(tag), size - 1);
+    dest[size - 1] = '\0';
+}
+
+/**
+ * @brief Write a number as decimal text, as Print::print() would.
+ *
+ * @param dest The string to write to; room for at least 11 characters
+ * @param value The number to write
+ * @return The number of characters written, without a terminating null
+ */
+static size_t formatNumber(char* dest, int32_t value) {
+    char     digits[10];
+    size_t   count     = 0;
+    size_t   length    = 0;
+    uint32_t magnitude = static_cast<uint32_t>(value);
+    if (value < 0) {
+        dest[length++] = '-';
+        magnitude      = 0u - magnitude;
+    }
+    do {
+        digits[count++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    while (count) { dest[length++] = digits[--count]; }
+    return length;
+}
 
 GeoluxCamera::GeoluxCamera() {}
 GeoluxCamera::GeoluxCamera(Stream* stream) {
@@ -14,6 +74,14 @@ GeoluxCamera::GeoluxCamera(Stream* stream) {
 GeoluxCamera::GeoluxCamera(Stream& stream) {
     _stream = &stream;
 }
+GeoluxCamera::GeoluxCamera(Stream* stream, const GeoluxTimeouts& timeouts)
+    : _timeouts(timeouts) {
+    _stream = stream;
+}
+GeoluxCamera::GeoluxCamera(Stream& stream, const GeoluxTimeouts& timeouts)
+    : _timeouts(timeouts) {
+    _stream = &stream;
+}
 GeoluxCamera::~GeoluxCamera() {}
 
 void GeoluxCamera::begin() {}
@@ -34,36 +102,48 @@ void GeoluxCamera::begin(HardwareSerial& stream) {
 
 
 GeoluxCamera::geolux_status GeoluxCamera::takeSnapshot() {
-    sendCommand(GF("take_snapshot"));
-    return static_cast<geolux_status>(waitResponse());
+    if (_rebooted && _auto_recover) { recoverFromReboot(); }
+    sendCommand(GFP(GEOLUX_CMD_TAKE_SNAPSHOT));
+    return static_cast<geolux_status>(
+        waitCommandResponse(GeoluxLatencyStats::CMD_TAKE_SNAPSHOT));
 }
 
 GeoluxCamera::geolux_status GeoluxCamera::getStatus() {
-    sendCommand(GF("get_status"));
+    sendCommand(GFP(GEOLUX_CMD_GET_STATUS));
     // this returns "READY" instead of "OK" and has no new line
     geolux_status resp = static_cast<geolux_status>(
         waitResponse(GF("READY"), GF("ERR"), GF("BUSY"), GF("NONE")));
+    if (resp == NO_RESPONSE) { return resp; }
     streamFind('\n');  // skip to the end of the line - ignore the returned image size
+    if (resp && resp != REBOOTED) {
+        recordCommand(GeoluxLatencyStats::CMD_GET_STATUS);
+    }
     return resp;
 }
 
 int32_t GeoluxCamera::getImageSize() {
     // The image size is returned as part of the status response
-    sendCommand(GF("get_status"));
+    sendCommand(GFP(GEOLUX_CMD_GET_STATUS));
     // this returns "READY" instead of "OK" and has no new line
-    waitResponse(GF("READY"), GF("ERR"), GF("BUSY"), GF("NONE"));
+    int8_t status = waitResponse(GF("READY"), GF("ERR"), GF("BUSY"), GF("NONE"));
+    if (!status) { return 0; }
+    if (status == REBOOTED) {
+        // the snapshot is gone, don't wait for a size that isn't coming
+        streamFind('\n');
+        return 0;
+    }
     streamFind(',');  // skip the comma
     uint32_t resp = _stream->parseInt();
     streamFind('\n');  // skip to the end of the line
+    if (status) { recordCommand(GeoluxLatencyStats::CMD_GET_STATUS); }
     return static_cast<int32_t>(resp);
 }
 
 uint32_t GeoluxCamera::getImageChunk(uint8_t* buf, size_t offset, size_t length) {
     streamDump();
     uint32_t start_time = millis();
-    sendCommand(GF("get_image"), '=', offset, ',', length, ',', GF("RAW"));
-    while (_stream->available() < 3 && millis() - start_time < 5000L);
-    if (!_stream->available()) {
+    sendCommand(GFP(GEOLUX_CMD_GET_IMAGE), '=', offset, ',', length, ',', GF("RAW"));
+    if (!waitForData(start_time, _timeouts.response, 3)) {
         DBG_GLX("No response!");
         return 0;
     }
@@ -77,10 +157,11 @@ uint32_t GeoluxCamera::getImageChunk(uint8_t* buf, size_t offset, size_t length)
     }
     // shorten the stream timeout so we're not waiting forever for a partial chunk
     uint32_t prev_timeout = _stream->getTimeout();
-    _stream->setTimeout(15L);
+    _stream->setTimeout(_timeouts.stream);
     uint32_t bytes_read = _stream->readBytes(buf, length);
     // reset the stream timeout
     _stream->setTimeout(prev_timeout);
+    recordCommand(GeoluxLatencyStats::CMD_GET_IMAGE);
     if (bytes_read != length) {
         DBG_GLX(GF("Unexpected byte count: expected:"), length, GF("read:"),
                 bytes_read);
@@ -88,6 +169,39 @@ uint32_t GeoluxCamera::getImageChunk(uint8_t* buf, size_t offset, size_t length)
     return bytes_read;
 }
 
+void GeoluxCamera::requestImageChunk(size_t offset, size_t length) {
+    requestImageChunkFrom(_stream, offset, length);
+}
+
+size_t GeoluxCamera::readImageData(uint8_t* buf, size_t max_length) {
+    return readImageDataFrom(_stream, buf, max_length);
+}
+
+size_t GeoluxCamera::formatChunkRequest(char* buf, int32_t offset, int32_t length) {
+    size_t request_length = 0;
+    buf[request_length++] = '#';
+    copyTag(buf + request_length, GEOLUX_CHUNK_REQUEST_SIZE - request_length,
+            GFP(GEOLUX_CMD_GET_IMAGE));
+    request_length += strlen(buf + request_length);
+    buf[request_length++] = '=';
+    request_length += formatNumber(buf + request_length, offset);
+    buf[request_length++] = ',';
+    request_length += formatNumber(buf + request_length, length);
+    memcpy(buf + request_length, ",RAW\r\n", 6);
+    return request_length + 6;
+}
+
+bool GeoluxCamera::checkForBanner(const uint8_t* buf, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (matchBanner(buf[i])) {
+            noteReboot();
+            GEOLUX_LOG_ERROR(_event_log, GeoluxEventLog::EVT_REBOOT, i + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
 uint32_t GeoluxCamera::transferImage(Stream* xferStream, int32_t image_size,
                                      int32_t chunk_size) {
     // get the full image size, if not given
@@ -100,413 +214,906 @@ uint32_t GeoluxCamera::transferImage(Stream* xferStream, int32_t image_size,
         DBG_GLX(GF("Camera reports 0-byte image! Aborting transfer."));
         return 0;
     }
+    return transferImageData(xferStream, image_size, chunk_size);
+}
 
-    // bool got_start_tag        = false;
-    // bool got_end_tag          = false;
-    // bool got_matching_bytes   = false;
-    // bool hit_zeros            = false;
-    // bool all_chunks_succeeded = true;
-
-    uint32_t max_command_response = 0;
-    uint32_t max_char_spacing     = 0;
-
-    // Read all the data up to # bytes!
-    int32_t total_bytes_read    = 0;  // for the number of bytes read
-    int32_t total_bytes_written = 0;  // for the number of bytes written
-    int32_t start_data_byte =
-        2;  // the first two bytes are header and don't belong in the file
-    int32_t extra_read_buff =
-        12;  // extra chars to read to ensure we get the closing tag
-    int32_t bytes_remaining  = image_size + start_data_byte + extra_read_buff;
-    int32_t chunk_number     = 0;
-    int32_t start_next_chunk = 0;
-    // int32_t chunks_needed    = ceil(image_size / chunk_size);
-    ;
-    uint8_t prev_bytes[4] = {0, 0, 0, 0};
-    bool    eof           = false;
-
-    uint32_t start_xfer_millis = millis();
-
-    while (!eof && millis() - start_xfer_millis < 120000L) {
-        int32_t bytesToRead =
-            min(chunk_size,
-                static_cast<int32_t>(max(bytes_remaining, static_cast<int32_t>(1))));
-        int32_t bytes_read    = 0;
-        int32_t bytes_written = 0;
-
-        uint32_t start_command_millis = millis();
-        sendCommand(GF("get_image"), '=', start_next_chunk, ',', bytesToRead, ',',
-                    GF("RAW"));
-        while (!_stream->available() &&
-               millis() - start_command_millis < 5000L);  // wait for any characters
-        if (!_stream->available()) {
-            DBG_GLX("\nNo response!");
-            continue;
-        }
-        max_command_response =
-            max(max_command_response,
-                static_cast<uint32_t>(millis() - start_command_millis));
-#ifdef GEOLUX_DEBUG
-        // print something to show we're not frozen
-        GEOLUX_DEBUG.print('.');
-#endif
+uint32_t GeoluxCamera::transferImage(Stream& xferStream, int32_t image_size,
+                                     int32_t chunk_size) {
+    return transferImage(&xferStream, image_size, chunk_size);
+}
+
+uint32_t GeoluxCamera::transferImage(GeoluxImageSink* sink, int32_t image_size,
+                                     int32_t chunk_size) {
+    if (image_size == 0) { image_size = getImageSize(); }
+    if (image_size == 0) {
+        DBG_GLX(GF("Camera reports 0-byte image! Aborting transfer."));
+        return 0;
+    }
+    if (!sink->beginImage(image_size)) {
+        DBG_GLX(GF("Image sink refused the image! Aborting transfer."));
+        return 0;
+    }
+    uint32_t bytes_written = transferImageData(sink, image_size, chunk_size);
+    sink->flush();
+    if (!sink->endImage(bytes_written)) {
+        DBG_GLX(GF("Image sink failed to finish the image!"));
+    }
+    return bytes_written;
+}
+
+uint32_t GeoluxCamera::transferImage(GeoluxImageSink& sink, int32_t image_size,
+                                     int32_t chunk_size) {
+    return transferImage(&sink, image_size, chunk_size);
+}
+
+uint32_t GeoluxCamera::transferNewImage(GeoluxImageSink* sink, uint8_t* buf,
+                                        size_t prefix_length, int32_t image_size,
+                                        int32_t chunk_size) {
+    _last_was_duplicate = false;
+    if (image_size == 0) { image_size = getImageSize(); }
+    if (image_size == 0) {
+        DBG_GLX(GF("Camera reports 0-byte image! Aborting transfer."));
+        return 0;
+    }
+    prefix_length = min(prefix_length, static_cast<size_t>(image_size));
+    prefix_length = min(prefix_length, static_cast<size_t>(UINT16_MAX));
+
+    uint32_t    prefix_read = getImageChunk(buf, 0, prefix_length);
+    GeoluxCRC32 crc;
+    crc.update(buf, prefix_read);
+    geolux_fingerprint fingerprint = {image_size, crc.getValue(),
+                                      static_cast<uint16_t>(prefix_read)};
+    if (prefix_read == prefix_length &&
+        fingerprint.image_size == _last_fingerprint.image_size &&
+        fingerprint.prefix_crc == _last_fingerprint.prefix_crc &&
+        fingerprint.prefix_length == _last_fingerprint.prefix_length) {
+        DBG_GLX(GF("Image matches the last image; skipping transfer."));
+        _last_was_duplicate = true;
+        return 0;
+    }
+
+    // the camera won't re-send the start of the image, so write out what was read
+    // for the comparison and continue the transfer from there
+    uint32_t bytes_written = resumeTransfer(sink, buf, prefix_read, image_size,
+                                            chunk_size);
+    // only remember a complete image, so a failed one isn't skipped as a repeat when
+    // the same snapshot is tried again
+    if (bytes_written >= static_cast<uint32_t>(image_size)) {
+        _last_fingerprint = fingerprint;
+    }
+    return bytes_written;
+}
+
+uint32_t GeoluxCamera::transferNewImage(GeoluxImageSink& sink, uint8_t* buf,
+                                        size_t prefix_length, int32_t image_size,
+                                        int32_t chunk_size) {
+    return transferNewImage(&sink, buf, prefix_length, image_size, chunk_size);
+}
+
+uint32_t GeoluxCamera::inspectImage(uint8_t* buf, size_t length,
+                                    GeoluxJpeg::geolux_jpeg_header* header) {
+    uint32_t bytes_read = getImageChunk(buf, 0, length);
+    if (!GeoluxJpeg::parseHeader(buf, bytes_read, header)) {
+        DBG_GLX(GF("No JPEG frame header in the first"), bytes_read, GF("bytes"));
+    }
+    return bytes_read;
+}
+
+uint32_t GeoluxCamera::inspectImage(uint8_t* buf, size_t length,
+                                    GeoluxJpeg::geolux_jpeg_header& header) {
+    return inspectImage(buf, length, &header);
+}
+
+uint32_t GeoluxCamera::resumeTransfer(GeoluxImageSink* sink, const uint8_t* prefix,
+                                      size_t prefix_length, int32_t image_size,
+                                      int32_t chunk_size) {
+    if (image_size == 0) { image_size = getImageSize(); }
+    if (image_size == 0) {
+        DBG_GLX(GF("Camera reports 0-byte image! Aborting transfer."));
+        return 0;
+    }
+    // anything read past the end of the image is padding
+    prefix_length = min(prefix_length, static_cast<size_t>(image_size));
+    if (!sink->beginImage(image_size)) {
+        DBG_GLX(GF("Image sink refused the image! Aborting transfer."));
+        return 0;
+    }
+    uint32_t bytes_written = sink->write(prefix, prefix_length);
+    if (bytes_written < prefix_length) {
+        // the camera can't re-send the bytes the sink didn't take
+        DBG_GLX(GF("Image sink only took"), bytes_written, GF("of"), prefix_length,
+                GF("bytes of the start of the image! Aborting transfer."));
+    } else if (bytes_written < static_cast<uint32_t>(image_size)) {
+        bytes_written = transferImageData(sink, image_size, chunk_size,
+                                          static_cast<int32_t>(prefix_length));
+    }
+    sink->flush();
+    if (!sink->endImage(bytes_written)) {
+        DBG_GLX(GF("Image sink failed to finish the image!"));
+    }
+    return bytes_written;
+}
+
+uint32_t GeoluxCamera::resumeTransfer(GeoluxImageSink& sink, const uint8_t* prefix,
+                                      size_t prefix_length, int32_t image_size,
+                                      int32_t chunk_size) {
+    return resumeTransfer(&sink, prefix, prefix_length, image_size, chunk_size);
+}
+
+bool GeoluxCamera::lastImageWasDuplicate() {
+    return _last_was_duplicate;
+}
+
+GeoluxCamera::geolux_fingerprint GeoluxCamera::getLastFingerprint() {
+    return _last_fingerprint;
+}
+
+void GeoluxCamera::clearFingerprint() {
+    _last_fingerprint = {0, 0, 0};
+}
+
+uint32_t GeoluxCamera::transferImageData(Print* output, int32_t image_size,
+                                         int32_t chunk_size, int32_t start_offset) {
+    if (_typed_transfer && _typed_stream == _stream) {
+        return _typed_transfer(this, output, image_size, chunk_size, start_offset);
+    }
+    return transferImageDataFrom(_stream, output, image_size, chunk_size,
+                                 start_offset);
+}
+
+bool GeoluxCamera::restart() {
+    sendCommand(GFP(GEOLUX_CMD_RESET));
+    bool resp = waitCommandResponse(GeoluxLatencyStats::CMD_RESET) == 1;
+    if (resp) {
+        _reboot_millis = millis();
+        waitResponse(_timeouts.restart, GF("Geolux HydroCAM"),
+                     GF("Geolux HydroCam"));  // wait for a print out after restart
+        streamFind('\n');                     // skip to the end of the line
+    }
+    return resp;
+}
+
+bool GeoluxCamera::wasRebooted() {
+    return _rebooted;
+}
+
+uint16_t GeoluxCamera::getRebootCount() {
+    return _reboot_count;
+}
+
+uint32_t GeoluxCamera::getResetToReadyTime() {
+    return _reset_to_ready;
+}
 
-        for (int32_t i = 0; i < bytesToRead + start_data_byte; i++) {
-            uint32_t start_avail_time = millis();
-            while (!_stream->available() &&
-                   millis() - start_avail_time < 10);  // wait for the next character
-            if (!_stream->available()) {
-                DBG_GLX("\nNo more characters available!");
-                break;
+bool GeoluxCamera::recoverFromReboot(uint32_t timeout) {
+    _last_operation = GeoluxLatencyStats::WAIT_RESET;
+    if (!waitForReady(0, timeout)) {
+        DBG_GLX(GF("Camera not ready after reset!"));
+        return false;
+    }
+    DBG_GLX(GF("Camera ready"), _reset_to_ready, GF("ms after reset"));
+    _rebooted = false;
+    return restoreSettings(timeout);
+}
+
+bool GeoluxCamera::restoreSettings(uint32_t timeout) {
+    if (!_settings.set) { return true; }
+    bool success = true;
+    for (int8_t step = sendSetting(0); step >= 0; step = sendSetting(step + 1)) {
+        success &= waitCommandResponse(GeoluxLatencyStats::CMD_SET) == 1;
+    }
+    // one wait for all of the settings to apply
+    if (!waitForReady(0, timeout)) { success = false; }
+    if (!success) { DBG_GLX(GF("Failed to re-apply the camera settings!")); }
+    return success;
+}
+
+int8_t GeoluxCamera::sendSetting(uint8_t step) {
+    const geolux_settings& s = _settings;
+    for (; step < SETTING_STEPS; step++) {
+        switch (step) {
+            case 0: {
+                if (!(s.set & SETTING_RESOLUTION)) { continue; }
+                sendCommand(GFP(GEOLUX_CMD_SET_RESOLUTION), '=', s.resolution);
+                return step;
             }
-            max_char_spacing = max(max_char_spacing,
-                                   static_cast<uint32_t>(millis() - start_avail_time));
-            uint8_t b        = _stream->read();
-            bytes_read++;
-            total_bytes_read++;
-
-            if (total_bytes_written >= image_size && b == 0) {
-                if (!eof) { DBG_GLX("\n --Got 0, available data exceeded--\n"); }
-                eof = true;
-                // hit_zeros = true;
+            case 1: {
+                if (!(s.set & SETTING_QUALITY)) { continue; }
+                sendCommand(GFP(GEOLUX_CMD_SET_QUALITY), '=',
+                            static_cast<uint8_t>(s.quality));
+                return step;
             }
-            if (i >= start_data_byte && !eof) {
-                xferStream->write(b);
-                bytes_written++;
-                total_bytes_written++;
+            case 2: {
+                if (!(s.set & SETTING_JPEG_MAX_SIZE)) { continue; }
+                sendCommand(GFP(GEOLUX_CMD_SET_JPEG_MAXIMUM_SIZE), '=',
+                            s.jpeg_max_size);
+                return step;
             }
-
-            if (total_bytes_read == start_data_byte + 1) {
-                DBG_GLX("\n --Start JPG--");
+#if GEOLUX_ENABLE_COLOR
+            case 3: {
+                if (!(s.set & SETTING_NIGHT_MODE)) { continue; }
+                sendCommand(GFP(GEOLUX_CMD_SET_NIGHT_MODE), '=',
+                            s.night_mode == DAY       ? GF("day")
+                                : s.night_mode == NIGHT ? GF("night")
+                                                        : GF("auto"));
+                return step;
             }
-#ifdef GEOLUX_DEBUG
-            if ((total_bytes_read < 16 || total_bytes_written >= image_size - 16) &&
-                (!eof)) {
-                // print zero padded hex of the first and last 16 characters
-                char zph[3] = {'\0', '\0', '\0'};
-                sprintf(zph, "%02x", b);
-                GEOLUX_DEBUG.print(zph);
+            case 4: {
+                if (!(s.set & SETTING_IR_LED_MODE)) { continue; }
+                sendCommand(GFP(GEOLUX_CMD_SET_IR_LED_MODE), '=',
+                            s.ir_led_mode == IR_ON     ? GF("on")
+                                : s.ir_led_mode == IR_OFF ? GF("off")
+                                                          : GF("auto"));
+                return step;
             }
-            if (total_bytes_read == 16) { GEOLUX_DEBUG.print(GFP("...")); }
 #endif
-            if (millis() - start_xfer_millis > 120000L) {
-                DBG_GLX("\n ----Timed out!----\n");
-                total_bytes_written = bytes_remaining;
+#if GEOLUX_ENABLE_OPTICS
+            case 5: {
+                if (!(s.set & SETTING_AUTOFOCUS)) { continue; }
+                sendCommand(GFP(GEOLUX_CMD_SET_AUTOFOCUS_POINT), '=', s.autofocus[0],
+                            ',', s.autofocus[1]);
+                return step;
             }
-
-            uint8_t j = total_bytes_read % 4;
-            uint8_t k = total_bytes_read % 4 - 1;
-            if (k == static_cast<uint8_t>(-1)) { k = 3; }
-            prev_bytes[j] = b;
-            if ((b == 0xD9) && ((char)prev_bytes[k] == (char)0xFF)) {
-                eof = 1;
-                // got_end_tag = true;
-                DBG_GLX("\n --Got FFD9 EoF tag--\n");
+#endif
+#if GEOLUX_ENABLE_COLOR
+            case 6: {
+                if (!(s.set & SETTING_AUTOEXPOSURE)) { continue; }
+                sendCommand(GFP(GEOLUX_CMD_SET_AUTOEXPOSURE_REGION), '=',
+                            s.autoexposure[0], ',', s.autoexposure[1], ',',
+                            s.autoexposure[2], ',', s.autoexposure[3]);
+                return step;
             }
-            if ((b == 0xD8) && ((char)prev_bytes[k] == (char)0xFF)) {
-                eof = 0;
-                // got_start_tag = true;
-                DBG_GLX("\n --Got FFD8 start tag--");
+            case 7: {
+                if (!(s.set & SETTING_WB_OFFSET)) { continue; }
+                sendCommand(GFP(GEOLUX_CMD_SET_WB_OFFSET), '=', s.wb_offset[0], ',',
+                            s.wb_offset[1], ',', s.wb_offset[2]);
+                return step;
             }
-        }
-        bytes_remaining -= min(bytes_read, bytesToRead);
-        start_next_chunk += min(bytes_read, bytesToRead);
-        chunk_number++;
-
-        // if (bytes_read == 0) { break; }
-        if (eof) { break; }
-        if (bytes_read - start_data_byte != bytesToRead ||
-            bytes_written != bytesToRead) {
-            DBG_GLX(GF("Unexpected byte count: expected:"), bytesToRead, GF("read:"),
-                    bytes_read, GF("written:"), bytes_written);
-            // all_chunks_succeeded = false;
+            case 8: {
+                if (!(s.set & SETTING_COLOR_MODE)) { continue; }
+                sendCommand(GFP(GEOLUX_CMD_SET_COLOR_CORRECTION_MODE), '=',
+                            s.color_mode);
+                return step;
+            }
+#endif
+            case 9: {
+                if (!(s.set & SETTING_AUTO_INTERVAL)) { continue; }
+                sendCommand(GFP(GEOLUX_CMD_SET_AUTO_SNAPSHOT_INTERVAL), '=',
+                            s.auto_interval);
+                return step;
+            }
+            default: break;
         }
     }
+    return -1;
+}
 
-#if defined GEOLUX_DEBUG
-    uint32_t transfer_time = millis() - start_xfer_millis;
-#endif
+void GeoluxCamera::acknowledgeReboot() {
+    if (!_rebooted) { return; }
+    _rebooted       = false;
+    _reset_to_ready = millis() - _reboot_millis;
+    _last_operation = GeoluxLatencyStats::WAIT_OTHER;
+}
 
-    DBG_GLX(GF("Used"), chunk_number, GF("chunks to read"), total_bytes_read,
-            GF("bytes in"), chunk_size, GF("bytes chunks."));
-    DBG_GLX(GF("Wrote"), total_bytes_written, GF("of expected"), image_size,
-            GF("bytes to the SD card - a difference of"),
-            abs(total_bytes_written - image_size), GF("bytes"));
-    DBG_GLX(GF("Total transfer time was"), transfer_time, GF("ms"));
-    DBG_GLX(GF("The maximum response time after a request was"), max_command_response,
-            GF("and the maximum spacing between characters was"), max_char_spacing);
+void GeoluxCamera::forgetSettings() {
+    _settings.set = 0;
+}
 
+void GeoluxCamera::setAutoRecover(bool auto_recover) {
+    _auto_recover = auto_recover;
+}
 
-    return static_cast<uint32_t>(total_bytes_written);
+bool GeoluxCamera::isUnresponsive() {
+    return _unresponsive;
 }
 
-uint32_t GeoluxCamera::transferImage(Stream& xferStream, int32_t image_size,
-                                     int32_t chunk_size) {
-    return transferImage(&xferStream, image_size, chunk_size);
+uint8_t GeoluxCamera::getMissedResponses() {
+    return _missed_responses;
 }
 
-bool GeoluxCamera::restart() {
-    sendCommand(GF("reset"));
-    bool resp = waitResponse() == 1;
-    if (resp) {
-        waitResponse(10000L, GF("Geolux HydroCAM"),
-                     GF("Geolux HydroCam"));  // wait for a print out after restart
-        streamFind('\n');                     // skip to the end of the line
+void GeoluxCamera::setUnresponsiveThreshold(uint8_t misses) {
+    _unresponsive_threshold = misses;
+    if (!misses) { _unresponsive = false; }
+}
+
+void GeoluxCamera::setUnresponsiveCooldown(uint32_t cooldown_ms) {
+    _unresponsive_cooldown = cooldown_ms;
+}
+
+void GeoluxCamera::resetResponsiveness() {
+    _missed_responses = 0;
+    _unresponsive     = false;
+    _probing          = false;
+}
+
+bool GeoluxCamera::startProbe() {
+    if (!_unresponsive) { return false; }
+    if (millis() - _unresponsive_since < _unresponsive_cooldown) { return false; }
+    // probe with a single status request and a short timeout
+    DBG_GLX(GF("Checking whether the camera is answering again"));
+    streamWrite("#", GFP(GEOLUX_CMD_GET_STATUS), "\r\n");
+    _stream->flush();
+    _probing     = true;
+    _probe_start = millis();
+    return true;
+}
+
+int8_t GeoluxCamera::checkProbe() {
+    if (!_probing) { return _unresponsive ? 0 : 1; }
+    bool answered = _stream->available() > 0;
+    if (!answered && millis() - _probe_start < GEOLUX_BREAKER_PROBE_TIMEOUT) {
+        return -1;
     }
-    return resp;
+    _probing = false;
+    recordAnswer(answered);
+    return answered ? 1 : 0;
+}
+
+bool GeoluxCamera::allowCommand() {
+    if (!_unresponsive) { return true; }
+    if (millis() - _unresponsive_since < _unresponsive_cooldown) { return false; }
+    streamDump();
+    if (!startProbe()) { return false; }
+    int8_t answered;
+    while ((answered = checkProbe()) < 0) {}
+    // skip the answer to the probe
+    if (answered) { streamFind('\n'); }
+    return answered == 1;
+}
+
+bool GeoluxCamera::waitForData(uint32_t start_time, uint32_t timeout,
+                               int min_bytes) {
+    return waitForDataFrom(_stream, start_time, timeout, min_bytes);
 }
 
+void GeoluxCamera::recordAnswer(bool answered) {
+    if (answered) {
+        if (_unresponsive) { DBG_GLX(GF("Camera is answering again")); }
+        _missed_responses = 0;
+        _unresponsive     = false;
+        return;
+    }
+    if (_missed_responses < UINT8_MAX) { _missed_responses++; }
+    if (_unresponsive_threshold && _missed_responses >= _unresponsive_threshold) {
+        if (!_unresponsive) {
+            DBG_GLX(GF("### Camera isn't answering; failing commands for"),
+                    _unresponsive_cooldown, GF("ms"));
+        }
+        // start the cooldown over after every miss, including failed probes
+        _unresponsive       = true;
+        _unresponsive_since = millis();
+    }
+}
+
+bool GeoluxCamera::matchBanner(uint8_t b) {
+    // the camera has printed both "Geolux HydroCAM" and "Geolux HydroCam"
+    static const char banner[] = "geolux hydrocam";
+    char              c        = static_cast<char>(tolower(b));
+    if (c != banner[_banner_match]) { _banner_match = 0; }
+    if (c == banner[_banner_match]) { _banner_match++; }
+    if (_banner_match < sizeof(banner) - 1) { return false; }
+    _banner_match = 0;
+    return true;
+}
+
+void GeoluxCamera::noteReboot() {
+    DBG_GLX(GF("### Unexpected camera reset!"));
+    _rebooted      = true;
+    _reboot_millis = millis();
+    if (_reboot_count < UINT16_MAX) { _reboot_count++; }
+    // the next wait is for the camera to come back up
+    _last_operation = GeoluxLatencyStats::WAIT_RESET;
+}
+
+#if GEOLUX_ENABLE_INFO
 void GeoluxCamera::printCameraInfo(Stream* outStream) {
     uint32_t start_time = millis();
-    sendCommand(GF("get_info"));
+    sendCommand(GFP(GEOLUX_CMD_GET_INFO));
     // wait for response
-    while (!_stream->available() && millis() - start_time < 5000L);
+    if (!waitForData(start_time, _timeouts.response)) { return; }
     while (_stream->available()) {
         outStream->println(_stream->readStringUntil('\n'));
         delay(2);
     }
+    recordCommand(GeoluxLatencyStats::CMD_GET_INFO);
 }
 
 void GeoluxCamera::printCameraInfo(Stream& outStream) {
     printCameraInfo(&outStream);
 }
 
+/**
+ * @brief Copy a value from the camera info into a fixed size string, truncating it if
+ * needed.
+ *
+ * @param dest The string to copy to
+ * @param size The size of the destination, including the terminating null
+ * @param value The value to copy
+ */
+static void copyInfoValue(char* dest, size_t size, const char* value) {
+    strncpy(dest, value, size - 1);
+    dest[size - 1] = '\0';
+}
+
+bool GeoluxCamera::getCameraInfo(geolux_info* info) {
+    memset(info, 0, sizeof(geolux_info));
+    // send the get_info command
+    uint32_t start_time = millis();
+    sendCommand(GFP(GEOLUX_CMD_GET_INFO));
+    // wait for response
+    if (!waitForData(start_time, _timeouts.response)) { return false; }
+
+    // once the response has started, shorten the timeout
+    uint32_t prev_timeout = _stream->getTimeout();
+    _stream->setTimeout(_timeouts.stream);
+    uint8_t fields_read = 0;
+    char    line[48];
+    while (_stream->find('#')) {
+        size_t length = _stream->readBytesUntil('\n', line, sizeof(line) - 1);
+        if (length && line[length - 1] == '\r') { length--; }
+        line[length] = '\0';
+        // split the line into the key and the value
+        char* value = strchr(line, ':');
+        if (!value) { continue; }
+        *value++ = '\0';
+        fields_read++;
+        if (!strcmp(line, "device_type")) {
+            copyInfoValue(info->device_type, sizeof(info->device_type), value);
+        } else if (!strcmp(line, "firmware")) {
+            copyInfoValue(info->firmware, sizeof(info->firmware), value);
+        } else if (!strcmp(line, "serial_id")) {
+            info->serial_number = strtoul(value, nullptr, 10);
+        } else if (!strcmp(line, "resolution")) {
+            copyInfoValue(info->resolution, sizeof(info->resolution), value);
+        } else if (!strcmp(line, "quality")) {
+            info->quality = static_cast<int8_t>(atoi(value));
+        } else if (!strcmp(line, "exposure")) {
+            info->exposure = strtoul(value, nullptr, 10);
+        } else if (!strcmp(line, "image_brightness")) {
+            info->brightness = strtoul(value, nullptr, 10);
+        } else if (!strcmp(line, "ir_filter")) {
+            copyInfoValue(info->ir_filter, sizeof(info->ir_filter), value);
+        } else if (!strcmp(line, "focus_position")) {
+            info->focus_position = static_cast<int16_t>(atoi(value));
+        } else if (!strcmp(line, "zoom_position")) {
+            info->zoom_position = static_cast<int8_t>(atoi(value));
+        }
+    }
+    // reset the stream timeout
+    _stream->setTimeout(prev_timeout);
+    recordCommand(GeoluxLatencyStats::CMD_GET_INFO);
+    if (_capture_planner && fields_read > 0) {
+        _capture_planner->setResolution(info->resolution);
+        _capture_planner->setQuality(info->quality);
+    }
+    return fields_read > 0;
+}
+
+bool GeoluxCamera::getCameraInfo(geolux_info& info) {
+    return getCameraInfo(&info);
+}
+
 String GeoluxCamera::getDeviceType() {
-    return getCameraInfoString("#device_type:");
+    return getCameraInfoString(GFP(GEOLUX_TAG_DEVICE_TYPE));
 }
 
 String GeoluxCamera::getCameraFirmware() {
-    return getCameraInfoString("#firmware:");
+    return getCameraInfoString(GFP(GEOLUX_TAG_FIRMWARE));
 }
 
 uint32_t GeoluxCamera::getCameraSerialNumber() {
-    uint32_t serial_number = getCameraInfoInt("#serial_id:");
+    uint32_t serial_number = getCameraInfoInt(GFP(GEOLUX_TAG_SERIAL_ID));
     if (serial_number != static_cast<uint32_t>(-1)) { return serial_number; }
     return 0;
 }
+#endif
 
+#if GEOLUX_ENABLE_OPTICS
 bool GeoluxCamera::runAutofocus() {
-    sendCommand(GF("run_autofocus"));
-    return waitResponse() == 1;
+    sendCommand(GFP(GEOLUX_CMD_RUN_AUTOFOCUS));
+    return waitCommandResponse(GeoluxLatencyStats::CMD_RUN_AUTOFOCUS) == 1;
 }
+#endif
 
 bool GeoluxCamera::setResolution(const char* resolution) {
-    sendCommand(GF("set_resolution"), '=', resolution);
-    return waitResponse() == 1;
+    sendCommand(GFP(GEOLUX_CMD_SET_RESOLUTION), '=', resolution);
+    bool resp = waitCommandResponse(GeoluxLatencyStats::CMD_SET) == 1;
+    if (resp) {
+        strncpy(_settings.resolution, resolution, sizeof(_settings.resolution) - 1);
+        _settings.set |= SETTING_RESOLUTION;
+        if (_capture_planner) { _capture_planner->setResolution(resolution); }
+    }
+    return resp;
 }
 
 String GeoluxCamera::getResolution() {
-    return getCameraInfoString("#resolution:");
+    return getCameraInfoString(GFP(GEOLUX_TAG_RESOLUTION));
 }
 
 bool GeoluxCamera::setQuality(uint8_t compression) {
-    sendCommand(GF("set_quality"), '=', compression);
-    return waitResponse() == 1;
+    sendCommand(GFP(GEOLUX_CMD_SET_QUALITY), '=', compression);
+    bool resp = waitCommandResponse(GeoluxLatencyStats::CMD_SET) == 1;
+    if (resp) {
+        _settings.quality = compression;
+        _settings.set |= SETTING_QUALITY;
+        if (_capture_planner) { _capture_planner->setQuality(compression); }
+    }
+    return resp;
 }
 
 int8_t GeoluxCamera::getQuality() {
-    return static_cast<int8_t>(getCameraInfoInt("#quality:"));
+    return static_cast<int8_t>(getCameraInfoInt(GFP(GEOLUX_TAG_QUALITY)));
 }
 
 bool GeoluxCamera::setJPEGMaximumSize(uint16_t size) {
-    sendCommand(GF("set_jpeg_maximum_size"), '=', size);
-    return waitResponse() == 1;
+    sendCommand(GFP(GEOLUX_CMD_SET_JPEG_MAXIMUM_SIZE), '=', size);
+    bool resp = waitCommandResponse(GeoluxLatencyStats::CMD_SET) == 1;
+    if (resp) {
+        _settings.jpeg_max_size = size;
+        _settings.set |= SETTING_JPEG_MAX_SIZE;
+    }
+    return resp;
 }
 
 uint32_t GeoluxCamera::getJPEGMaximumSize() {
-    return getCameraInfoInt("#jpeg_maximum_size:");
+    return getCameraInfoInt(GFP(GEOLUX_TAG_JPEG_MAXIMUM_SIZE));
+}
+
+#if GEOLUX_ENABLE_COLOR
+/**
+ * @brief Find the position of a mode name in a list of three names.
+ *
+ * @param mode The mode as characters
+ * @param first The name of the mode with value 0
+ * @param second The name of the mode with value 1
+ * @param third The name of the mode with value 2
+ * @return The value of the mode, or -1 if it isn't one of the names
+ */
+static int8_t parseMode(const char* mode, const char* first, const char* second,
+                        const char* third) {
+    if (!mode) { return -1; }
+    if (strcmp(mode, first) == 0) { return 0; }
+    if (strcmp(mode, second) == 0) { return 1; }
+    if (strcmp(mode, third) == 0) { return 2; }
+    return -1;
 }
 
 bool GeoluxCamera::setNightMode(geolux_night_mode mode) {
     switch (mode) {
         case DAY: {
-            sendCommand(GF("set_quality"), '=', GF("day"));
+            sendCommand(GFP(GEOLUX_CMD_SET_NIGHT_MODE), '=', GF("day"));
             break;
         }
         case NIGHT: {
-            sendCommand(GF("set_quality"), '=', GF("night"));
+            sendCommand(GFP(GEOLUX_CMD_SET_NIGHT_MODE), '=', GF("night"));
             break;
         }
         case AUTO:
         default: {
-            sendCommand(GF("set_quality"), '=', GF("auto"));
+            mode = AUTO;
+            sendCommand(GFP(GEOLUX_CMD_SET_NIGHT_MODE), '=', GF("auto"));
             break;
         }
     }
-    return waitResponse() == 1;
+    bool resp = waitCommandResponse(GeoluxLatencyStats::CMD_SET) == 1;
+    if (resp) {
+        _settings.night_mode = mode;
+        _settings.set |= SETTING_NIGHT_MODE;
+    }
+    return resp;
 }
 
 bool GeoluxCamera::setNightMode(const char* mode) {
-    sendCommand(GF("set_resolution"), '=', mode);
-    return waitResponse() == 1;
+    sendCommand(GFP(GEOLUX_CMD_SET_NIGHT_MODE), '=', mode);
+    bool   resp  = waitCommandResponse(GeoluxLatencyStats::CMD_SET) == 1;
+    int8_t value = parseMode(mode, "day", "night", "auto");
+    if (resp && value >= 0) {
+        _settings.night_mode = value;
+        _settings.set |= SETTING_NIGHT_MODE;
+    }
+    return resp;
 }
 
 String GeoluxCamera::getNightMode() {
-    return getCameraInfoString("#night_mode:");
+    return getCameraInfoString(GFP(GEOLUX_TAG_NIGHT_MODE));
 }
 
 bool GeoluxCamera::setIRLEDMode(geolux_ir_mode mode) {
     switch (mode) {
         case IR_ON: {
-            sendCommand(GF("set_ir_led_mode"), '=', GF("on"));
+            sendCommand(GFP(GEOLUX_CMD_SET_IR_LED_MODE), '=', GF("on"));
             break;
         }
         case IR_OFF: {
-            sendCommand(GF("set_ir_led_mode"), '=', GF("off"));
+            sendCommand(GFP(GEOLUX_CMD_SET_IR_LED_MODE), '=', GF("off"));
             break;
         }
         case IR_AUTO:
         default: {
-            sendCommand(GF("set_ir_led_mode"), '=', GF("auto"));
+            mode = IR_AUTO;
+            sendCommand(GFP(GEOLUX_CMD_SET_IR_LED_MODE), '=', GF("auto"));
             break;
         }
     }
-    return waitResponse() == 1;
+    bool resp = waitCommandResponse(GeoluxLatencyStats::CMD_SET) == 1;
+    if (resp) {
+        _settings.ir_led_mode = mode;
+        _settings.set |= SETTING_IR_LED_MODE;
+    }
+    return resp;
 }
 
 bool GeoluxCamera::setIRLEDMode(const char* mode) {
-    sendCommand(GF("set_resolution"), '=', mode);
-    return waitResponse() == 1;
+    sendCommand(GFP(GEOLUX_CMD_SET_IR_LED_MODE), '=', mode);
+    bool   resp  = waitCommandResponse(GeoluxLatencyStats::CMD_SET) == 1;
+    int8_t value = parseMode(mode, "on", "off", "auto");
+    if (resp && value >= 0) {
+        _settings.ir_led_mode = value;
+        _settings.set |= SETTING_IR_LED_MODE;
+    }
+    return resp;
 }
 
 String GeoluxCamera::getIRLEDMode() {
-    return getCameraInfoString("#ir_led_mode:");
+    return getCameraInfoString(GFP(GEOLUX_TAG_IR_LED_MODE));
 }
 
 bool GeoluxCamera::getIRFilterStatus() {
-    return getCameraInfoString("#ir_filter:") == "night";
+    return getCameraInfoString(GFP(GEOLUX_TAG_IR_FILTER)) == "night";
 }
+#endif
 
+#if GEOLUX_ENABLE_OPTICS
 bool GeoluxCamera::setAutofocusPoint(int8_t x, int8_t y) {
-    sendCommand(GF("set_autofocus_point"), '=', x, ',', y);
-    return waitResponse() == 1;
+    sendCommand(GFP(GEOLUX_CMD_SET_AUTOFOCUS_POINT), '=', x, ',', y);
+    bool resp = waitCommandResponse(GeoluxLatencyStats::CMD_SET) == 1;
+    if (resp) {
+        _settings.autofocus[0] = x;
+        _settings.autofocus[1] = y;
+        _settings.set |= SETTING_AUTOFOCUS;
+    }
+    return resp;
 }
 
 int8_t GeoluxCamera::getAutofocusX() {
-    return static_cast<int8_t>(getCameraInfoInt("#autofocus_point:", ','));
+    return static_cast<int8_t>(getCameraInfoInt(GFP(GEOLUX_TAG_AUTOFOCUS_POINT), ','));
 }
 
 int8_t GeoluxCamera::getAutofocusY() {
-    return static_cast<int8_t>(getCameraInfoInt("#autofocus_point:", '\r', 1, ","));
+    return static_cast<int8_t>(
+        getCameraInfoInt(GFP(GEOLUX_TAG_AUTOFOCUS_POINT), '\r', 1, ","));
 }
+#endif
 
+#if GEOLUX_ENABLE_COLOR
 bool GeoluxCamera::setAutoexposureRegion(int8_t x, int8_t y, int8_t width,
                                          int8_t height) {
-    sendCommand(GF("set_autoexposure_region"), '=', x, ',', y, ',', width, ',', height);
-    return waitResponse() == 1;
+    sendCommand(GFP(GEOLUX_CMD_SET_AUTOEXPOSURE_REGION), '=', x, ',', y, ',', width,
+                ',', height);
+    bool resp = waitCommandResponse(GeoluxLatencyStats::CMD_SET) == 1;
+    if (resp) {
+        _settings.autoexposure[0] = x;
+        _settings.autoexposure[1] = y;
+        _settings.autoexposure[2] = width;
+        _settings.autoexposure[3] = height;
+        _settings.set |= SETTING_AUTOEXPOSURE;
+    }
+    return resp;
 }
 
 int8_t GeoluxCamera::getAutoexposureX() {
-    return static_cast<int8_t>(getCameraInfoInt("#autoexposure_region:", ','));
+    return static_cast<int8_t>(
+        getCameraInfoInt(GFP(GEOLUX_TAG_AUTOEXPOSURE_REGION), ','));
 }
 
 int8_t GeoluxCamera::getAutoexposureY() {
-    return static_cast<int8_t>(getCameraInfoInt("#autoexposure_region:", ',', 1, ","));
+    return static_cast<int8_t>(
+        getCameraInfoInt(GFP(GEOLUX_TAG_AUTOEXPOSURE_REGION), ',', 1, ","));
 }
 
 int8_t GeoluxCamera::getAutoexposureWidth() {
-    return static_cast<int8_t>(getCameraInfoInt("#autoexposure_region:", ',', 2, ","));
+    return static_cast<int8_t>(
+        getCameraInfoInt(GFP(GEOLUX_TAG_AUTOEXPOSURE_REGION), ',', 2, ","));
 }
 
 int8_t GeoluxCamera::getAutoexposureHeight() {
-    return static_cast<int8_t>(getCameraInfoInt("#autoexposure_region:", '\r', 3, ","));
+    return static_cast<int8_t>(
+        getCameraInfoInt(GFP(GEOLUX_TAG_AUTOEXPOSURE_REGION), '\r', 3, ","));
 }
 
 uint32_t GeoluxCamera::getExposureTime() {
-    return getCameraInfoInt("#exposure:");
+    return getCameraInfoInt(GFP(GEOLUX_TAG_EXPOSURE));
 }
 
 uint32_t GeoluxCamera::getImageBrightness() {
-    return getCameraInfoInt("#image_brightness:");
+    return getCameraInfoInt(GFP(GEOLUX_TAG_IMAGE_BRIGHTNESS));
 }
 
 bool GeoluxCamera::setWhiteBalanceOffset(int8_t red, int8_t green, int8_t blue) {
-    sendCommand(GF("set_wb_offset"), '=', red, ',', green, ',', blue);
-    return waitResponse() == 1;
+    sendCommand(GFP(GEOLUX_CMD_SET_WB_OFFSET), '=', red, ',', green, ',', blue);
+    bool resp = waitCommandResponse(GeoluxLatencyStats::CMD_SET) == 1;
+    if (resp) {
+        _settings.wb_offset[0] = red;
+        _settings.wb_offset[1] = green;
+        _settings.wb_offset[2] = blue;
+        _settings.set |= SETTING_WB_OFFSET;
+    }
+    return resp;
 }
 
 int8_t GeoluxCamera::getWhiteBalanceOffsetRed() {
-    return static_cast<int8_t>(getCameraInfoInt("#wb_offset:"), ',');
+    return static_cast<int8_t>(getCameraInfoInt(GFP(GEOLUX_TAG_WB_OFFSET)), ',');
 }
 
 int8_t GeoluxCamera::getWhiteBalanceOffsetGreen() {
-    return static_cast<int8_t>(getCameraInfoInt("#wb_offset:", ',', 1, ","));
+    return static_cast<int8_t>(
+        getCameraInfoInt(GFP(GEOLUX_TAG_WB_OFFSET), ',', 1, ","));
 }
 
 int8_t GeoluxCamera::getWhiteBalanceOffsetBlue() {
-    return static_cast<int8_t>(getCameraInfoInt("#wb_offset:", '\r', 2, ","));
+    return static_cast<int8_t>(
+        getCameraInfoInt(GFP(GEOLUX_TAG_WB_OFFSET), '\r', 2, ","));
 }
 
 bool GeoluxCamera::setColorCorrectionMode(int8_t mode) {
-    sendCommand(GF("set_color_correction_mod"), '=', mode);
-    return waitResponse() == 1;
+    sendCommand(GFP(GEOLUX_CMD_SET_COLOR_CORRECTION_MODE), '=', mode);
+    bool resp = waitCommandResponse(GeoluxLatencyStats::CMD_SET) == 1;
+    if (resp) {
+        _settings.color_mode = mode;
+        _settings.set |= SETTING_COLOR_MODE;
+    }
+    return resp;
 }
 
 bool GeoluxCamera::getColorCorrectionMode() {
-    return getCameraInfoString("#color_correction_mode:") == "on";
+    return getCameraInfoString(GFP(GEOLUX_TAG_COLOR_CORRECTION_MODE)) == "on";
 }
+#endif
 
 bool GeoluxCamera::setAutoSnapshotInterval(uint32_t mode) {
-    sendCommand(GF("set_auto_snapshot_interval"), '=', mode);
-    return waitResponse() == 1;
+    sendCommand(GFP(GEOLUX_CMD_SET_AUTO_SNAPSHOT_INTERVAL), '=', mode);
+    bool resp = waitCommandResponse(GeoluxLatencyStats::CMD_SET) == 1;
+    if (resp) {
+        _settings.auto_interval = mode;
+        _settings.set |= SETTING_AUTO_INTERVAL;
+    }
+    return resp;
 }
 
 uint32_t GeoluxCamera::getAutoSnapshotInterval() {
-    String snapInterval = getCameraInfoString("#auto_snapshot_interval:");
+    String snapInterval = getCameraInfoString(GFP(GEOLUX_TAG_AUTO_SNAPSHOT_INTERVAL));
     if (snapInterval == "off") return 0;
     return snapInterval.toInt();
 }
 
+#if GEOLUX_ENABLE_OPTICS
 bool GeoluxCamera::moveFocus(int8_t offset) {
-    sendCommand(GF("move_focus"), '=', offset);
-    return waitResponse() == 1;
+    sendCommand(GFP(GEOLUX_CMD_MOVE_FOCUS), '=', offset);
+    return waitCommandResponse(GeoluxLatencyStats::CMD_MOVE) == 1;
 }
 
 int16_t GeoluxCamera::getFocusPosition() {
-    return static_cast<int16_t>(getCameraInfoInt("#focus_position:"));
+    return static_cast<int16_t>(getCameraInfoInt(GFP(GEOLUX_TAG_FOCUS_POSITION)));
 }
 
 bool GeoluxCamera::moveZoom(int8_t offset) {
-    sendCommand(GF("move_zoom"), '=', offset);
-    return waitResponse() == 1;
+    sendCommand(GFP(GEOLUX_CMD_MOVE_ZOOM), '=', offset);
+    return waitCommandResponse(GeoluxLatencyStats::CMD_MOVE) == 1;
 }
 
 int8_t GeoluxCamera::getZoomPosition() {
-    return static_cast<int8_t>(getCameraInfoInt("#zoom_position:"));
+    return static_cast<int8_t>(getCameraInfoInt(GFP(GEOLUX_TAG_ZOOM_POSITION)));
 }
+#endif
 
 bool GeoluxCamera::sleep(uint32_t sleepTimeout) {
-    sendCommand(GF("sleep"), '=', sleepTimeout);
-    return waitResponse() == 1;
+    sendCommand(GFP(GEOLUX_CMD_SLEEP), '=', sleepTimeout);
+    return waitCommandResponse(GeoluxLatencyStats::CMD_SLEEP) == 1;
 }
 
 uint32_t GeoluxCamera::waitForReady(uint32_t initial_delay, uint32_t timeout) {
+    // don't wait out the delay for a camera that isn't answering
+    if (!allowCommand()) { return 0; }
+    if (!timeout) { timeout = _timeouts.ready; }
     geolux_status camera_status = geolux_status::NO_RESPONSE;
     uint32_t      start_millis  = millis();
     delay(initial_delay);
     while (camera_status != geolux_status::OK && camera_status != geolux_status::NONE &&
            millis() - start_millis < timeout) {
         camera_status = getStatus();
+        // whatever we were waiting for was lost in the reset
+        if (camera_status == geolux_status::REBOOTED) { break; }
+        if (_command_blocked) { break; }
         // delay to avoid pounding the camera too hard
         if (camera_status != geolux_status::OK &&
             camera_status != geolux_status::NONE) {
             delay(100);
         }
     }
+    // whatever happens, the operation we were waiting on is over
+    GeoluxLatencyStats::geolux_wait operation = _last_operation;
+    _last_operation = camera_status == geolux_status::REBOOTED
+        ? GeoluxLatencyStats::WAIT_RESET
+        : GeoluxLatencyStats::WAIT_OTHER;
     if (camera_status == GeoluxCamera::OK || camera_status == GeoluxCamera::NONE) {
-        return millis() - start_millis;
+        uint32_t wait_time = millis() - start_millis;
+        if (_latency_stats) { _latency_stats->recordWait(operation, wait_time); }
+        if (_capture_planner) { _capture_planner->recordWait(operation, wait_time); }
+        if (operation == GeoluxLatencyStats::WAIT_RESET) {
+            _reset_to_ready = millis() - _reboot_millis;
+        }
+        // 0 means timed out, so an immediate ready is reported as 1 ms
+        return wait_time ? wait_time : 1;
     } else {
         return 0;
     }
 }
 
+void GeoluxCamera::setTimeouts(const GeoluxTimeouts& timeouts) {
+    _timeouts = timeouts;
+}
+
+GeoluxTimeouts& GeoluxCamera::getTimeouts() {
+    return _timeouts;
+}
+
+void GeoluxCamera::setLatencyStats(GeoluxLatencyStats* stats) {
+    _latency_stats = stats;
+}
+
+GeoluxLatencyStats* GeoluxCamera::getLatencyStats() {
+    return _latency_stats;
+}
+
+void GeoluxCamera::setEventLog(GeoluxEventLog* log) {
+    _event_log = log;
+}
+
+GeoluxEventLog* GeoluxCamera::getEventLog() {
+    return _event_log;
+}
+
+void GeoluxCamera::setCapturePlanner(GeoluxCapturePlanner* planner) {
+    _capture_planner = planner;
+}
+
+GeoluxCapturePlanner* GeoluxCamera::getCapturePlanner() {
+    return _capture_planner;
+}
+
+void GeoluxCamera::recordCommand(GeoluxLatencyStats::geolux_command command) {
+    switch (command) {
+        case GeoluxLatencyStats::CMD_TAKE_SNAPSHOT:
+            _last_operation = GeoluxLatencyStats::WAIT_SNAPSHOT;
+            break;
+        case GeoluxLatencyStats::CMD_RUN_AUTOFOCUS:
+            _last_operation = GeoluxLatencyStats::WAIT_AUTOFOCUS;
+            break;
+        case GeoluxLatencyStats::CMD_SET:
+            _last_operation = GeoluxLatencyStats::WAIT_SETTINGS;
+            break;
+        case GeoluxLatencyStats::CMD_MOVE:
+            _last_operation = GeoluxLatencyStats::WAIT_MOVE;
+            break;
+        case GeoluxLatencyStats::CMD_RESET:
+            _last_operation = GeoluxLatencyStats::WAIT_RESET;
+            break;
+        default: break;
+    }
+    if (_latency_stats) {
+        _latency_stats->recordCommand(command, millis() - _command_start);
+    }
+}
+
 int8_t GeoluxCamera::waitResponse(uint32_t timeout_ms, String& data, GsmConstStr r1,
                                   GsmConstStr r2, GsmConstStr r3, GsmConstStr r4)
 
 {
+    if (_command_blocked) { return 0; }
     data.reserve(32);
     uint8_t  index       = 0;
     uint32_t startMillis = millis();
+    _banner_match        = 0;
     do {
         while (_stream->available() > 0) {
             int8_t a = _stream->read();
@@ -525,22 +1132,16 @@ int8_t GeoluxCamera::waitResponse(uint32_t timeout_ms, String& data, GsmConstStr
                 index = 4;
                 goto finish;
             }
-#if defined GEOLUX_DEBUG
-            else if (data.endsWith(GF("Geolux HydroCAM"))) {
-                data = "";
-                DBG_GLX("### Unexpected module reset!");
-                init();
-                return true;
-            } else if (data.endsWith(GF("Geolux HydroCam"))) {
+            else if (matchBanner(a)) {
                 data = "";
-                DBG_GLX("### Unexpected module reset!");
-                init();
-                return true;
+                noteReboot();
+                index = REBOOTED;
+                goto finish;
             }
-#endif
         }
     } while (millis() - startMillis < timeout_ms);
 finish:
+    recordAnswer(index || data.length());
     if (!index) {
         data.trim();
         if (data.length()) {}
@@ -558,25 +1159,31 @@ int8_t GeoluxCamera::waitResponse(uint32_t timeout_ms, GsmConstStr r1, GsmConstS
 
 int8_t GeoluxCamera::waitResponse(GsmConstStr r1, GsmConstStr r2, GsmConstStr r3,
                                   GsmConstStr r4) {
-    return waitResponse(5000L, r1, r2, r3, r4);
+    return waitResponse(_timeouts.response, r1, r2, r3, r4);
 }
 
-String GeoluxCamera::getCameraInfoString(const char* searchStartTag, char searchEndTag,
+int8_t GeoluxCamera::waitCommandResponse(GeoluxLatencyStats::geolux_command command) {
+    int8_t resp = waitResponse();
+    if (resp && resp != REBOOTED) { recordCommand(command); }
+    return resp;
+}
+
+String GeoluxCamera::getCameraInfoString(GsmConstStr searchStartTag, char searchEndTag,
                                          int8_t      numberSkips,
                                          const char* searchSkipTag) {
     // send the get_info command
     uint32_t start_time = millis();
-    sendCommand(GF("get_info"));
+    sendCommand(GFP(GEOLUX_CMD_GET_INFO));
     // wait for response
-    while (!_stream->available() && millis() - start_time < 5000L);
+    if (!waitForData(start_time, _timeouts.response)) { return ""; }
 
     // find the start string
-    if (!_stream->find(const_cast<char*>(searchStartTag), strlen(searchStartTag))) {
-        return "";
-    }
+    char start_tag[GEOLUX_TAG_BUFFER];
+    copyTag(start_tag, sizeof(start_tag), searchStartTag);
+    if (!_stream->find(start_tag, strlen(start_tag))) { return ""; }
     // after we've found the first string, shorten the timeout
     uint32_t prev_timeout = _stream->getTimeout();
-    _stream->setTimeout(15L);
+    _stream->setTimeout(_timeouts.stream);
     // skip as many times as requested
     for (uint8_t skips = numberSkips; skips; skips--) {
         _stream->find(const_cast<char*>(searchSkipTag), strlen(searchSkipTag));
@@ -586,24 +1193,25 @@ String GeoluxCamera::getCameraInfoString(const char* searchStartTag, char search
     while (_stream->find('#')) { _stream->readStringUntil('\n'); }
     // reset the stream timeout
     _stream->setTimeout(prev_timeout);
+    recordCommand(GeoluxLatencyStats::CMD_GET_INFO);
     return resp;
 }
-long GeoluxCamera::getCameraInfoInt(const char* searchStartTag, char searchEndTag,
+long GeoluxCamera::getCameraInfoInt(GsmConstStr searchStartTag, char searchEndTag,
                                     int8_t numberSkips, const char* searchSkipTag) {
     // send the get_info command
     uint32_t start_time = millis();
-    sendCommand(GF("get_info"));
-    // wait for response
-    while (!_stream->available() && millis() - start_time < 5000L);
+    sendCommand(GFP(GEOLUX_CMD_GET_INFO));
 
     uint32_t resp = -1;
+    // wait for response
+    if (!waitForData(start_time, _timeouts.response)) { return resp; }
     // find the start string
-    if (!_stream->find(const_cast<char*>(searchStartTag), strlen(searchStartTag))) {
-        return resp;
-    }
+    char start_tag[GEOLUX_TAG_BUFFER];
+    copyTag(start_tag, sizeof(start_tag), searchStartTag);
+    if (!_stream->find(start_tag, strlen(start_tag))) { return resp; }
     // after we've found the first string, shorten the timeout
     uint32_t prev_timeout = _stream->getTimeout();
-    _stream->setTimeout(15L);
+    _stream->setTimeout(_timeouts.stream);
     // skip as many times as requested
     for (uint8_t skips = numberSkips; skips; skips--) {
         _stream->find(const_cast<char*>(searchSkipTag), strlen(searchSkipTag));
@@ -621,5 +1229,6 @@ long GeoluxCamera::getCameraInfoInt(const char* searchStartTag, char searchEndTa
     while (_stream->find('#')) { _stream->readStringUntil('\n'); }
     // reset the stream timeout
     _stream->setTimeout(prev_timeout);
+    recordCommand(GeoluxLatencyStats::CMD_GET_INFO);
     return resp;
 }
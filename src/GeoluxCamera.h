@@ -9,6 +9,42 @@
 #define SRC_GEOLUXCAMERA_H_
 
 #include <Arduino.h>
+#include "GeoluxEventLog.h"
+#include "GeoluxImageSink.h"
+#include "GeoluxJpeg.h"
+#include "GeoluxLatency.h"
+#include "GeoluxPlanner.h"
+#include "GeoluxTimeouts.h"
+
+/**
+ * @def GEOLUX_ENABLE_OPTICS
+ * @brief Set to 0 to leave out the autofocus, focus and zoom commands.
+ *
+ * Like GEOLUX_DEBUG, this and the other feature switches must be set as build flags
+ * so the library source files see them; defines in a sketch only reach the sketch.
+ * GeoluxFocusMemory needs both the optics and info commands.
+ */
+#ifndef GEOLUX_ENABLE_OPTICS
+#define GEOLUX_ENABLE_OPTICS 1
+#endif
+
+/**
+ * @def GEOLUX_ENABLE_COLOR
+ * @brief Set to 0 to leave out the day/night, IR LED, auto-exposure, white balance and
+ * color correction commands.
+ */
+#ifndef GEOLUX_ENABLE_COLOR
+#define GEOLUX_ENABLE_COLOR 1
+#endif
+
+/**
+ * @def GEOLUX_ENABLE_INFO
+ * @brief Set to 0 to leave out printCameraInfo(), getCameraInfo() and the device
+ * type, firmware and serial number getters.
+ */
+#ifndef GEOLUX_ENABLE_INFO
+#define GEOLUX_ENABLE_INFO 1
+#endif
 
 /**
  * @def DEFAULT_XFER_CHUNK_SIZE
@@ -22,6 +58,48 @@
 #define DEFAULT_XFER_CHUNK_SIZE 16384
 #endif
 
+/**
+ * @def GEOLUX_XFER_BATCH_SIZE
+ * @brief The number of bytes taken from the stream at once during an image transfer.
+ *
+ * The bytes are read into a buffer of this size on the stack and then checked one at
+ * a time.
+ */
+#ifndef GEOLUX_XFER_BATCH_SIZE
+#if defined(__AVR__)
+#define GEOLUX_XFER_BATCH_SIZE 32
+#else
+#define GEOLUX_XFER_BATCH_SIZE 128
+#endif
+#endif
+
+/**
+ * @def GEOLUX_BREAKER_THRESHOLD
+ * @brief The number of commands in a row that can go unanswered before the camera is
+ * treated as unresponsive and further commands fail immediately.
+ */
+#ifndef GEOLUX_BREAKER_THRESHOLD
+#define GEOLUX_BREAKER_THRESHOLD 3
+#endif
+
+/**
+ * @def GEOLUX_BREAKER_COOLDOWN
+ * @brief The time in milliseconds after the camera is found unresponsive before the
+ * next command probes it again.
+ */
+#ifndef GEOLUX_BREAKER_COOLDOWN
+#define GEOLUX_BREAKER_COOLDOWN 30000L
+#endif
+
+/**
+ * @def GEOLUX_BREAKER_PROBE_TIMEOUT
+ * @brief The time in milliseconds to wait for an answer to the \#get_status sent to
+ * probe an unresponsive camera.
+ */
+#ifndef GEOLUX_BREAKER_PROBE_TIMEOUT
+#define GEOLUX_BREAKER_PROBE_TIMEOUT 500L
+#endif
+
 /// The baud rate of RS232 communication on the HydroCAM; fixed at 115200
 #define GEOLUX_CAMERA_RS232_BAUD 115200
 /// The character bit configuration on the HydroCAM; fixed as 8N1
@@ -121,6 +199,57 @@ static const char GEOLUX_BUSY[] GEOLUX_PROGMEM = "BUSY\r\n";
 /// A "NONE" response from the camera
 static const char GEOLUX_NONE[] GEOLUX_PROGMEM = "NONE\r\n";
 
+// The commands sent to the camera and the tags of the values in its \#get_info
+// response, each stored once and shared by every function that sends or reads them
+static const char GEOLUX_CMD_TAKE_SNAPSHOT[] GEOLUX_PROGMEM = "take_snapshot";
+static const char GEOLUX_CMD_GET_STATUS[] GEOLUX_PROGMEM = "get_status";
+static const char GEOLUX_CMD_GET_IMAGE[] GEOLUX_PROGMEM = "get_image";
+static const char GEOLUX_CMD_GET_INFO[] GEOLUX_PROGMEM = "get_info";
+static const char GEOLUX_CMD_RESET[] GEOLUX_PROGMEM = "reset";
+static const char GEOLUX_CMD_SLEEP[] GEOLUX_PROGMEM = "sleep";
+static const char GEOLUX_CMD_RUN_AUTOFOCUS[] GEOLUX_PROGMEM = "run_autofocus";
+static const char GEOLUX_CMD_MOVE_FOCUS[] GEOLUX_PROGMEM = "move_focus";
+static const char GEOLUX_CMD_MOVE_ZOOM[] GEOLUX_PROGMEM = "move_zoom";
+static const char GEOLUX_CMD_SET_RESOLUTION[] GEOLUX_PROGMEM = "set_resolution";
+static const char GEOLUX_CMD_SET_QUALITY[] GEOLUX_PROGMEM = "set_quality";
+static const char GEOLUX_CMD_SET_JPEG_MAXIMUM_SIZE[] GEOLUX_PROGMEM =
+    "set_jpeg_maximum_size";
+static const char GEOLUX_CMD_SET_NIGHT_MODE[] GEOLUX_PROGMEM = "set_night_mode";
+static const char GEOLUX_CMD_SET_IR_LED_MODE[] GEOLUX_PROGMEM = "set_ir_led_mode";
+static const char GEOLUX_CMD_SET_AUTOFOCUS_POINT[] GEOLUX_PROGMEM =
+    "set_autofocus_point";
+static const char GEOLUX_CMD_SET_AUTOEXPOSURE_REGION[] GEOLUX_PROGMEM =
+    "set_autoexposure_region";
+static const char GEOLUX_CMD_SET_WB_OFFSET[] GEOLUX_PROGMEM = "set_wb_offset";
+static const char GEOLUX_CMD_SET_COLOR_CORRECTION_MODE[] GEOLUX_PROGMEM =
+    "set_color_correction_mod";
+static const char GEOLUX_CMD_SET_AUTO_SNAPSHOT_INTERVAL[] GEOLUX_PROGMEM =
+    "set_auto_snapshot_interval";
+static const char GEOLUX_TAG_DEVICE_TYPE[] GEOLUX_PROGMEM = "#device_type:";
+static const char GEOLUX_TAG_FIRMWARE[] GEOLUX_PROGMEM = "#firmware:";
+static const char GEOLUX_TAG_SERIAL_ID[] GEOLUX_PROGMEM = "#serial_id:";
+static const char GEOLUX_TAG_RESOLUTION[] GEOLUX_PROGMEM = "#resolution:";
+static const char GEOLUX_TAG_QUALITY[] GEOLUX_PROGMEM = "#quality:";
+static const char GEOLUX_TAG_JPEG_MAXIMUM_SIZE[] GEOLUX_PROGMEM = "#jpeg_maximum_size:";
+static const char GEOLUX_TAG_NIGHT_MODE[] GEOLUX_PROGMEM = "#night_mode:";
+static const char GEOLUX_TAG_IR_LED_MODE[] GEOLUX_PROGMEM = "#ir_led_mode:";
+static const char GEOLUX_TAG_IR_FILTER[] GEOLUX_PROGMEM = "#ir_filter:";
+static const char GEOLUX_TAG_AUTOFOCUS_POINT[] GEOLUX_PROGMEM = "#autofocus_point:";
+static const char GEOLUX_TAG_AUTOEXPOSURE_REGION[] GEOLUX_PROGMEM =
+    "#autoexposure_region:";
+static const char GEOLUX_TAG_EXPOSURE[] GEOLUX_PROGMEM = "#exposure:";
+static const char GEOLUX_TAG_IMAGE_BRIGHTNESS[] GEOLUX_PROGMEM = "#image_brightness:";
+static const char GEOLUX_TAG_WB_OFFSET[] GEOLUX_PROGMEM = "#wb_offset:";
+static const char GEOLUX_TAG_COLOR_CORRECTION_MODE[] GEOLUX_PROGMEM =
+    "#color_correction_mode:";
+static const char GEOLUX_TAG_AUTO_SNAPSHOT_INTERVAL[] GEOLUX_PROGMEM =
+    "#auto_snapshot_interval:";
+static const char GEOLUX_TAG_FOCUS_POSITION[] GEOLUX_PROGMEM = "#focus_position:";
+static const char GEOLUX_TAG_ZOOM_POSITION[] GEOLUX_PROGMEM = "#zoom_position:";
+
+/// Room for a whole "#get_image=<offset>,<length>,RAW" request and its line ending
+static const size_t GEOLUX_CHUNK_REQUEST_SIZE = sizeof(GEOLUX_CMD_GET_IMAGE) + 30;
+
 /**
  * @brief The class for the Geolux HydroCAM
  */
@@ -134,6 +263,7 @@ class GeoluxCamera {
         ERROR,            ///< Status is in error
         BUSY,             ///< Status is "BUSY"
         NONE,             ///< Status is "NONE" or unknown
+        REBOOTED,         ///< The camera printed its start-up banner instead
     } geolux_status;
     /// The possible camera IR filter (day/night) modes
     typedef enum {
@@ -152,6 +282,25 @@ class GeoluxCamera {
         IR_AUTO,    ///< In auto mode, the IR LEDs are active only during image
                     ///< acquisition, autofocus or manual zoom or focus operations.
     } geolux_ir_mode;
+    /// @brief A compact fingerprint of an image, used to recognize repeated frames
+    typedef struct {
+        int32_t  image_size;     ///< The size of the image
+        uint32_t prefix_crc;     ///< The CRC-32 of the start of the image
+        uint16_t prefix_length;  ///< The number of bytes covered by the prefix CRC
+    } geolux_fingerprint;
+    /// @brief The camera settings and identity reported by a single \#get_info
+    typedef struct {
+        char     device_type[16];  ///< The device type
+        char     firmware[16];     ///< The firmware version
+        uint32_t serial_number;    ///< The serial number
+        char     resolution[12];   ///< The image resolution
+        int8_t   quality;          ///< The JPEG compression quality
+        uint32_t exposure;         ///< The exposure time, in the camera's units
+        uint32_t brightness;       ///< The mean image brightness
+        char     ir_filter[8];     ///< The IR filter state, "day" or "night"
+        int16_t  focus_position;   ///< The focus position
+        int8_t   zoom_position;    ///< The zoom position
+    } geolux_info;
 
     /**
      * @brief Construct a new GeoluxCamera object - no action needed
@@ -165,6 +314,17 @@ class GeoluxCamera {
     GeoluxCamera(Stream* stream);
     /** @copydoc GeoluxCamera::GeoluxCamera(Stream* stream) */
     GeoluxCamera(Stream& stream);
+    /**
+     * @brief Construct a new GeoluxCamera object with stream attached and its own
+     * timeouts.
+     *
+     * @param stream The stream instance the camera is attached to
+     * @param timeouts The timeouts to use while talking to the camera
+     */
+    GeoluxCamera(Stream* stream, const GeoluxTimeouts& timeouts);
+    /** @copydoc GeoluxCamera::GeoluxCamera(Stream* stream,
+     * const GeoluxTimeouts& timeouts) */
+    GeoluxCamera(Stream& stream, const GeoluxTimeouts& timeouts);
 
     /**
      * @brief Destroy the GeoluxCamera object - no action needed
@@ -262,6 +422,44 @@ class GeoluxCamera {
      */
     uint32_t getImageChunk(uint8_t* buf, size_t offset, size_t length);
 
+    /**
+     * @brief Send a request for a chunk of image data without waiting for any of the
+     * data to arrive.
+     *
+     * Read the data as it arrives with readImageData(). The camera will send two bytes
+     * of junk followed by the requested data - see the warnings on getImageChunk().
+     *
+     * @param offset The offset of the chunk
+     * @param length The length of data to request
+     */
+    void requestImageChunk(size_t offset, size_t length);
+    /**
+     * @brief Read whatever data has already arrived from the camera, without waiting
+     * for more.
+     *
+     * This reads through the Stream pointer; GeoluxCameraT hides it with a version
+     * that reads through the stream's own class.
+     *
+     * @param buf A buffer to store the data in
+     * @param max_length The maximum number of bytes to read
+     * @return The number of bytes read
+     */
+    size_t readImageData(uint8_t* buf, size_t max_length);
+    /**
+     * @brief Check data read with readImageData() for the camera's start-up banner.
+     *
+     * The answers to commands sent by this class are always checked for the banner,
+     * but data read directly with readImageData() is not. Pass it here to recognize a
+     * reset in the same way. The match carries over from one call to the next, so a
+     * banner split between two reads is still found.
+     *
+     * @param buf The data read
+     * @param length The number of bytes read
+     * @return True if the data completed the banner; the reset has then been noted
+     * and wasRebooted() is true
+     */
+    bool checkForBanner(const uint8_t* buf, size_t length);
+
 
     /**
      * @brief Transfer the image data from the camera stream to a secondary stream (like
@@ -273,7 +471,7 @@ class GeoluxCamera {
      * image size is given, the resulting file will not be usable.
      * @param chunk_size The size of chunks to use while talking to the camera; optional
      * with a default value of #DEFAULT_XFER_CHUNK_SIZE.
-     * @return
+     * @return The number of bytes written to the secondary stream
      */
     uint32_t transferImage(Stream* xferStream, int32_t image_size = 0,
                            int32_t chunk_size = DEFAULT_XFER_CHUNK_SIZE);
@@ -284,6 +482,140 @@ class GeoluxCamera {
      */
     uint32_t transferImage(Stream& xferStream, int32_t image_size = 0,
                            int32_t chunk_size = DEFAULT_XFER_CHUNK_SIZE);
+    /**
+     * @brief Transfer the image data from the camera stream to an image sink.
+     *
+     * The sink is told the image size before the first byte is written and the number
+     * of bytes written after the last one, so stages like a GeoluxDigestSink can
+     * process the image as it streams past.
+     *
+     * @param sink The image sink to transfer data to
+     * @param image_size The size of image data to transfer. If not specified, the
+     * getImageSize() function is used to query to size from the camera.
+     * @param chunk_size The size of chunks to use while talking to the camera; optional
+     * with a default value of #DEFAULT_XFER_CHUNK_SIZE.
+     * @return The number of bytes written to the sink; 0 if the sink refused the image
+     */
+    uint32_t transferImage(GeoluxImageSink* sink, int32_t image_size = 0,
+                           int32_t chunk_size = DEFAULT_XFER_CHUNK_SIZE);
+    /**
+     * @copydoc GeoluxCamera::transferImage(GeoluxImageSink* sink, int32_t image_size,
+     * int32_t chunk_size)
+     */
+    uint32_t transferImage(GeoluxImageSink& sink, int32_t image_size = 0,
+                           int32_t chunk_size = DEFAULT_XFER_CHUNK_SIZE);
+
+    /**
+     * @brief Transfer the image to an image sink only if it is not a repeat of the
+     * last image transferred.
+     *
+     * The start of the image is read into the given buffer with getImageChunk() and
+     * the image size and a CRC of those bytes are compared to the fingerprint of the
+     * last image that was transferred in full. If they match, the rest of the image
+     * is never requested and nothing is written to the sink. Otherwise the buffered
+     * bytes are written out and the transfer carries on from where they ended, since
+     * the camera cannot re-send them.
+     *
+     * Use this with setAutoSnapshotInterval() or fixed interval captures, where the
+     * camera often returns the same frame again.
+     *
+     * @param sink The image sink to transfer data to
+     * @param buf A buffer to hold the start of the image
+     * @param prefix_length The number of bytes to compare; the buffer must hold at
+     * least this many. Larger prefixes catch more changes but cost more to read for a
+     * repeated image.
+     * @param image_size The size of image data to transfer. If not specified, the
+     * getImageSize() function is used to query to size from the camera.
+     * @param chunk_size The size of chunks to use while talking to the camera; optional
+     * with a default value of #DEFAULT_XFER_CHUNK_SIZE.
+     * @return The number of bytes written to the sink; 0 if the image was a repeat or
+     * the transfer failed
+     */
+    uint32_t transferNewImage(GeoluxImageSink* sink, uint8_t* buf, size_t prefix_length,
+                              int32_t image_size = 0,
+                              int32_t chunk_size = DEFAULT_XFER_CHUNK_SIZE);
+    /**
+     * @copydoc GeoluxCamera::transferNewImage(GeoluxImageSink* sink, uint8_t* buf,
+     * size_t prefix_length, int32_t image_size, int32_t chunk_size)
+     */
+    uint32_t transferNewImage(GeoluxImageSink& sink, uint8_t* buf, size_t prefix_length,
+                              int32_t image_size = 0,
+                              int32_t chunk_size = DEFAULT_XFER_CHUNK_SIZE);
+    /**
+     * @brief Check whether the last call to transferNewImage() skipped a repeated
+     * image.
+     *
+     * @return True if the last image was a repeat, otherwise false
+     */
+    bool lastImageWasDuplicate();
+    /**
+     * @brief Get the fingerprint of the last image transferred in full by
+     * transferNewImage().
+     *
+     * @return The fingerprint of the last image
+     */
+    geolux_fingerprint getLastFingerprint();
+    /**
+     * @brief Forget the fingerprint of the last image, so the next image is always
+     * transferred.
+     */
+    void clearFingerprint();
+
+    /**
+     * @brief Read just the start of the current image and describe it from its JPEG
+     * header.
+     *
+     * The first bytes of the image are read into the given buffer with
+     * getImageChunk() and the frame header and quantization tables are parsed from
+     * them, giving the image dimensions, number of components and estimated quality
+     * from one small transfer. A few hundred bytes is normally enough; 512 leaves room
+     * for the Huffman tables the camera writes after the frame header.
+     *
+     * The camera cannot re-send the bytes that were read, so keep the buffer if the
+     * rest of the image may be wanted and finish the transfer with resumeTransfer().
+     *
+     * @param buf A buffer to hold the start of the image
+     * @param length The number of bytes to read; the buffer must hold at least this
+     * many. Don't request more than the size of the image.
+     * @param header The structure to fill in; the width is 0 if no frame header was
+     * found in the bytes read
+     * @return The number of bytes read into the buffer
+     */
+    uint32_t inspectImage(uint8_t* buf, size_t length,
+                          GeoluxJpeg::geolux_jpeg_header* header);
+    /**
+     * @copydoc GeoluxCamera::inspectImage(uint8_t* buf, size_t length,
+     * GeoluxJpeg::geolux_jpeg_header* header)
+     */
+    uint32_t inspectImage(uint8_t* buf, size_t length,
+                          GeoluxJpeg::geolux_jpeg_header& header);
+    /**
+     * @brief Transfer an image to an image sink when its start has already been read
+     * from the camera.
+     *
+     * The bytes already read, usually by inspectImage(), are written to the sink first
+     * and the transfer carries on from where they ended. If the sink doesn't take all
+     * of them, the transfer stops there, since the camera cannot re-send them.
+     *
+     * @param sink The image sink to transfer data to
+     * @param prefix The start of the image, already read from the camera
+     * @param prefix_length The number of bytes in the prefix
+     * @param image_size The size of image data to transfer. If not specified, the
+     * getImageSize() function is used to query to size from the camera.
+     * @param chunk_size The size of chunks to use while talking to the camera; optional
+     * with a default value of #DEFAULT_XFER_CHUNK_SIZE.
+     * @return The number of bytes written to the sink; 0 if the sink refused the image
+     */
+    uint32_t resumeTransfer(GeoluxImageSink* sink, const uint8_t* prefix,
+                            size_t prefix_length, int32_t image_size = 0,
+                            int32_t chunk_size = DEFAULT_XFER_CHUNK_SIZE);
+    /**
+     * @copydoc GeoluxCamera::resumeTransfer(GeoluxImageSink* sink, const uint8_t*
+     * prefix, size_t prefix_length, int32_t image_size, int32_t chunk_size)
+     */
+    uint32_t resumeTransfer(GeoluxImageSink& sink, const uint8_t* prefix,
+                            size_t prefix_length, int32_t image_size = 0,
+                            int32_t chunk_size = DEFAULT_XFER_CHUNK_SIZE);
 
     /**
      * @brief Restart the module
@@ -292,6 +624,146 @@ class GeoluxCamera {
      */
     bool restart();
 
+    /**
+     * @brief Check whether the camera has reset itself since the last
+     * recoverFromReboot().
+     *
+     * A reset is recognized by the "Geolux HydroCAM" banner the camera prints when it
+     * starts. When the banner arrives in place of a response, the command fails at
+     * once: getStatus() returns #REBOOTED, waitForReady() and the setters return
+     * failure and an image transfer stops with the bytes written so far.
+     *
+     * @return True if an unexpected reset was seen, otherwise false
+     */
+    bool wasRebooted();
+    /**
+     * @brief Get the number of unexpected resets seen.
+     *
+     * @return The number of resets
+     */
+    uint16_t getRebootCount();
+    /**
+     * @brief Get the time from the last reset to the camera being ready again.
+     *
+     * This is measured by the first waitForReady() after a restart() or an unexpected
+     * reset.
+     *
+     * @return The time in milliseconds, or 0 if it hasn't been measured
+     */
+    uint32_t getResetToReadyTime();
+    /**
+     * @brief Wait for the camera to be ready after an unexpected reset and re-apply
+     * the settings set since the program started.
+     *
+     * @param timeout The maximum time in milliseconds to wait for the camera
+     * @return True if the camera is ready and all settings were re-applied, otherwise
+     * false
+     */
+    bool recoverFromReboot(uint32_t timeout = 30000L);
+    /**
+     * @brief Re-apply the last resolution, quality, JPEG maximum size, night mode, IR
+     * LED mode, autofocus point, autoexposure region, white balance offset, color
+     * correction mode and auto snapshot interval successfully set, one after the
+     * other, and wait once for the camera to apply them.
+     *
+     * @param timeout The maximum time in milliseconds to wait for the camera
+     * @return True if every setting was accepted, otherwise false
+     */
+    bool restoreSettings(uint32_t timeout = 30000L);
+    /**
+     * @brief Send one of the settings to re-apply after a reset without waiting for
+     * the answer.
+     *
+     * The settings are sent in the same order as by restoreSettings(). Start with
+     * step 0 and, once the camera has answered, pass the returned step plus one to
+     * send the next setting.
+     *
+     * @param step The first step to consider
+     * @return The step of the setting that was sent, or -1 if there are no more
+     * settings to send
+     */
+    int8_t sendSetting(uint8_t step);
+    /**
+     * @brief Note that the camera is ready again after an unexpected reset, without
+     * re-applying its settings.
+     *
+     * This is for callers that wait for the camera and send its settings with
+     * sendSetting() themselves instead of calling recoverFromReboot().
+     */
+    void acknowledgeReboot();
+    /**
+     * @brief Forget the settings to re-apply after a reset.
+     */
+    void forgetSettings();
+    /**
+     * @brief Set whether takeSnapshot() calls recoverFromReboot() first when an
+     * unexpected reset was seen.
+     *
+     * @param auto_recover True to recover automatically; defaults to true
+     */
+    void setAutoRecover(bool auto_recover);
+
+    /**
+     * @brief Check whether the camera is being treated as unresponsive.
+     *
+     * After #GEOLUX_BREAKER_THRESHOLD commands in a row get no answer at all, the
+     * camera is treated as unresponsive and commands fail at once, without being
+     * sent and without waiting out their timeouts. Once the cooldown has passed, the
+     * next command first sends a single \#get_status with a short timeout; if the
+     * camera answers, commands are sent normally again.
+     *
+     * @return True if commands are failing without being sent, otherwise false
+     */
+    bool isUnresponsive();
+    /**
+     * @brief Get the number of commands in a row that have gone unanswered.
+     *
+     * @return The number of unanswered commands
+     */
+    uint8_t getMissedResponses();
+    /**
+     * @brief Set how many commands in a row can go unanswered before the camera is
+     * treated as unresponsive.
+     *
+     * @param misses The number of unanswered commands; 0 to never stop sending
+     * commands
+     */
+    void setUnresponsiveThreshold(uint8_t misses);
+    /**
+     * @brief Set how long to wait before probing an unresponsive camera again.
+     *
+     * @param cooldown_ms The time in milliseconds
+     */
+    void setUnresponsiveCooldown(uint32_t cooldown_ms);
+    /**
+     * @brief Forget any unanswered commands and send the next command normally.
+     *
+     * Call this after powering the camera on.
+     */
+    void resetResponsiveness();
+    /**
+     * @brief Send the \#get_status probe to an unresponsive camera without waiting
+     * for the answer.
+     *
+     * Commands probe an unresponsive camera themselves, waiting up to
+     * #GEOLUX_BREAKER_PROBE_TIMEOUT for the answer. Use this and checkProbe() instead
+     * when that wait can't be afforded, as in GeoluxCameraGroup. The answer to the
+     * probe is left in the stream to be read.
+     *
+     * @return True if the probe was sent; false if the camera isn't treated as
+     * unresponsive or the cooldown hasn't passed
+     */
+    bool startProbe();
+    /**
+     * @brief Check whether the camera has answered the probe sent by startProbe().
+     *
+     * @return 1 if the camera answered and commands are sent normally again, 0 if it
+     * didn't answer in time or no probe was sent to an unresponsive camera, and -1
+     * while the probe is still waiting for an answer
+     */
+    int8_t checkProbe();
+
+#if GEOLUX_ENABLE_INFO
     /**
      * @brief Prints information about the camera the the input stream.
      *
@@ -300,6 +772,20 @@ class GeoluxCamera {
     void printCameraInfo(Stream* outStream);
     /** @copydoc GeoluxCamera::printCameraInfo(Stream* stream) */
     void printCameraInfo(Stream& outStream);
+    /**
+     * @brief Read the camera's identity and current settings with a single \#get_info
+     * command.
+     *
+     * Each of the individual getters sends its own \#get_info and reads through the
+     * whole response, so use this instead when more than one value is needed.
+     *
+     * @param info The structure to fill in; fields the camera did not report are left
+     * empty or zero
+     * @return True if any information was read, otherwise false
+     */
+    bool getCameraInfo(geolux_info* info);
+    /** @copydoc GeoluxCamera::getCameraInfo(geolux_info* info) */
+    bool getCameraInfo(geolux_info& info);
     /**
      * @brief Get the camera's device type.
      *
@@ -318,7 +804,9 @@ class GeoluxCamera {
      * @return The serial number
      */
     uint32_t getCameraSerialNumber();
+#endif
 
+#if GEOLUX_ENABLE_OPTICS
     /**
      * @brief This command starts the process of moving the lens focus and searching for
      * sharpest image around the center point defined and stored with the
@@ -331,6 +819,7 @@ class GeoluxCamera {
      * @return True if the autofocus started successfully, otherwise false
      */
     bool runAutofocus();
+#endif
 
     /**
      * @brief This command changes the image resolution.
@@ -411,6 +900,7 @@ class GeoluxCamera {
      */
     uint32_t getJPEGMaximumSize();
 
+#if GEOLUX_ENABLE_COLOR
     /**
      * @brief Changes the camera mode according to the given MODE parameter which can be
      * either day, night or auto.
@@ -467,7 +957,7 @@ class GeoluxCamera {
      * the night, and off during the day. In auto mode, the IR LEDs are active only
      * during image acquisition, autofocus or manual zoom or focus operations.
      *
-     * @param mode The mode as characters, must be one of "day", "night", or "auto".
+     * @param mode The mode as characters, must be one of "on", "off", or "auto".
      * @return True if the IR LED mode was successfully changed, otherwise false
      */
     bool setIRLEDMode(const char* mode);
@@ -484,7 +974,9 @@ class GeoluxCamera {
      * (in day mode)
      */
     bool getIRFilterStatus();
+#endif
 
+#if GEOLUX_ENABLE_OPTICS
     /**
      * @brief Configures the point used for the autofocus operation.
      *
@@ -516,7 +1008,9 @@ class GeoluxCamera {
      * bottom
      */
     int8_t getAutofocusY();
+#endif
 
+#if GEOLUX_ENABLE_COLOR
     /**
      * @brief Configures the area used to measure brightness for the auto-exposure
      * operation.
@@ -642,6 +1136,7 @@ class GeoluxCamera {
      * @return True if color correction is being applied, otherwise false
      */
     bool getColorCorrectionMode();
+#endif
 
     /**
      * @brief Sets the time interval in minutes for autonomous periodic snapshot
@@ -671,6 +1166,7 @@ class GeoluxCamera {
      */
     uint32_t getAutoSnapshotInterval();
 
+#if GEOLUX_ENABLE_OPTICS
     /**
      * @brief This command forces the camera to move the focus of the lens for a given
      * number of steps.
@@ -709,6 +1205,7 @@ class GeoluxCamera {
      * @return The current zoom position
      */
     int8_t getZoomPosition();
+#endif
 
     /**
      * @brief Put the module to sleep, starting from the time the command is
@@ -736,6 +1233,10 @@ class GeoluxCamera {
      */
     template <typename... Args>
     inline void sendCommand(Args... cmd) {
+        // don't send anything to a camera that isn't answering
+        _command_blocked = !allowCommand();
+        if (_command_blocked) { return; }
+        _command_start = millis();
         streamWrite("#", cmd..., "\r\n");
         _stream->flush();
     }
@@ -751,11 +1252,77 @@ class GeoluxCamera {
      * status; optional with a default value of 0. The inital delay is useful to avoid
      * hammering the camera with status requests after starting an operation known to be
      * slow - like autofocus.
-     * @param timeout The maximum number of milliseconds to wait; optional with a
-     * default of 60,000 (1 minute)
+     * @param timeout The maximum number of milliseconds to wait; optional. If 0 or not
+     * given, the ready timeout of the camera's timeouts is used, by default 60,000 (1
+     * minute).
      * @return The number of milliseconds waited, or 0 if the operation timed out
      */
-    uint32_t waitForReady(uint32_t initial_delay = 0, uint32_t timeout = 60000L);
+    uint32_t waitForReady(uint32_t initial_delay = 0, uint32_t timeout = 0);
+
+    /**
+     * @brief Set the timeouts used while talking to the camera.
+     *
+     * @param timeouts The timeouts to use
+     */
+    void setTimeouts(const GeoluxTimeouts& timeouts);
+    /**
+     * @brief Get the timeouts used while talking to the camera.
+     *
+     * The values can be changed in place through the returned reference.
+     *
+     * @return The timeouts
+     */
+    GeoluxTimeouts& getTimeouts();
+
+    /**
+     * @brief Attach a set of latency histograms to the camera.
+     *
+     * Once attached, the response time of every command and the time spent in
+     * waitForReady() after each type of operation is recorded in the histograms.
+     *
+     * @param stats The latency stats to record to, or nullptr to stop recording
+     */
+    void setLatencyStats(GeoluxLatencyStats* stats);
+    /**
+     * @brief Get the latency histograms attached to the camera.
+     *
+     * @return The attached latency stats, or nullptr if none are attached
+     */
+    GeoluxLatencyStats* getLatencyStats();
+    /**
+     * @brief Attach an event log to the camera.
+     *
+     * Once attached, image transfers record what happens during each chunk to the
+     * log, at the level set by #GEOLUX_LOG_LEVEL, instead of printing it while the
+     * image is arriving. Print the log with GeoluxEventLog::printEvents() after the
+     * transfer.
+     *
+     * @param log The event log to record to, or nullptr to stop recording
+     */
+    void setEventLog(GeoluxEventLog* log);
+    /**
+     * @brief Get the event log attached to the camera.
+     *
+     * @return The attached event log, or nullptr if none is attached
+     */
+    GeoluxEventLog* getEventLog();
+    /**
+     * @brief Attach a capture planner to the camera.
+     *
+     * Once attached, the time spent in waitForReady() after each snapshot and settings
+     * change, the time and size of each image transfer, and the resolution and
+     * quality whenever they are set or read with getCameraInfo() are reported to the
+     * planner.
+     *
+     * @param planner The planner to report to, or nullptr to stop reporting
+     */
+    void setCapturePlanner(GeoluxCapturePlanner* planner);
+    /**
+     * @brief Get the capture planner attached to the camera.
+     *
+     * @return The attached planner, or nullptr if none is attached
+     */
+    GeoluxCapturePlanner* getCapturePlanner();
 
     /**
      * @brief Listen for responses to commands and handle URCs
@@ -770,7 +1337,8 @@ class GeoluxCamera {
      * of "BUSY"
      * @param r4 The fourth output to test against, optional with a default value
      * of "NONE"
-     * @return *int8_t* the index of the response input
+     * @return *int8_t* the index of the response input, or #REBOOTED if the
+     * camera's start-up banner arrived instead
      */
     int8_t waitResponse(uint32_t timeout_ms, String& data,
                         GsmConstStr r1 = GFP(GEOLUX_OK),
@@ -790,7 +1358,8 @@ class GeoluxCamera {
      * of NULL
      * @param r4 The fourth output to test against, optional with a default value
      * of NULL
-     * @return *int8_t* the index of the response input
+     * @return *int8_t* the index of the response input, or #REBOOTED if the
+     * camera's start-up banner arrived instead
      */
     int8_t waitResponse(uint32_t timeout_ms, GsmConstStr r1 = GFP(GEOLUX_OK),
                         GsmConstStr r2 = GFP(GEOLUX_ERROR),
@@ -809,13 +1378,24 @@ class GeoluxCamera {
      * of NULL
      * @param r4 The fourth output to test against, optional with a default value
      * of NULL
-     * @return *int8_t* the index of the response input
+     * @return *int8_t* the index of the response input, or #REBOOTED if the
+     * camera's start-up banner arrived instead
      */
     int8_t waitResponse(GsmConstStr r1 = GFP(GEOLUX_OK),
                         GsmConstStr r2 = GFP(GEOLUX_ERROR),
                         GsmConstStr r3 = GFP(GEOLUX_BUSY),
                         GsmConstStr r4 = GFP(GEOLUX_NONE));
 
+    /**
+     * @brief Listen for the default responses to a command and record the command's
+     * latency if there is a response.
+     *
+     * @param command The type of command that was sent
+     * @return *int8_t* the index of the response input, or #REBOOTED if the
+     * camera's start-up banner arrived instead
+     */
+    int8_t waitCommandResponse(GeoluxLatencyStats::geolux_command command);
+
     /**
      * @brief Utility template for writing on a stream
      *
@@ -853,14 +1433,146 @@ class GeoluxCamera {
      * @brief Read a throw away any characters left in the camera stream.
      */
     inline void streamDump() {
-        if (!_stream->available()) { delay(25); }
+        if (!_stream->available()) { delay(_timeouts.dump_wait); }
         while (_stream->available()) {
             _stream->read();
-            delay(1);
+            delay(_timeouts.dump_gap);
         }
     }
 
  protected:
+    /**
+     * @brief Run the chunked transfer of an image whose size is already known.
+     *
+     * @param output The output to write the image data to
+     * @param image_size The size of image data to transfer
+     * @param chunk_size The size of chunks to use while talking to the camera
+     * @param start_offset The number of image bytes already read from the camera and
+     * written to the output; optional with a default of 0.
+     * @return The number of bytes written to the output, including any already
+     * written before the start offset
+     */
+    uint32_t transferImageData(Print* output, int32_t image_size, int32_t chunk_size,
+                               int32_t start_offset = 0);
+
+    /**
+     * @brief A stream of a known class, called without going through its vtable.
+     *
+     * Each call is qualified by the stream's class, so it is an ordinary function
+     * call that the compiler can inline.
+     *
+     * @tparam StreamT The exact class of the stream
+     */
+    template <class StreamT>
+    struct TypedStream {
+        StreamT* stream;  ///< The stream, as its own class
+
+        /// @brief The number of bytes waiting to be read
+        int available() {
+            return stream->StreamT::available();
+        }
+        /// @brief Read one byte, or -1 if there is none
+        int read() {
+            return stream->StreamT::read();
+        }
+        /// @brief Write a buffer one byte at a time
+        size_t write(const uint8_t* buf, size_t size) {
+            size_t written = 0;
+            while (written < size && stream->StreamT::write(buf[written])) {
+                written++;
+            }
+            return written;
+        }
+        /// @brief Wait for any outgoing data to be sent
+        void flush() {
+            stream->StreamT::flush();
+        }
+    };
+
+    /**
+     * @brief Run image transfers through the concrete class of the stream.
+     *
+     * Used by GeoluxCameraT. The typed transfer is only used while the camera is
+     * still attached to this stream; after begin() with another stream, transfers go
+     * back through the Stream pointer.
+     *
+     * @tparam StreamT The exact class of the stream
+     * @param stream The stream the camera is attached to
+     */
+    template <class StreamT>
+    void useTypedStream(StreamT* stream) {
+        _typed_stream   = stream;
+        _typed_transfer = &GeoluxCamera::typedTransfer<StreamT>;
+    }
+    /**
+     * @brief Run the chunked transfer of an image through the stream set by
+     * useTypedStream().
+     *
+     * @copydetails transferImageData(Print* output, int32_t image_size,
+     * int32_t chunk_size, int32_t start_offset)
+     */
+    template <class StreamT>
+    static uint32_t typedTransfer(GeoluxCamera* camera, Print* output,
+                                  int32_t image_size, int32_t chunk_size,
+                                  int32_t start_offset) {
+        TypedStream<StreamT> port = {static_cast<StreamT*>(camera->_typed_stream)};
+        return camera->transferImageDataFrom(&port, output, image_size, chunk_size,
+                                             start_offset);
+    }
+    /**
+     * @brief Run the chunked transfer of an image, talking to the camera through the
+     * given port.
+     *
+     * @tparam PortT Stream for calls through the vtable, or a TypedStream
+     * @param port The stream the camera is attached to
+     * @copydetails transferImageData(Print* output, int32_t image_size,
+     * int32_t chunk_size, int32_t start_offset)
+     */
+    template <class PortT>
+    uint32_t transferImageDataFrom(PortT* port, Print* output, int32_t image_size,
+                                   int32_t chunk_size, int32_t start_offset);
+    /**
+     * @brief Read whatever data has already arrived through the given port, without
+     * waiting for more.
+     *
+     * @tparam PortT Stream for calls through the vtable, or a TypedStream
+     * @param port The stream the camera is attached to
+     * @param buf A buffer to store the data in
+     * @param max_length The maximum number of bytes to read
+     * @return The number of bytes read
+     */
+    template <class PortT>
+    size_t readImageDataFrom(PortT* port, uint8_t* buf, size_t max_length);
+    /**
+     * @brief Send a request for a chunk of image data through the given port.
+     *
+     * @tparam PortT Stream for calls through the vtable, or a TypedStream
+     * @param port The stream the camera is attached to
+     * @param offset The offset of the chunk
+     * @param length The length of data to request
+     */
+    template <class PortT>
+    void requestImageChunkFrom(PortT* port, int32_t offset, int32_t length);
+    /**
+     * @brief Wait for data through the given port after a command.
+     *
+     * @tparam PortT Stream for calls through the vtable, or a TypedStream
+     * @param port The stream the camera is attached to
+     * @copydetails waitForData(uint32_t start_time, uint32_t timeout, int min_bytes)
+     */
+    template <class PortT>
+    bool waitForDataFrom(PortT* port, uint32_t start_time, uint32_t timeout,
+                         int min_bytes = 1);
+    /**
+     * @brief Write the request for a chunk of image data into a buffer.
+     *
+     * @param buf The buffer to write to; at least #GEOLUX_CHUNK_REQUEST_SIZE bytes
+     * @param offset The offset of the chunk
+     * @param length The length of data to request
+     * @return The length of the request, without any terminating null
+     */
+    static size_t formatChunkRequest(char* buf, int32_t offset, int32_t length);
+
     /**
      * @brief Find a target character within a stream.
      *
@@ -872,7 +1584,7 @@ class GeoluxCamera {
     inline bool streamFind(char target) {
         // shorten the stream timeout so we're not waiting forever for a partial chunk
         uint32_t prev_timeout = _stream->getTimeout();
-        _stream->setTimeout(15L);
+        _stream->setTimeout(_timeouts.stream);
         bool resp = _stream->find(const_cast<char*>(&target), 1);
         // reset the stream timeout
         _stream->setTimeout(prev_timeout);
@@ -883,7 +1595,7 @@ class GeoluxCamera {
      * @brief Get a string within the camera info output.
      *
      * @param searchStartTag The tag/characters preceding the desired info - this should
-     * be the text string for the desired information.
+     * be one of the GEOLUX_TAG strings, in flash on AVR boards.
      * @param searchEndTag The tag/characters proceeding the desired info - optional
      * with a default of '\\r'.
      * @param numberSkips The number of times to skip the skip character. This is used
@@ -894,13 +1606,13 @@ class GeoluxCamera {
      * comma or other delimeter.  Optional with a default value of ','.
      * @return The string between the start and end tags.
      */
-    String getCameraInfoString(const char* searchStartTag, char searchEndTag = '\r',
+    String getCameraInfoString(GsmConstStr searchStartTag, char searchEndTag = '\r',
                                int8_t numberSkips = 0, const char* searchSkipTag = ",");
     /**
      * @brief Get integer within the camera info output.
      *
      * @param searchStartTag The tag/characters preceding the desired info - this should
-     * be the text string for the desired information.
+     * be one of the GEOLUX_TAG strings, in flash on AVR boards.
      * @param searchEndTag The tag/characters proceeding the desired info - optional
      * with a default of '\\r'.
      * @param numberSkips The number of times to skip the skip character. This is used
@@ -911,13 +1623,419 @@ class GeoluxCamera {
      * comma or other delimeter.  Optional with a default value of ','.
      * @return The integer between the start and end tags.
      */
-    long getCameraInfoInt(const char* searchStartTag, char searchEndTag = '\r',
+    long getCameraInfoInt(GsmConstStr searchStartTag, char searchEndTag = '\r',
                           int8_t numberSkips = 0, const char* searchSkipTag = ",");
 
+    /**
+     * @brief Record the latency of the last command sent, if latency stats are
+     * attached, and remember which operation any following waitForReady() is for.
+     *
+     * @param command The type of command that was sent
+     */
+    void recordCommand(GeoluxLatencyStats::geolux_command command);
+
     /**
      * @brief The stream instance (serial port) for communication over RS232
      */
     Stream* _stream;
+    /**
+     * @brief The timeouts used while talking to the camera
+     */
+    GeoluxTimeouts _timeouts;
+    /**
+     * @brief The latency histograms to record to, if any
+     */
+    GeoluxLatencyStats* _latency_stats = nullptr;
+    /**
+     * @brief The event log to record to, if any
+     */
+    GeoluxEventLog* _event_log = nullptr;
+    /**
+     * @brief The capture planner to report to, if any
+     */
+    GeoluxCapturePlanner* _capture_planner = nullptr;
+    /**
+     * @brief The millis() time the last command was sent
+     */
+    uint32_t _command_start = 0;
+    /**
+     * @brief The type of the last operation that the camera may still be busy with
+     */
+    GeoluxLatencyStats::geolux_wait _last_operation = GeoluxLatencyStats::WAIT_OTHER;
+    /**
+     * @brief The fingerprint of the last image transferred in full by
+     * transferNewImage()
+     */
+    geolux_fingerprint _last_fingerprint = {0, 0, 0};
+    /**
+     * @brief True if the last call to transferNewImage() skipped a repeated image
+     */
+    bool _last_was_duplicate = false;
+
+    /// @brief The settings to re-apply after a reset
+    typedef struct {
+        uint16_t set;              ///< A bit for each setting that has been set
+        char     resolution[12];   ///< The resolution
+        int8_t   quality;          ///< The JPEG quality
+        uint16_t jpeg_max_size;    ///< The JPEG maximum size in kB
+        int8_t   night_mode;       ///< The night mode
+        int8_t   ir_led_mode;      ///< The IR LED mode
+        int8_t   autofocus[2];     ///< The autofocus point
+        int8_t   autoexposure[4];  ///< The autoexposure region
+        int8_t   wb_offset[3];     ///< The white balance offset
+        int8_t   color_mode;       ///< The color correction mode
+        uint32_t auto_interval;    ///< The auto snapshot interval
+    } geolux_settings;
+
+    /**
+     * @brief Check a byte from the camera against the start-up banner.
+     *
+     * @param b The byte
+     * @return True if the byte completes the banner, otherwise false
+     */
+    bool matchBanner(uint8_t b);
+    /**
+     * @brief Check whether a command may be sent, probing an unresponsive camera if
+     * the cooldown has passed.
+     *
+     * @return True if the command may be sent, otherwise false
+     */
+    bool allowCommand();
+    /**
+     * @brief Wait for data from the camera after a command.
+     *
+     * @param start_time The millis() time the command was sent
+     * @param timeout The maximum time in milliseconds to wait
+     * @param min_bytes The number of bytes to wait for
+     * @return True if any data arrived, false if the command wasn't sent or there was
+     * no answer
+     */
+    bool waitForData(uint32_t start_time, uint32_t timeout, int min_bytes = 1);
+    /**
+     * @brief Note whether the camera answered a command.
+     *
+     * @param answered True if anything came back, false if the command timed out
+     */
+    void recordAnswer(bool answered);
+    /**
+     * @brief Note an unexpected reset of the camera.
+     */
+    void noteReboot();
+
+    /**
+     * @brief The settings to re-apply after a reset
+     */
+    geolux_settings _settings = {};
+    /**
+     * @brief The number of banner characters matched so far
+     */
+    uint8_t _banner_match = 0;
+    /**
+     * @brief True if an unexpected reset was seen and not yet recovered from
+     */
+    bool _rebooted = false;
+    /**
+     * @brief True to recover from a reset at the next snapshot
+     */
+    bool _auto_recover = true;
+    /**
+     * @brief The number of unexpected resets seen
+     */
+    uint16_t _reboot_count = 0;
+    /**
+     * @brief The millis() time of the last reset
+     */
+    uint32_t _reboot_millis = 0;
+    /**
+     * @brief The time from the last reset to the camera being ready
+     */
+    uint32_t _reset_to_ready = 0;
+    /**
+     * @brief True if the last command wasn't sent because the camera is unresponsive
+     */
+    bool _command_blocked = false;
+    /**
+     * @brief True if the camera is treated as unresponsive
+     */
+    bool _unresponsive = false;
+    /**
+     * @brief The number of commands in a row that have gone unanswered
+     */
+    uint8_t _missed_responses = 0;
+    /**
+     * @brief The number of unanswered commands before the camera is unresponsive
+     */
+    uint8_t _unresponsive_threshold = GEOLUX_BREAKER_THRESHOLD;
+    /**
+     * @brief The time to wait before probing an unresponsive camera
+     */
+    uint32_t _unresponsive_cooldown = GEOLUX_BREAKER_COOLDOWN;
+    /**
+     * @brief The millis() time the camera was last found unresponsive
+     */
+    uint32_t _unresponsive_since = 0;
+    /**
+     * @brief True while a probe sent by startProbe() is waiting for an answer
+     */
+    bool _probing = false;
+    /**
+     * @brief The millis() time the last probe was sent
+     */
+    uint32_t _probe_start = 0;
+    /**
+     * @brief The typed transfer set by useTypedStream(), if any
+     */
+    uint32_t (*_typed_transfer)(GeoluxCamera* camera, Print* output, int32_t image_size,
+                                int32_t chunk_size, int32_t start_offset) = nullptr;
+    /**
+     * @brief The stream the typed transfer was set up for
+     */
+    Stream* _typed_stream = nullptr;
 };
 
+template <class PortT>
+size_t GeoluxCamera::readImageDataFrom(PortT* port, uint8_t* buf,
+                                       size_t max_length) {
+    size_t bytes_read = 0;
+    while (bytes_read < max_length) {
+        // ask how much has arrived once, not before every byte
+        int available = port->available();
+        if (available <= 0) { break; }
+        while (available-- > 0 && bytes_read < max_length) {
+            buf[bytes_read++] = static_cast<uint8_t>(port->read());
+        }
+    }
+    return bytes_read;
+}
+
+template <class PortT>
+void GeoluxCamera::requestImageChunkFrom(PortT* port, int32_t offset, int32_t length) {
+    // don't send anything to a camera that isn't answering
+    _command_blocked = !allowCommand();
+    if (_command_blocked) { return; }
+    _command_start = millis();
+    char   request[GEOLUX_CHUNK_REQUEST_SIZE];
+    size_t request_length = formatChunkRequest(request, offset, length);
+    port->write(reinterpret_cast<const uint8_t*>(request), request_length);
+    port->flush();
+}
+
+template <class PortT>
+bool GeoluxCamera::waitForDataFrom(PortT* port, uint32_t start_time, uint32_t timeout,
+                                   int min_bytes) {
+    if (_command_blocked) { return false; }
+    while (port->available() < min_bytes && millis() - start_time < timeout);
+    bool answered = port->available() > 0;
+    recordAnswer(answered);
+    return answered;
+}
+
+template <class PortT>
+uint32_t GeoluxCamera::transferImageDataFrom(PortT* port, Print* output,
+                                             int32_t image_size, int32_t chunk_size,
+                                             int32_t start_offset) {
+    // bool got_start_tag        = false;
+    // bool got_end_tag          = false;
+    // bool got_matching_bytes   = false;
+    // bool hit_zeros            = false;
+    // bool all_chunks_succeeded = true;
+
+    uint32_t max_command_response = 0;
+    uint32_t max_char_spacing     = 0;
+
+    // Read all the data up to # bytes!
+    int32_t total_bytes_read    = start_offset;  // for the number of bytes read
+    int32_t total_bytes_written = start_offset;  // for the number of bytes written
+    int32_t start_data_byte =
+        2;  // the first two bytes are header and don't belong in the file
+    int32_t extra_read_buff =
+        12;  // extra chars to read to ensure we get the closing tag
+    int32_t bytes_remaining =
+        image_size + start_data_byte + extra_read_buff - start_offset;
+    int32_t chunk_number     = 0;
+    int32_t start_next_chunk = start_offset;
+    // int32_t chunks_needed    = ceil(image_size / chunk_size);
+    ;
+    uint8_t prev_bytes[4] = {0, 0, 0, 0};
+    bool    eof           = false;
+    bool    rebooted      = false;
+    bool    timed_out     = false;
+    _banner_match         = 0;
+
+    uint32_t start_xfer_millis = millis();
+    uint32_t transfer_timeout  = _timeouts.transferTimeout(image_size - start_offset,
+                                                           chunk_size);
+    GEOLUX_LOG_INFO(_event_log, GeoluxEventLog::EVT_TRANSFER_START, image_size,
+                    chunk_size, start_offset);
+#if GEOLUX_LOG_LEVEL >= 3
+    // the image bytes to log, packed four to an event
+    uint32_t packed_bytes = 0;
+    uint8_t  packed_count = 0;
+#endif
+
+    while (!eof && !rebooted && millis() - start_xfer_millis < transfer_timeout) {
+        int32_t bytesToRead =
+            min(chunk_size,
+                static_cast<int32_t>(max(bytes_remaining, static_cast<int32_t>(1))));
+        int32_t bytes_read    = 0;
+        int32_t bytes_written = 0;
+
+        uint32_t start_command_millis = millis();
+        requestImageChunkFrom(port, start_next_chunk, bytesToRead);
+        if (!waitForDataFrom(port, start_command_millis, _timeouts.response)) {
+            GEOLUX_LOG_ERROR(_event_log, GeoluxEventLog::EVT_NO_RESPONSE,
+                             chunk_number, start_next_chunk);
+            // stop retrying once the camera is treated as unresponsive
+            if (_command_blocked || _unresponsive) { break; }
+            continue;
+        }
+        uint32_t response_time = millis() - start_command_millis;
+        max_command_response   = max(max_command_response, response_time);
+        GEOLUX_LOG_INFO(_event_log, GeoluxEventLog::EVT_CHUNK, chunk_number,
+                        start_next_chunk, response_time);
+
+        int32_t i = 0;
+        while (i < bytesToRead + start_data_byte && !rebooted && !timed_out) {
+            uint32_t start_avail_time = millis();
+            // wait for the next character
+            while (!port->available() &&
+                   millis() - start_avail_time < _timeouts.char_gap);
+            // take everything that has arrived at once, rather than a call per byte
+            uint8_t batch[GEOLUX_XFER_BATCH_SIZE];
+            int32_t wanted       = bytesToRead + start_data_byte - i;
+            size_t  batch_length = readImageDataFrom(
+                port, batch,
+                wanted < static_cast<int32_t>(sizeof(batch)) ? wanted : sizeof(batch));
+            if (!batch_length) {
+                GEOLUX_LOG_ERROR(_event_log, GeoluxEventLog::EVT_NO_DATA,
+                                 chunk_number, bytes_read);
+                break;
+            }
+            max_char_spacing = max(max_char_spacing,
+                                   static_cast<uint32_t>(millis() - start_avail_time));
+            // the run of bytes in the batch still to be written to the output
+            size_t run_start  = 0;
+            size_t run_length = 0;
+            for (size_t n = 0; n < batch_length; n++, i++) {
+                uint8_t b = batch[n];
+                bytes_read++;
+                total_bytes_read++;
+                if (matchBanner(b)) {
+                    // the camera reset itself; the rest of the image is gone
+                    noteReboot();
+                    GEOLUX_LOG_ERROR(_event_log, GeoluxEventLog::EVT_REBOOT,
+                                     total_bytes_read);
+                    rebooted = true;
+                    break;
+                }
+
+                if (total_bytes_written >= image_size && b == 0) {
+                    if (!eof) {
+                        GEOLUX_LOG_INFO(_event_log, GeoluxEventLog::EVT_PADDING,
+                                        total_bytes_written);
+                    }
+                    eof = true;
+                    // hit_zeros = true;
+                }
+                if (i >= start_data_byte && !eof) {
+                    if (!run_length) { run_start = n; }
+                    run_length++;
+                    bytes_written++;
+                    total_bytes_written++;
+#if GEOLUX_LOG_LEVEL >= 3
+                    // keep the first and last 16 bytes of the image
+                    if (_event_log &&
+                        (total_bytes_written <= 16 ||
+                         total_bytes_written > image_size - 16)) {
+                        packed_bytes = packed_bytes << 8 | b;
+                        packed_count++;
+                        if (packed_count == 4 || total_bytes_written == 16 ||
+                            total_bytes_written == image_size) {
+                            GEOLUX_LOG_DETAIL(_event_log,
+                                              GeoluxEventLog::EVT_IMAGE_BYTES,
+                                              total_bytes_written - packed_count,
+                                              static_cast<int32_t>(packed_bytes),
+                                              packed_count);
+                            packed_bytes = 0;
+                            packed_count = 0;
+                        }
+                    }
+#endif
+                } else if (run_length) {
+                    output->write(&batch[run_start], run_length);
+                    run_length = 0;
+                }
+
+                if (millis() - start_xfer_millis > transfer_timeout) {
+                    GEOLUX_LOG_ERROR(_event_log, GeoluxEventLog::EVT_TIMEOUT,
+                                     total_bytes_written, transfer_timeout);
+                    // stop with the bytes written so far, the rest won't come in time
+                    timed_out = true;
+                    break;
+                }
+
+                uint8_t j = total_bytes_read % 4;
+                uint8_t k = total_bytes_read % 4 - 1;
+                if (k == static_cast<uint8_t>(-1)) { k = 3; }
+                prev_bytes[j] = b;
+                if ((b == 0xD9) && ((char)prev_bytes[k] == (char)0xFF)) {
+                    eof = 1;
+                    // got_end_tag = true;
+                    GEOLUX_LOG_INFO(_event_log, GeoluxEventLog::EVT_END_TAG,
+                                    total_bytes_written);
+                }
+                if ((b == 0xD8) && ((char)prev_bytes[k] == (char)0xFF)) {
+                    eof = 0;
+                    // got_start_tag = true;
+                    GEOLUX_LOG_INFO(_event_log, GeoluxEventLog::EVT_START_TAG,
+                                    total_bytes_written);
+                }
+            }
+            if (run_length) { output->write(&batch[run_start], run_length); }
+        }
+        recordCommand(GeoluxLatencyStats::CMD_GET_IMAGE);
+        bytes_remaining -= min(bytes_read, bytesToRead);
+        start_next_chunk += min(bytes_read, bytesToRead);
+        chunk_number++;
+
+        // if (bytes_read == 0) { break; }
+        if (eof) { break; }
+        if (bytes_read - start_data_byte != bytesToRead ||
+            bytes_written != bytesToRead) {
+            GEOLUX_LOG_ERROR(_event_log, GeoluxEventLog::EVT_SHORT_CHUNK, bytesToRead,
+                             bytes_read, bytes_written);
+            // all_chunks_succeeded = false;
+        }
+    }
+
+#if GEOLUX_LOG_LEVEL >= 3
+    // log any bytes still packed when the image ended early at its end tag
+    if (packed_count) {
+        GEOLUX_LOG_DETAIL(_event_log, GeoluxEventLog::EVT_IMAGE_BYTES,
+                          total_bytes_written - packed_count,
+                          static_cast<int32_t>(packed_bytes), packed_count);
+    }
+#endif
+
+    uint32_t transfer_time = millis() - start_xfer_millis;
+    GEOLUX_LOG_INFO(_event_log, GeoluxEventLog::EVT_TRANSFER_END, total_bytes_written,
+                    transfer_time, chunk_number);
+    if (_capture_planner && total_bytes_written > start_offset) {
+        _capture_planner->recordTransfer(total_bytes_written - start_offset,
+                                         transfer_time, chunk_size, image_size);
+    }
+
+    DBG_GLX(GF("Used"), chunk_number, GF("chunks to read"), total_bytes_read,
+            GF("bytes in"), chunk_size, GF("bytes chunks."));
+    DBG_GLX(GF("Wrote"), total_bytes_written, GF("of expected"), image_size,
+            GF("bytes to the SD card - a difference of"),
+            abs(total_bytes_written - image_size), GF("bytes"));
+    DBG_GLX(GF("Total transfer time was"), transfer_time, GF("ms"));
+    DBG_GLX(GF("The maximum response time after a request was"), max_command_response,
+            GF("and the maximum spacing between characters was"), max_char_spacing);
+
+
+    return static_cast<uint32_t>(total_bytes_written);
+}
+
 #endif  // SRC_GEOLUXCAMERA_H_
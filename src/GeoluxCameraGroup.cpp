@@ -0,0 +1,519 @@
+/**
+ * @file       GeoluxCameraGroup.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#include "GeoluxCameraGroup.h"
+
+// GeoluxCameraGroup::camera_slot::setting while the camera is coming back up
+static const int8_t SETTING_NOT_STARTED = -1;
+// GeoluxCameraGroup::camera_slot::setting once every setting has been accepted
+static const int8_t SETTING_ALL_SENT = INT8_MAX;
+
+GeoluxCameraGroup::GeoluxCameraGroup() : _camera_count(0), _next_camera(0) {
+    for (uint8_t i = 0; i < GEOLUX_GROUP_BUFFER_COUNT; i++) { _buffer_used[i] = false; }
+}
+
+bool GeoluxCameraGroup::addCamera(GeoluxCamera* camera, Print* xferOutput) {
+    if (_camera_count >= GEOLUX_GROUP_MAX_CAMERAS) { return false; }
+    camera_slot& slot = _slots[_camera_count++];
+    slot.camera       = camera;
+    slot.output       = xferOutput;
+    slot.state        = IDLE;
+    slot.buffer       = -1;
+    slot.image_size   = 0;
+    slot.written      = 0;
+    slot.requested    = 0;
+    slot.received     = 0;
+    slot.awaiting     = false;
+    slot.failures     = 0;
+    slot.setting      = SETTING_NOT_STARTED;
+    // recovering one camera must not hold up the rest of the group
+    camera->setAutoRecover(false);
+    return true;
+}
+
+bool GeoluxCameraGroup::addCamera(GeoluxCamera& camera, Print& xferOutput) {
+    return addCamera(&camera, &xferOutput);
+}
+
+void GeoluxCameraGroup::setOutput(uint8_t index, Print* xferOutput) {
+    if (index < _camera_count) { _slots[index].output = xferOutput; }
+}
+
+void GeoluxCameraGroup::setOutput(uint8_t index, Print& xferOutput) {
+    setOutput(index, &xferOutput);
+}
+
+uint8_t GeoluxCameraGroup::getCameraCount() {
+    return _camera_count;
+}
+
+bool GeoluxCameraGroup::startCapture() {
+    // hold off the cameras until post-processing has caught up
+    if (_stage_count && GEOLUX_GROUP_QUEUE_SIZE - _queue_count < _camera_count) {
+        DBG_GLX(GF("Post-processing queue is full, not starting a capture"));
+        return false;
+    }
+    bool any_started = false;
+    for (uint8_t i = 0; i < _camera_count; i++) {
+        camera_slot& slot = _slots[i];
+        releaseBuffer(slot);
+        slot.image_size = 0;
+        slot.written    = 0;
+        slot.failures   = 0;
+        slot.awaiting   = false;
+        if (slot.camera->wasRebooted()) {
+            // restore the settings from service() rather than holding up the rest
+            startRecovery(slot);
+            any_started = true;
+            continue;
+        }
+        triggerCamera(slot);
+        if (slot.state == TRIGGERING || slot.state == RECOVERING) {
+            any_started = true;
+        } else {
+            DBG_GLX(GF("Camera"), i, GF("did not start a snapshot"));
+        }
+    }
+    return any_started;
+}
+
+void GeoluxCameraGroup::triggerCamera(camera_slot& slot) {
+    if (slot.camera->isUnresponsive()) {
+        // probe it from service() instead of letting the command block on the probe
+        startRecovery(slot);
+        sendPoll(slot);
+        return;
+    }
+    slot.camera->sendCommand(GFP(GEOLUX_CMD_TAKE_SNAPSHOT));
+    slot.state       = TRIGGERING;
+    slot.state_start = millis();
+    slot.awaiting    = true;
+    slot.line_length = 0;
+    slot.deadline    = slot.state_start + slot.camera->getTimeouts().response;
+}
+
+void GeoluxCameraGroup::startRecovery(camera_slot& slot) {
+    slot.state       = RECOVERING;
+    slot.state_start = millis();
+    slot.setting     = SETTING_NOT_STARTED;
+    slot.awaiting    = false;
+    // poll the camera right away, it may have come back up long ago
+    slot.deadline = slot.state_start;
+}
+
+void GeoluxCameraGroup::recoverCamera(camera_slot& slot) {
+    if (slot.setting != SETTING_NOT_STARTED && slot.setting != SETTING_ALL_SENT) {
+        // the answer to a setting
+        if (strcmp(slot.line, "OK") != 0) {
+            DBG_GLX(GF("Camera did not accept a setting after a reset:"), slot.line);
+            slot.state = FAILED;
+            return;
+        }
+        sendNextSetting(slot, slot.setting + 1);
+        return;
+    }
+    // the answer to a status poll; the camera is ready once it has nothing to do
+    if (strncmp(slot.line, "READY", 5) != 0 && strcmp(slot.line, "NONE") != 0) {
+        slot.deadline = millis() + _poll_interval;
+        return;
+    }
+    if (slot.setting == SETTING_NOT_STARTED && slot.camera->wasRebooted()) {
+        slot.camera->acknowledgeReboot();
+        sendNextSetting(slot, 0);
+    } else {
+        triggerCamera(slot);
+    }
+}
+
+void GeoluxCameraGroup::sendNextSetting(camera_slot& slot, uint8_t step) {
+    slot.setting = slot.camera->sendSetting(step);
+    if (slot.setting >= 0) {
+        slot.awaiting    = true;
+        slot.line_length = 0;
+        slot.deadline    = millis() + slot.camera->getTimeouts().response;
+        return;
+    }
+    if (!step) {
+        // there was nothing to re-apply and the camera is already ready
+        triggerCamera(slot);
+        return;
+    }
+    // poll until the camera has applied the settings
+    slot.setting  = SETTING_ALL_SENT;
+    slot.deadline = millis() + _poll_interval;
+}
+
+bool GeoluxCameraGroup::service() {
+    if (!_camera_count) { return false; }
+    for (uint8_t k = 0; k < _camera_count; k++) {
+        camera_slot& slot = _slots[(_next_camera + k) % _camera_count];
+        if (slot.state == RECOVERING || slot.state == TRIGGERING ||
+            slot.state == WAITING) {
+            pollCamera(slot);
+        }
+    }
+    if (!_round_active) { startRound(); }
+    if (_round_active && !receiveRound()) {
+        finishRound();
+        // start with the next camera on the next round so no port is always last
+        _next_camera = (_next_camera + 1) % _camera_count;
+        startRound();
+    }
+
+    bool active       = false;
+    bool transferring = false;
+    for (uint8_t i = 0; i < _camera_count; i++) {
+        geolux_group_state state = _slots[i].state;
+        if (state == RECOVERING || state == TRIGGERING || state == WAITING) {
+            active = true;
+        }
+        if (state == TRANSFERRING) { transferring = true; }
+    }
+    if (!transferring) { processJob(); }
+    return active || transferring;
+}
+
+uint32_t GeoluxCameraGroup::getIdleTime() {
+    uint32_t now       = millis();
+    uint32_t idle_time = UINT32_MAX;
+    bool     in_flight = false;
+    for (uint8_t i = 0; i < _camera_count; i++) {
+        camera_slot& slot = _slots[i];
+        if (slot.state == TRANSFERRING && !slot.awaiting) {
+            // a new round can start right away if there isn't one going
+            if (!_round_active) { return 0; }
+            continue;
+        }
+        if (slot.state != RECOVERING && slot.state != TRIGGERING &&
+            slot.state != WAITING && slot.state != TRANSFERRING) {
+            continue;
+        }
+        if (slot.state == TRANSFERRING) { in_flight = true; }
+        if (pastDeadline(slot)) { return 0; }
+        idle_time = min(idle_time, static_cast<uint32_t>(slot.deadline - now));
+    }
+    // the round is over and waiting to be written out
+    if (_round_active && !in_flight) { return 0; }
+    // queued post-processing can run now
+    if (!_round_active && _queue_count) { return 0; }
+    return idle_time;
+}
+
+bool GeoluxCameraGroup::addStage(image_stage stage, void* context) {
+    if (_stage_count >= GEOLUX_GROUP_MAX_STAGES) { return false; }
+    _stages[_stage_count]         = stage;
+    _stage_contexts[_stage_count] = context;
+    _stage_count++;
+    return true;
+}
+
+bool GeoluxCameraGroup::processJob() {
+    if (!_queue_count) { return false; }
+    image_job& job        = _queue[_queue_head];
+    uint8_t    stage      = job.next_stage++;
+    bool       keep_going = _stages[stage](job, _stage_contexts[stage]);
+    if (!keep_going || job.next_stage >= _stage_count) {
+        _queue_head = (_queue_head + 1) % GEOLUX_GROUP_QUEUE_SIZE;
+        _queue_count--;
+    }
+    return true;
+}
+
+uint8_t GeoluxCameraGroup::getQueuedJobs() {
+    return _queue_count;
+}
+
+void GeoluxCameraGroup::finishImage(uint8_t index) {
+    camera_slot& slot = _slots[index];
+    slot.state        = DONE;
+    releaseBuffer(slot);
+    if (!_stage_count) { return; }
+    if (_queue_count >= GEOLUX_GROUP_QUEUE_SIZE) {
+        DBG_GLX(GF("Post-processing queue overflowed, dropping image from camera"),
+                index);
+        return;
+    }
+    image_job& job = _queue[(_queue_head + _queue_count) % GEOLUX_GROUP_QUEUE_SIZE];
+    job.camera     = index;
+    job.output     = slot.output;
+    job.image_size = slot.image_size;
+    job.next_stage = 0;
+    _queue_count++;
+}
+
+uint8_t GeoluxCameraGroup::captureAll(uint32_t timeout) {
+    uint32_t start_millis = millis();
+    if (startCapture()) {
+        while (service() && millis() - start_millis < timeout) {}
+    }
+    _round_active = false;
+
+    uint8_t done = 0;
+    for (uint8_t i = 0; i < _camera_count; i++) {
+        camera_slot& slot = _slots[i];
+        if (slot.state != IDLE && slot.state != DONE && slot.state != FAILED) {
+            DBG_GLX(GF("Camera"), i, GF("timed out!"));
+            releaseBuffer(slot);
+            slot.state = FAILED;
+        }
+        if (slot.state == DONE) { done++; }
+    }
+    DBG_GLX(GF("Captured"), done, GF("of"), _camera_count, GF("cameras in"),
+            millis() - start_millis, GF("ms"));
+    return done;
+}
+
+GeoluxCameraGroup::geolux_group_state GeoluxCameraGroup::getState(uint8_t index) {
+    if (index >= _camera_count) { return IDLE; }
+    return _slots[index].state;
+}
+
+int32_t GeoluxCameraGroup::getImageSize(uint8_t index) {
+    if (index >= _camera_count) { return 0; }
+    return _slots[index].image_size;
+}
+
+uint32_t GeoluxCameraGroup::getBytesTransferred(uint8_t index) {
+    if (index >= _camera_count) { return 0; }
+    return static_cast<uint32_t>(_slots[index].written);
+}
+
+void GeoluxCameraGroup::setPollInterval(uint32_t interval) {
+    _poll_interval = interval;
+}
+
+void GeoluxCameraGroup::setSnapshotTimeout(uint32_t timeout) {
+    _snapshot_timeout = timeout;
+}
+
+bool GeoluxCameraGroup::pastDeadline(camera_slot& slot) {
+    return static_cast<int32_t>(millis() - slot.deadline) >= 0;
+}
+
+bool GeoluxCameraGroup::sendPoll(camera_slot& slot) {
+    slot.line_length = 0;
+    if (!slot.camera->isUnresponsive()) {
+        slot.camera->sendCommand(GFP(GEOLUX_CMD_GET_STATUS));
+        slot.awaiting = true;
+        slot.deadline = millis() + slot.camera->getTimeouts().response;
+        return true;
+    }
+    if (!slot.camera->startProbe()) {
+        DBG_GLX(GF("Camera isn't answering"));
+        slot.state    = FAILED;
+        slot.awaiting = false;
+        return false;
+    }
+    slot.awaiting = true;
+    slot.deadline = millis() + GEOLUX_BREAKER_PROBE_TIMEOUT;
+    return true;
+}
+
+void GeoluxCameraGroup::pollCamera(camera_slot& slot) {
+    if (slot.awaiting && slot.camera->isUnresponsive()) {
+        // only the answer to a probe brings back a camera that stopped answering
+        int8_t answered = slot.camera->checkProbe();
+        if (answered < 0) { return; }
+        if (!answered) {
+            DBG_GLX(GF("Camera still isn't answering"));
+            slot.state    = FAILED;
+            slot.awaiting = false;
+            return;
+        }
+    }
+    // take whatever has arrived, checking it all for the start-up banner
+    uint8_t c;
+    while (slot.camera->readImageData(&c, 1)) {
+        if (slot.camera->checkForBanner(&c, 1)) {
+            // the snapshot or the settings are gone, start the recovery over
+            DBG_GLX(GF("Camera reset before its image was ready"));
+            uint32_t state_start = slot.state_start;
+            bool     recovering  = slot.state == RECOVERING;
+            startRecovery(slot);
+            // don't let a camera that keeps resetting recover forever
+            if (recovering) { slot.state_start = state_start; }
+            // give it time to start up, throwing away the rest of the banner
+            slot.deadline = millis() + _poll_interval;
+            continue;
+        }
+        // throw away anything that isn't an answer to a command
+        if (!slot.awaiting) { continue; }
+        if (c == '\n') {
+            if (!slot.line_length) { continue; }
+            slot.line[slot.line_length] = '\0';
+            parseStatus(slot);
+            return;
+        }
+        if (c != '\r' && slot.line_length < sizeof(slot.line) - 1) {
+            slot.line[slot.line_length++] = static_cast<char>(c);
+        }
+    }
+    if (!slot.awaiting) {
+        if (!pastDeadline(slot)) { return; }
+        uint32_t timeout = slot.state == RECOVERING ? slot.camera->getTimeouts().ready
+                                                    : _snapshot_timeout;
+        if (millis() - slot.state_start > timeout) {
+            DBG_GLX(GF("Snapshot timed out!"));
+            slot.state = FAILED;
+            return;
+        }
+        sendPoll(slot);
+        return;
+    }
+    if (pastDeadline(slot)) {
+        if (slot.state == TRIGGERING) {
+            DBG_GLX(GF("Camera did not answer the snapshot command"));
+            slot.state = FAILED;
+            return;
+        }
+        if (slot.state == RECOVERING && slot.setting != SETTING_NOT_STARTED &&
+            slot.setting != SETTING_ALL_SENT) {
+            DBG_GLX(GF("Camera did not answer a setting after a reset"));
+            slot.state = FAILED;
+            return;
+        }
+        // no response, try again on the next poll
+        slot.awaiting = false;
+        slot.deadline = millis() + _poll_interval;
+    }
+}
+
+void GeoluxCameraGroup::parseStatus(camera_slot& slot) {
+    slot.awaiting = false;
+    if (slot.state == RECOVERING) {
+        recoverCamera(slot);
+        return;
+    }
+    if (slot.state == TRIGGERING) {
+        if (strcmp(slot.line, "OK") == 0) {
+            slot.state       = WAITING;
+            slot.state_start = millis();
+            slot.deadline    = slot.state_start + _poll_interval;
+        } else {
+            DBG_GLX(GF("Camera did not start a snapshot:"), slot.line);
+            slot.state = FAILED;
+        }
+        return;
+    }
+    // a finished snapshot is reported as "READY,<image size>"
+    if (strncmp(slot.line, "READY", 5) == 0 && slot.line[5] == ',') {
+        int32_t image_size = atol(&slot.line[6]);
+        if (image_size > 0) {
+            slot.image_size  = image_size;
+            slot.written     = 0;
+            slot.state       = TRANSFERRING;
+            slot.state_start = millis();
+            return;
+        }
+    }
+    slot.deadline = millis() + _poll_interval;
+}
+
+void GeoluxCameraGroup::releaseBuffer(camera_slot& slot) {
+    if (slot.buffer >= 0) { _buffer_used[slot.buffer] = false; }
+    slot.buffer = -1;
+}
+
+void GeoluxCameraGroup::startRound() {
+    // hand out free buffers to the cameras that are ready to transfer
+    for (uint8_t k = 0; k < _camera_count; k++) {
+        camera_slot& slot = _slots[(_next_camera + k) % _camera_count];
+        if (slot.state != TRANSFERRING || slot.buffer >= 0) { continue; }
+        for (uint8_t b = 0; b < GEOLUX_GROUP_BUFFER_COUNT; b++) {
+            if (!_buffer_used[b]) {
+                _buffer_used[b] = true;
+                slot.buffer     = b;
+                break;
+            }
+        }
+    }
+
+    // request a chunk from every camera holding a buffer
+    for (uint8_t k = 0; k < _camera_count; k++) {
+        camera_slot& slot = _slots[(_next_camera + k) % _camera_count];
+        if (slot.state != TRANSFERRING || slot.buffer < 0) { continue; }
+        if (slot.camera->isUnresponsive()) {
+            DBG_GLX(GF("Camera stopped answering during the transfer"));
+            slot.state = FAILED;
+            releaseBuffer(slot);
+            continue;
+        }
+        slot.requested = static_cast<uint16_t>(
+            min(static_cast<int32_t>(GEOLUX_GROUP_BUFFER_SIZE),
+                slot.image_size - slot.written));
+        slot.received = 0;
+        slot.awaiting = true;
+        slot.camera->requestImageChunk(slot.written, slot.requested);
+        // wait longer for the camera to start responding than between characters
+        slot.deadline = millis() + slot.camera->getTimeouts().response;
+        _round_active = true;
+    }
+}
+
+bool GeoluxCameraGroup::receiveRound() {
+    // nothing may be written out until the round is over or the other ports will
+    // overflow
+    bool waiting = false;
+    for (uint8_t k = 0; k < _camera_count; k++) {
+        camera_slot& slot = _slots[(_next_camera + k) % _camera_count];
+        if (slot.state != TRANSFERRING || slot.buffer < 0 || !slot.awaiting) {
+            continue;
+        }
+        size_t bytes_read = slot.camera->readImageData(
+            &_buffers[slot.buffer][slot.received], slot.requested + 2 - slot.received);
+        if (slot.camera->checkForBanner(&_buffers[slot.buffer][slot.received],
+                                        bytes_read)) {
+            // the rest of the image is gone; the camera is recovered at the next
+            // capture
+            DBG_GLX(GF("Camera reset during the transfer after"), slot.written,
+                    GF("bytes"));
+            slot.state    = FAILED;
+            slot.awaiting = false;
+            releaseBuffer(slot);
+            continue;
+        }
+        if (bytes_read) {
+            slot.received += bytes_read;
+            slot.deadline = millis() + slot.camera->getTimeouts().char_gap;
+        }
+        if (slot.received >= slot.requested + 2 || pastDeadline(slot)) {
+            slot.awaiting = false;
+        } else {
+            waiting = true;
+        }
+    }
+    return waiting;
+}
+
+void GeoluxCameraGroup::finishRound() {
+    _round_active = false;
+    for (uint8_t k = 0; k < _camera_count; k++) {
+        uint8_t      index = (_next_camera + k) % _camera_count;
+        camera_slot& slot  = _slots[index];
+        if (slot.state != TRANSFERRING || slot.buffer < 0) { continue; }
+        // the first two bytes of every chunk are junk
+        uint16_t data_bytes = slot.received > 2 ? slot.received - 2 : 0;
+        if (data_bytes) {
+            slot.output->write(&_buffers[slot.buffer][2], data_bytes);
+            slot.written += data_bytes;
+            slot.failures = 0;
+        } else {
+            slot.failures++;
+        }
+        if (slot.written >= slot.image_size) {
+            finishImage(index);
+        } else if (slot.failures >= 3 ||
+                   millis() - slot.state_start >
+                       slot.camera->getTimeouts().transferTimeout(
+                           slot.image_size, GEOLUX_GROUP_BUFFER_SIZE)) {
+            DBG_GLX(GF("Transfer failed after"), slot.written, GF("of"),
+                    slot.image_size, GF("bytes"));
+            slot.state = FAILED;
+            releaseBuffer(slot);
+        }
+    }
+}
@@ -0,0 +1,401 @@
+/**
+ * @file       GeoluxCameraGroup.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Contains a manager to capture and transfer images from several cameras on
+ * separate serial ports at the same time.
+ */
+
+#ifndef SRC_GEOLUXCAMERAGROUP_H_
+#define SRC_GEOLUXCAMERAGROUP_H_
+
+#include <Arduino.h>
+#include "GeoluxCamera.h"
+
+/**
+ * @def GEOLUX_GROUP_MAX_CAMERAS
+ * @brief The maximum number of cameras in a camera group.
+ */
+#ifndef GEOLUX_GROUP_MAX_CAMERAS
+#define GEOLUX_GROUP_MAX_CAMERAS 3
+#endif
+
+/**
+ * @def GEOLUX_GROUP_BUFFER_SIZE
+ * @brief The size of each transfer buffer in the group's shared pool; this is also the
+ * size of the chunks requested from the cameras.
+ *
+ * Every chunk that is requested must fit in processor memory because no data can be
+ * written out while another camera may be sending. Larger buffers mean fewer chunk
+ * requests.
+ */
+#ifndef GEOLUX_GROUP_BUFFER_SIZE
+#if defined(__AVR__) || defined(ARDUINO_ARCH_AVR)
+#define GEOLUX_GROUP_BUFFER_SIZE 128
+#else
+#define GEOLUX_GROUP_BUFFER_SIZE 512
+#endif
+#endif
+
+/**
+ * @def GEOLUX_GROUP_BUFFER_COUNT
+ * @brief The number of transfer buffers in the group's shared pool.
+ *
+ * Only cameras that are currently transferring hold a buffer. If there are fewer
+ * buffers than cameras, cameras that finish their snapshots late share the buffers
+ * freed by cameras that finish transferring early.
+ */
+#ifndef GEOLUX_GROUP_BUFFER_COUNT
+#define GEOLUX_GROUP_BUFFER_COUNT GEOLUX_GROUP_MAX_CAMERAS
+#endif
+
+/**
+ * @def GEOLUX_GROUP_MAX_STAGES
+ * @brief The maximum number of post-processing stages run on each finished image.
+ */
+#ifndef GEOLUX_GROUP_MAX_STAGES
+#define GEOLUX_GROUP_MAX_STAGES 4
+#endif
+
+/**
+ * @def GEOLUX_GROUP_QUEUE_SIZE
+ * @brief The number of finished images that can wait for post-processing.
+ *
+ * When the queue can't hold an image from every camera, startCapture() refuses to
+ * start a new round until enough queued images have been processed.
+ */
+#ifndef GEOLUX_GROUP_QUEUE_SIZE
+#define GEOLUX_GROUP_QUEUE_SIZE (2 * GEOLUX_GROUP_MAX_CAMERAS)
+#endif
+
+/**
+ * @brief A group of cameras on separate serial ports that are captured together.
+ *
+ * The group sends the snapshot command to every camera at once, polls the cameras for
+ * readiness round-robin, and transfers from all of the ready cameras in lock step: a
+ * chunk is requested from every transferring camera, the data is drained from every
+ * port as it arrives, and only once all of the chunks are in does any data get written
+ * out. The time for a capture round is close to the time for the slowest single camera
+ * rather than the sum of all of the cameras.
+ *
+ * The group never blocks inside startCapture() or service() while any camera is
+ * transferring. Snapshot commands, status requests and chunk requests are sent and
+ * their responses are picked up from each port as the bytes arrive, with each
+ * timeout kept as a deadline rather than a wait loop. Between calls to service(),
+ * getIdleTime() gives the time until the next deadline, so the caller can sleep until
+ * either serial data arrives or that much time has passed.
+ *
+ * Post-processing of finished images (hashing, validating, renaming, uploading) can be
+ * handed to the group as a list of stages. Each finished image is queued and its
+ * stages are run one at a time from service(), but only while no camera is
+ * transferring, so the serial ports are never left waiting on post-processing.
+ *
+ * Automatic recovery from unexpected resets is turned off on every camera added to
+ * the group, so that one reset camera can't hold up the snapshots of the others. A
+ * camera that has reset is instead recovered by service() in the same way as a
+ * snapshot is waited on: its status is polled until it is ready, its settings are
+ * re-applied one command at a time as each is answered, and it is then triggered on
+ * its own. Everything read from the cameras is checked for the start-up banner, so a
+ * camera that resets while taking its snapshot is recovered and triggered again at
+ * once, and one that resets while transferring fails without the banner being
+ * written into its image. A camera that GeoluxCamera has stopped sending commands to
+ * because it wasn't answering is never probed with a blocking command: it fails at
+ * once until its cooldown is over, and is then probed with
+ * GeoluxCamera::startProbe() and checked on each call to service().
+ */
+class GeoluxCameraGroup {
+
+ public:
+    /// @brief The state of each camera in the group
+    typedef enum {
+        IDLE = 0,      ///< No capture has been started
+        RECOVERING,    ///< Bringing back a camera that reset or stopped answering
+        TRIGGERING,    ///< Waiting for the camera to accept the snapshot command
+        WAITING,       ///< Waiting for the camera to finish the snapshot
+        TRANSFERRING,  ///< Transferring the image from the camera
+        DONE,          ///< The image was fully transferred
+        FAILED,        ///< The snapshot or transfer failed
+    } geolux_group_state;
+
+    /// @brief A finished image waiting for post-processing
+    typedef struct {
+        uint8_t camera;      ///< The index of the camera the image came from
+        Print*  output;      ///< The output the image was written to
+        int32_t image_size;  ///< The size of the image reported by the camera
+        uint8_t next_stage;  ///< The next post-processing stage to run
+    } image_job;
+
+    /**
+     * @brief A post-processing stage.
+     *
+     * @param job The finished image
+     * @param context The context pointer given when the stage was added
+     * @return True to go on to the next stage, false to stop processing this image
+     */
+    typedef bool (*image_stage)(image_job& job, void* context);
+
+    /**
+     * @brief Construct a new, empty, GeoluxCameraGroup object
+     */
+    GeoluxCameraGroup();
+
+    /**
+     * @brief Add a camera to the group.
+     *
+     * @param camera The camera to add; it must already be attached to its serial port.
+     * Its automatic recovery from resets is turned off.
+     * @param xferOutput The output to write the camera's images to
+     * @return True if the camera was added, false if the group is full
+     */
+    bool addCamera(GeoluxCamera* camera, Print* xferOutput);
+    /** @copydoc GeoluxCameraGroup::addCamera(GeoluxCamera* camera, Print* xferOutput)
+     */
+    bool addCamera(GeoluxCamera& camera, Print& xferOutput);
+    /**
+     * @brief Change where a camera's next image is written.
+     *
+     * @param index The index of the camera, in the order it was added
+     * @param xferOutput The output to write the camera's images to
+     */
+    void setOutput(uint8_t index, Print* xferOutput);
+    /** @copydoc GeoluxCameraGroup::setOutput(uint8_t index, Print* xferOutput) */
+    void setOutput(uint8_t index, Print& xferOutput);
+    /**
+     * @brief Get the number of cameras in the group.
+     *
+     * @return The number of cameras in the group
+     */
+    uint8_t getCameraCount();
+
+    /**
+     * @brief Send the snapshot command to every camera in the group.
+     *
+     * This doesn't wait for the cameras to answer; service() picks up the answers and
+     * marks cameras that don't accept the command as failed. Cameras that have reset
+     * since the last capture are recovered and triggered from service() instead. If
+     * the post-processing queue doesn't have room for an image from every camera, no
+     * snapshots are started.
+     *
+     * @return True if at least one camera was sent the snapshot command or is waiting
+     * to be recovered
+     */
+    bool startCapture();
+    /**
+     * @brief Do whatever work is ready on the group without waiting: send status polls
+     * that are due, process any responses and chunk data that have arrived, and write
+     * out the chunks once every chunk in the round is in.
+     *
+     * @return True while any camera still has work left to do
+     */
+    bool service();
+    /**
+     * @brief Get the time until the next deadline in the group - a status poll that
+     * is due or a response that will time out.
+     *
+     * If no new serial data arrives on any of the cameras' ports, nothing will happen
+     * on the group until this much time has passed.
+     *
+     * @return The number of milliseconds until service() next has timed work to do;
+     * 0 if there is work to do now and UINT32_MAX if the group is idle.
+     */
+    uint32_t getIdleTime();
+
+    /**
+     * @brief Add a post-processing stage to run on every finished image.
+     *
+     * Stages are run in the order they are added.
+     *
+     * @param stage The function to run
+     * @param context A pointer to pass to the stage function; optional
+     * @return True if the stage was added, false if there are already
+     * #GEOLUX_GROUP_MAX_STAGES stages
+     */
+    bool addStage(image_stage stage, void* context = nullptr);
+    /**
+     * @brief Run one post-processing stage on the oldest queued image.
+     *
+     * This is called by service() whenever no camera is transferring. Call it
+     * directly to drain the queue when the cameras are not in use.
+     *
+     * @return True if a stage was run
+     */
+    bool processJob();
+    /**
+     * @brief Get the number of finished images waiting for post-processing.
+     *
+     * @return The number of queued images
+     */
+    uint8_t getQueuedJobs();
+    /**
+     * @brief **Blocking** capture and transfer of an image from every camera in the
+     * group.
+     *
+     * @param timeout The maximum number of milliseconds to wait for the whole round;
+     * optional with a default of 180,000 (3 minutes)
+     * @return The number of cameras whose images were fully transferred
+     */
+    uint8_t captureAll(uint32_t timeout = 180000L);
+
+    /**
+     * @brief Get the state of a camera in the group.
+     *
+     * @param index The index of the camera, in the order it was added
+     * @return The state of the camera
+     */
+    geolux_group_state getState(uint8_t index);
+    /**
+     * @brief Get the size of the image a camera in the group is transferring.
+     *
+     * @param index The index of the camera, in the order it was added
+     * @return The image size reported by the camera, or 0 if it is not yet known
+     */
+    int32_t getImageSize(uint8_t index);
+    /**
+     * @brief Get the number of image bytes written for a camera in the group.
+     *
+     * @param index The index of the camera, in the order it was added
+     * @return The number of bytes written to the camera's output
+     */
+    uint32_t getBytesTransferred(uint8_t index);
+
+    /**
+     * @brief Set how often to poll the status of a camera that is taking a snapshot.
+     *
+     * @param interval The number of milliseconds between polls; the default is 100
+     */
+    void setPollInterval(uint32_t interval);
+    /**
+     * @brief Set how long to wait for each camera to finish its snapshot.
+     *
+     * @param timeout The maximum number of milliseconds to wait; the default is 60,000
+     * (1 minute)
+     */
+    void setSnapshotTimeout(uint32_t timeout);
+
+ protected:
+    /// @brief The working state of one camera in the group
+    typedef struct {
+        GeoluxCamera*      camera;       ///< The camera
+        Print*             output;       ///< Where to write the camera's image
+        geolux_group_state state;        ///< The state of the camera
+        int8_t             buffer;       ///< The pool buffer in use, or -1
+        int32_t            image_size;   ///< The size of the image
+        int32_t            written;      ///< The number of image bytes written
+        uint16_t           requested;    ///< The length of the chunk in flight
+        uint16_t           received;     ///< The bytes received for the chunk in flight
+        uint32_t           state_start;  ///< The millis() time the state began
+        uint32_t           deadline;     ///< The millis() time of the next timed event
+        bool               awaiting;     ///< True if a response is expected
+        uint8_t            failures;     ///< Consecutive empty chunks
+        int8_t             setting;      ///< The setting being re-applied, if any
+        char               line[24];     ///< The response line received so far
+        uint8_t            line_length;  ///< The number of characters in the line
+    } camera_slot;
+
+    /**
+     * @brief Send a status poll to a camera that is taking a snapshot or recovering
+     * from a reset when it's due and process the response as it arrives.
+     *
+     * @param slot The camera to poll
+     */
+    void pollCamera(camera_slot& slot);
+    /**
+     * @brief Send a status poll to a camera, or a probe if the camera is being
+     * treated as unresponsive, without waiting for the answer.
+     *
+     * @param slot The camera to poll
+     * @return True if the poll was sent; false if the camera is unresponsive and
+     * can't be probed yet, in which case it has failed
+     */
+    bool sendPoll(camera_slot& slot);
+    /**
+     * @brief Process a complete response line to a snapshot command, a status poll or
+     * a setting.
+     *
+     * @param slot The camera the response came from
+     */
+    void parseStatus(camera_slot& slot);
+    /**
+     * @brief Send the snapshot command to a camera without waiting for the answer.
+     *
+     * @param slot The camera to trigger
+     */
+    void triggerCamera(camera_slot& slot);
+    /**
+     * @brief Start recovering a camera that reset.
+     *
+     * @param slot The camera to recover
+     */
+    void startRecovery(camera_slot& slot);
+    /**
+     * @brief Take the next step in recovering a camera from a complete response line
+     * to a status poll or a setting.
+     *
+     * @param slot The camera being recovered
+     */
+    void recoverCamera(camera_slot& slot);
+    /**
+     * @brief Send the next setting to re-apply to a camera that reset, or go on to
+     * wait for the camera to apply them once they have all been sent.
+     *
+     * @param slot The camera being recovered
+     * @param step The first setting step to consider; see
+     * GeoluxCamera::sendSetting()
+     */
+    void sendNextSetting(camera_slot& slot, uint8_t step);
+    /**
+     * @brief Hand out buffers and request a chunk from every camera that is
+     * transferring and can get a buffer.
+     */
+    void startRound();
+    /**
+     * @brief Read any chunk data that has arrived and check for timeouts.
+     *
+     * @return True if any chunk in the round is still expecting data
+     */
+    bool receiveRound();
+    /**
+     * @brief Write out every chunk in the finished round.
+     */
+    void finishRound();
+    /**
+     * @brief Mark a camera's transfer as done and queue its image for
+     * post-processing.
+     *
+     * @param index The index of the camera
+     */
+    void finishImage(uint8_t index);
+    /**
+     * @brief Check if the deadline for a camera has passed.
+     *
+     * @param slot The camera to check
+     * @return True if the deadline has passed
+     */
+    bool pastDeadline(camera_slot& slot);
+    /**
+     * @brief Give the camera's pool buffer back to the pool.
+     *
+     * @param slot The camera that is done with its buffer
+     */
+    void releaseBuffer(camera_slot& slot);
+
+    camera_slot _slots[GEOLUX_GROUP_MAX_CAMERAS];  ///< The cameras in the group
+    uint8_t     _camera_count;                     ///< The number of cameras
+    uint8_t     _next_camera;  ///< The camera to start the next round with
+    /// The shared transfer buffers, with room for the two junk bytes on each chunk
+    uint8_t _buffers[GEOLUX_GROUP_BUFFER_COUNT][GEOLUX_GROUP_BUFFER_SIZE + 2];
+    bool    _buffer_used[GEOLUX_GROUP_BUFFER_COUNT];  ///< Which buffers are in use
+    image_stage _stages[GEOLUX_GROUP_MAX_STAGES];          ///< Post-processing stages
+    void*       _stage_contexts[GEOLUX_GROUP_MAX_STAGES];  ///< The stage contexts
+    image_job   _queue[GEOLUX_GROUP_QUEUE_SIZE];  ///< Images waiting to be processed
+    uint8_t     _stage_count      = 0;            ///< The number of stages
+    uint8_t     _queue_head       = 0;            ///< The oldest queued image
+    uint8_t     _queue_count      = 0;            ///< The number of queued images
+    bool        _round_active     = false;        ///< True while chunks are in flight
+    uint32_t    _poll_interval    = 100;          ///< The milliseconds between polls
+    uint32_t    _snapshot_timeout = 60000L;       ///< The maximum wait for a snapshot
+};
+
+#endif  // SRC_GEOLUXCAMERAGROUP_H_
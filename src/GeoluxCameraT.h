@@ -0,0 +1,110 @@
+/**
+ * @file       GeoluxCameraT.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Contains a camera that transfers images through the concrete type of its
+ * stream.
+ */
+
+#ifndef SRC_GEOLUXCAMERAT_H_
+#define SRC_GEOLUXCAMERAT_H_
+
+#include <Arduino.h>
+#include "GeoluxCamera.h"
+
+/**
+ * @brief A GeoluxCamera that transfers images straight through the concrete class of
+ * its stream.
+ *
+ * GeoluxCamera talks to the camera through a Stream pointer, so every available(),
+ * read() and write() while an image arrives is a virtual call that the compiler can't
+ * inline. This class has GeoluxCamera run the whole transfer loop - the chunk
+ * requests, the wait for each byte and the reads - with calls qualified by the
+ * stream's own type, which are ordinary function calls. Where the stream defines them
+ * inline, as most software and host streams do, the byte loop is compiled without any
+ * calls at all. Neither class has a vtable; the typed loop is picked when the camera
+ * is constructed, so it is also used when a GeoluxCameraT is passed as a GeoluxCamera.
+ * Everything else works exactly as in GeoluxCamera.
+ *
+ * The template argument must be the exact class of the stream object, not a base
+ * class of it, or a subclass' overrides of available() and read() will be skipped.
+ * Use a plain GeoluxCamera when the stream type isn't known at compile time.
+ *
+ * The number of CPU cycles per byte for both classes can be compared with the
+ * stream_benchmark sketch in the extras folder.
+ *
+ * @tparam StreamT The class of the stream the camera is attached to
+ */
+template <class StreamT>
+class GeoluxCameraT : public GeoluxCamera {
+
+ public:
+    /**
+     * @brief Construct a new GeoluxCameraT object with stream attached.
+     *
+     * @param stream The stream instance the camera is attached to
+     */
+    explicit GeoluxCameraT(StreamT* stream) : GeoluxCamera(stream) {
+        useTypedStream(stream);
+    }
+    /** @copydoc GeoluxCameraT::GeoluxCameraT(StreamT* stream) */
+    explicit GeoluxCameraT(StreamT& stream) : GeoluxCamera(stream) {
+        useTypedStream(&stream);
+    }
+    /**
+     * @brief Construct a new GeoluxCameraT object with stream attached and its own
+     * timeouts.
+     *
+     * @param stream The stream instance the camera is attached to
+     * @param timeouts The timeouts to use while talking to the camera
+     */
+    GeoluxCameraT(StreamT* stream, const GeoluxTimeouts& timeouts)
+        : GeoluxCamera(stream, timeouts) {
+        useTypedStream(stream);
+    }
+    /** @copydoc GeoluxCameraT::GeoluxCameraT(StreamT* stream,
+     * const GeoluxTimeouts& timeouts) */
+    GeoluxCameraT(StreamT& stream, const GeoluxTimeouts& timeouts)
+        : GeoluxCamera(stream, timeouts) {
+        useTypedStream(&stream);
+    }
+
+    using GeoluxCamera::begin;
+    /**
+     * @brief Sets up the camera module with a different stream of the same type
+     *
+     * A hardware serial port is started at #GEOLUX_CAMERA_RS232_BAUD, as in
+     * GeoluxCamera::begin(HardwareSerial* stream).
+     *
+     * @param stream The stream instance the camera is attached to
+     */
+    void begin(StreamT* stream) {
+        GeoluxCamera::begin(stream);
+        useTypedStream(stream);
+    }
+    /** @copydoc GeoluxCameraT::begin(StreamT* stream) */
+    void begin(StreamT& stream) {
+        begin(&stream);
+    }
+
+    /**
+     * @copydoc GeoluxCamera::readImageData(uint8_t* buf, size_t max_length)
+     *
+     * This reads through the stream's own class. It hides rather than overrides
+     * GeoluxCamera::readImageData(), so it is only used when called on a
+     * GeoluxCameraT. If the camera was moved to a stream of another type with
+     * GeoluxCamera::begin(), this falls back to the virtual calls of
+     * GeoluxCamera::readImageData().
+     */
+    size_t readImageData(uint8_t* buf, size_t max_length) {
+        if (_stream != _typed_stream) {
+            return GeoluxCamera::readImageData(buf, max_length);
+        }
+        TypedStream<StreamT> port = {static_cast<StreamT*>(_typed_stream)};
+        return readImageDataFrom(&port, buf, max_length);
+    }
+};
+
+#endif  // SRC_GEOLUXCAMERAT_H_
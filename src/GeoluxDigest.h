@@ -0,0 +1,215 @@
+/**
+ * @file       GeoluxDigest.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Contains incremental CRC32 and SHA-256 digests and an image sink that
+ * computes them while an image is transferred.
+ */
+
+#ifndef SRC_GEOLUXDIGEST_H_
+#define SRC_GEOLUXDIGEST_H_
+
+#include <Arduino.h>
+#include "GeoluxImageSink.h"
+
+/**
+ * @def GEOLUX_ENABLE_SHA256
+ * @brief Set to 1 to compile the SHA-256 digest.
+ *
+ * SHA-256 needs about 300 bytes of RAM for its state and is slow on 8-bit boards.
+ * SHA-256 is off by default on AVR and on by default on other boards.
+ */
+#ifndef GEOLUX_ENABLE_SHA256
+#if defined(__AVR__)
+#define GEOLUX_ENABLE_SHA256 0
+#else
+#define GEOLUX_ENABLE_SHA256 1
+#endif
+#endif
+
+/**
+ * @brief An incremental CRC-32 (IEEE 802.3, as used by zip and png).
+ *
+ * On AVR boards a 16 entry table in flash is used, processing a nibble at a time, to
+ * save program space. Other boards use a 256 entry table, processing a byte at a
+ * time.
+ */
+class GeoluxCRC32 {
+
+ public:
+    /**
+     * @brief Construct a new GeoluxCRC32 object, ready for the first byte
+     */
+    GeoluxCRC32();
+
+    /**
+     * @brief Start a new CRC.
+     */
+    void reset();
+    /**
+     * @brief Add one byte to the CRC.
+     *
+     * @param b The byte to add
+     */
+    void update(uint8_t b);
+    /**
+     * @brief Add a buffer of bytes to the CRC.
+     *
+     * @param buffer The bytes to add
+     * @param size The number of bytes to add
+     */
+    void update(const uint8_t* buffer, size_t size);
+    /**
+     * @brief Get the CRC of all the bytes added since the last reset.
+     *
+     * @return The CRC-32 value
+     */
+    uint32_t getValue();
+
+ protected:
+    uint32_t _crc;  ///< The running (inverted) CRC value
+};
+
+#if GEOLUX_ENABLE_SHA256
+/**
+ * @brief An incremental SHA-256 hash.
+ */
+class GeoluxSHA256 {
+
+ public:
+    /**
+     * @brief Construct a new GeoluxSHA256 object, ready for the first byte
+     */
+    GeoluxSHA256();
+
+    /**
+     * @brief Start a new hash.
+     */
+    void reset();
+    /**
+     * @brief Add one byte to the hash.
+     *
+     * @param b The byte to add
+     */
+    void update(uint8_t b);
+    /**
+     * @brief Add a buffer of bytes to the hash.
+     *
+     * @param buffer The bytes to add
+     * @param size The number of bytes to add
+     */
+    void update(const uint8_t* buffer, size_t size);
+    /**
+     * @brief Finish the hash and copy out the digest.
+     *
+     * No more bytes can be added after the hash is finished until it is reset.
+     *
+     * @param digest A buffer of at least 32 bytes for the digest
+     */
+    void finish(uint8_t* digest);
+
+ protected:
+    /**
+     * @brief Run the compression function over the full 64 byte block.
+     */
+    void processBlock();
+
+    uint32_t _state[8];    ///< The intermediate hash value
+    uint8_t  _block[64];   ///< The block being filled
+    uint8_t  _block_used;  ///< The number of bytes in the block
+    uint32_t _length;      ///< The total number of bytes hashed
+};
+#endif
+
+/**
+ * @brief An image sink that computes digests of the image bytes as they are written,
+ * passing the bytes on unchanged.
+ *
+ * Put this in front of the file or other output the image is written to, so the
+ * digests describe exactly the bytes that were committed and the file does not need
+ * to be read back to check it. The digests are reset at the beginning of each image
+ * and are ready to read once GeoluxCamera::transferImage() returns.
+ *
+ * With no output attached the sink only computes the digests.
+ */
+class GeoluxDigestSink : public GeoluxImageSink {
+
+ public:
+    /**
+     * @brief Construct a new GeoluxDigestSink object with no output attached
+     */
+    GeoluxDigestSink();
+    /**
+     * @brief Construct a new GeoluxDigestSink object that writes on to another Print
+     *
+     * @param output The output to pass the image bytes to
+     */
+    explicit GeoluxDigestSink(Print* output);
+    /** @copydoc GeoluxDigestSink::GeoluxDigestSink(Print* output) */
+    explicit GeoluxDigestSink(Print& output);
+    /**
+     * @brief Construct a new GeoluxDigestSink object that writes on to another image
+     * sink
+     *
+     * @param output The image sink to pass the image bytes to
+     */
+    explicit GeoluxDigestSink(GeoluxImageSink* output);
+    /** @copydoc GeoluxDigestSink::GeoluxDigestSink(GeoluxImageSink* output) */
+    explicit GeoluxDigestSink(GeoluxImageSink& output);
+
+    bool beginImage(int32_t image_size) override;
+    bool endImage(uint32_t bytes_written) override;
+
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using GeoluxImageSink::write;
+
+    /**
+     * @brief Get the CRC-32 of the last image.
+     *
+     * @return The CRC-32 of the bytes written
+     */
+    uint32_t getCRC32();
+    /**
+     * @brief Get the number of bytes included in the digests.
+     *
+     * @return The number of bytes digested
+     */
+    uint32_t getByteCount();
+
+#if GEOLUX_ENABLE_SHA256
+    /**
+     * @brief Get the SHA-256 digest of the last image.
+     *
+     * @param digest A buffer of at least 32 bytes for the digest
+     * @return True if the digest of a finished image was copied, otherwise false
+     */
+    bool getSHA256(uint8_t* digest);
+    /**
+     * @brief Print the SHA-256 digest of the last image as 64 hex characters.
+     *
+     * @param outStream The stream to print to
+     */
+    void printSHA256(Print* outStream);
+    /** @copydoc GeoluxDigestSink::printSHA256(Print* outStream) */
+    void printSHA256(Print& outStream);
+#endif
+
+ protected:
+    GeoluxCRC32 _crc;         ///< The running CRC-32
+    uint32_t    _byte_count;  ///< The number of bytes digested
+#if GEOLUX_ENABLE_SHA256
+    GeoluxSHA256 _sha;           ///< The running SHA-256
+    uint8_t      _digest[32];    ///< The finished SHA-256 digest
+    bool         _sha_finished;  ///< True once the SHA-256 has been finished
+#endif
+
+ private:
+    /**
+     * @brief Start the digests over without passing anything on to the next output.
+     */
+    void resetDigests();
+};
+
+#endif  // SRC_GEOLUXDIGEST_H_
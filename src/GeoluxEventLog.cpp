@@ -0,0 +1,110 @@
+/**
+ * @file       GeoluxEventLog.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#include "GeoluxEventLog.h"
+#include "GeoluxCamera.h"
+
+GeoluxEventLog::GeoluxEventLog() {
+    clear();
+}
+
+void GeoluxEventLog::record(geolux_event_id id, int32_t arg1, int32_t arg2,
+                            int32_t arg3) {
+    geolux_event& event = _events[_next];
+    event.time          = micros();
+    event.args[0]       = arg1;
+    event.args[1]       = arg2;
+    event.args[2]       = arg3;
+    event.id            = id;
+    if (++_next == GEOLUX_EVENT_LOG_SIZE) { _next = 0; }
+    if (_count < GEOLUX_EVENT_LOG_SIZE) {
+        _count++;
+    } else {
+        _dropped++;
+    }
+}
+
+void GeoluxEventLog::clear() {
+    _next    = 0;
+    _count   = 0;
+    _dropped = 0;
+}
+
+uint16_t GeoluxEventLog::getCount() {
+    return _count;
+}
+
+uint32_t GeoluxEventLog::getDropped() {
+    return _dropped;
+}
+
+bool GeoluxEventLog::getEvent(uint16_t index, geolux_event& event) {
+    if (index >= _count) { return false; }
+    uint16_t position = _next + GEOLUX_EVENT_LOG_SIZE - _count + index;
+    if (position >= GEOLUX_EVENT_LOG_SIZE) { position -= GEOLUX_EVENT_LOG_SIZE; }
+    event = _events[position];
+    return true;
+}
+
+/**
+ * @brief Get the name of an event type.
+ *
+ * @param id The type of event
+ * @return The name of the event
+ */
+static GsmConstStr eventName(GeoluxEventLog::geolux_event_id id) {
+    switch (id) {
+        case GeoluxEventLog::EVT_TRANSFER_START: return GF("transfer start");
+        case GeoluxEventLog::EVT_CHUNK: return GF("chunk");
+        case GeoluxEventLog::EVT_NO_RESPONSE: return GF("no response");
+        case GeoluxEventLog::EVT_NO_DATA: return GF("no more data");
+        case GeoluxEventLog::EVT_SHORT_CHUNK: return GF("short chunk");
+        case GeoluxEventLog::EVT_START_TAG: return GF("FFD8 start tag");
+        case GeoluxEventLog::EVT_END_TAG: return GF("FFD9 end tag");
+        case GeoluxEventLog::EVT_PADDING: return GF("padding");
+        case GeoluxEventLog::EVT_TIMEOUT: return GF("timed out");
+        case GeoluxEventLog::EVT_REBOOT: return GF("camera reset");
+        case GeoluxEventLog::EVT_IMAGE_BYTES: return GF("bytes");
+        case GeoluxEventLog::EVT_TRANSFER_END: return GF("transfer end");
+        default: return GF("unknown");
+    }
+}
+
+void GeoluxEventLog::printEvents(Stream* outStream) {
+    if (_dropped) {
+        outStream->print(_dropped);
+        outStream->println(GF(" older events were overwritten"));
+    }
+    geolux_event event;
+    for (uint16_t i = 0; getEvent(i, event); i++) {
+        outStream->print(event.time);
+        outStream->print(GF(" us: "));
+        outStream->print(eventName(event.id));
+        if (event.id == EVT_IMAGE_BYTES) {
+            // print zero padded hex of the packed bytes, oldest first
+            outStream->print(GF(" @"));
+            outStream->print(event.args[0]);
+            outStream->print(' ');
+            for (int32_t n = event.args[2] - 1; n >= 0; n--) {
+                uint8_t b = static_cast<uint32_t>(event.args[1]) >> (8 * n);
+                if (b < 0x10) { outStream->print('0'); }
+                outStream->print(b, HEX);
+            }
+            outStream->println();
+            continue;
+        }
+        for (uint8_t n = 0; n < 3; n++) {
+            outStream->print(' ');
+            outStream->print(event.args[n]);
+        }
+        outStream->println();
+    }
+}
+
+void GeoluxEventLog::printEvents(Stream& outStream) {
+    printEvents(&outStream);
+}
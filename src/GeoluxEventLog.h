@@ -0,0 +1,188 @@
+/**
+ * @file       GeoluxEventLog.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Contains a fixed-memory ring buffer of binary events recorded during image
+ * transfers.
+ */
+
+#ifndef SRC_GEOLUXEVENTLOG_H_
+#define SRC_GEOLUXEVENTLOG_H_
+
+#include <Arduino.h>
+
+/**
+ * @def GEOLUX_LOG_LEVEL
+ * @brief The most detailed level of events recorded to an attached GeoluxEventLog.
+ *
+ * At 0 no events are recorded and the logging calls are compiled out entirely. At 1
+ * only errors are recorded, at 2 the start and end of each transfer, each chunk and
+ * the JPEG tags are added, and at 3 the first and last bytes of each image are added.
+ * Like GEOLUX_DEBUG, this must be set as a build flag so the library source files see
+ * it.
+ */
+#ifndef GEOLUX_LOG_LEVEL
+#define GEOLUX_LOG_LEVEL 2
+#endif
+
+/**
+ * @def GEOLUX_EVENT_LOG_SIZE
+ * @brief The number of events held by a GeoluxEventLog before the oldest are
+ * overwritten.
+ */
+#ifndef GEOLUX_EVENT_LOG_SIZE
+#if defined(__AVR__)
+#define GEOLUX_EVENT_LOG_SIZE 16
+#else
+#define GEOLUX_EVENT_LOG_SIZE 64
+#endif
+#endif
+
+#if GEOLUX_LOG_LEVEL >= 1
+/// Record an error event to a log, if the log isn't null
+#define GEOLUX_LOG_ERROR(log, ...)                  \
+    do {                                            \
+        if (log) { (log)->record(__VA_ARGS__); }    \
+    } while (0)
+#else
+/// Empty define for when error events are not requested
+#define GEOLUX_LOG_ERROR(log, ...) \
+    do {                           \
+    } while (0)
+#endif
+
+#if GEOLUX_LOG_LEVEL >= 2
+/// Record an informational event to a log, if the log isn't null
+#define GEOLUX_LOG_INFO(log, ...)                   \
+    do {                                            \
+        if (log) { (log)->record(__VA_ARGS__); }    \
+    } while (0)
+#else
+/// Empty define for when informational events are not requested
+#define GEOLUX_LOG_INFO(log, ...) \
+    do {                          \
+    } while (0)
+#endif
+
+#if GEOLUX_LOG_LEVEL >= 3
+/// Record a detailed event to a log, if the log isn't null
+#define GEOLUX_LOG_DETAIL(log, ...)                 \
+    do {                                            \
+        if (log) { (log)->record(__VA_ARGS__); }    \
+    } while (0)
+#else
+/// Empty define for when detailed events are not requested
+#define GEOLUX_LOG_DETAIL(log, ...) \
+    do {                            \
+    } while (0)
+#endif
+
+/**
+ * @brief A ring buffer of compact binary events that can be formatted and printed
+ * after the fact.
+ *
+ * Printing debugging text while an image is arriving takes long enough to overrun the
+ * serial buffer. Recording an event instead only stores an id, a micros() time stamp
+ * and up to three integers in RAM, so it can be done from inside the transfer loop
+ * without changing its timing. The events are turned into text only when
+ * printEvents() is called, once the transfer is over.
+ *
+ * Attach a log to a camera with GeoluxCamera::setEventLog(). The events recorded are
+ * set by #GEOLUX_LOG_LEVEL at compile time; no memory is used unless a log is
+ * attached, and nothing at all is compiled in at level 0. Once the log is full each
+ * new event replaces the oldest one.
+ */
+class GeoluxEventLog {
+
+ public:
+    /// @brief The events that can be recorded, with the meaning of their arguments
+    typedef enum : uint8_t {
+        EVT_TRANSFER_START = 0,  ///< A transfer began: image size, chunk size, offset
+        EVT_CHUNK,         ///< A chunk was answered: chunk number, offset, response ms
+        EVT_NO_RESPONSE,   ///< A chunk request went unanswered: chunk number, offset
+        EVT_NO_DATA,       ///< The data stopped mid-chunk: chunk number, bytes read
+        EVT_SHORT_CHUNK,   ///< A chunk came up short: expected, read, written
+        EVT_START_TAG,     ///< An FFD8 start tag was read: image offset
+        EVT_END_TAG,       ///< An FFD9 end tag was read: image offset
+        EVT_PADDING,       ///< Zeros were read past the end of the image: image offset
+        EVT_TIMEOUT,       ///< The transfer timed out: bytes written, timeout ms
+        EVT_REBOOT,        ///< The camera's start-up banner was read: bytes read
+        EVT_IMAGE_BYTES,   ///< Image bytes: image offset, bytes (big-endian), count
+        EVT_TRANSFER_END,  ///< A transfer finished: bytes written, ms, chunks
+        EVT_COUNT,         ///< The number of event types
+    } geolux_event_id;
+
+    /// @brief A single recorded event
+    typedef struct {
+        uint32_t        time;     ///< The micros() time the event was recorded
+        int32_t         args[3];  ///< The arguments of the event
+        geolux_event_id id;       ///< The type of event
+    } geolux_event;
+
+    /**
+     * @brief Construct a new, empty, GeoluxEventLog object
+     */
+    GeoluxEventLog();
+
+    /**
+     * @brief Record an event.
+     *
+     * This only copies the event into the ring buffer, so it is safe to call while
+     * data is arriving. The GEOLUX_LOG_ERROR(), GEOLUX_LOG_INFO() and
+     * GEOLUX_LOG_DETAIL() macros call this only when their level is compiled in.
+     *
+     * @param id The type of event
+     * @param arg1 The first argument of the event; optional with a default of 0
+     * @param arg2 The second argument of the event; optional with a default of 0
+     * @param arg3 The third argument of the event; optional with a default of 0
+     */
+    void record(geolux_event_id id, int32_t arg1 = 0, int32_t arg2 = 0,
+                int32_t arg3 = 0);
+    /**
+     * @brief Remove all events from the log.
+     */
+    void clear();
+
+    /**
+     * @brief Get the number of events held in the log.
+     *
+     * @return The number of events, at most #GEOLUX_EVENT_LOG_SIZE
+     */
+    uint16_t getCount();
+    /**
+     * @brief Get the number of events that were overwritten before being cleared.
+     *
+     * @return The number of lost events
+     */
+    uint32_t getDropped();
+    /**
+     * @brief Get an event from the log.
+     *
+     * @param index The position of the event, where 0 is the oldest held
+     * @param event Filled with the event
+     * @return True if there is an event at that position
+     */
+    bool getEvent(uint16_t index, geolux_event& event);
+
+    /**
+     * @brief Print every event held, oldest first, as one line of text each.
+     *
+     * Each line gives the time stamp in microseconds, the name of the event and its
+     * arguments. Image bytes are printed in hex.
+     *
+     * @param outStream A stream to print the events to
+     */
+    void printEvents(Stream* outStream);
+    /** @copydoc GeoluxEventLog::printEvents(Stream* outStream) */
+    void printEvents(Stream& outStream);
+
+ protected:
+    geolux_event _events[GEOLUX_EVENT_LOG_SIZE];  ///< The ring buffer of events
+    uint16_t     _next;                           ///< The position for the next event
+    uint16_t     _count;                          ///< The number of events held
+    uint32_t     _dropped;                        ///< The number of overwritten events
+};
+
+#endif  // SRC_GEOLUXEVENTLOG_H_
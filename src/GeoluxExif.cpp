@@ -0,0 +1,226 @@
+/**
+ * @file       GeoluxExif.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#include "GeoluxExif.h"
+
+/// @brief An EXIF directory entry; entries without text point to the Exif IFD
+typedef struct {
+    uint16_t    tag;   ///< The EXIF tag number
+    const char* text;  ///< The ASCII value, or nullptr for the Exif IFD pointer
+} exif_entry;
+
+/**
+ * @brief An output that only counts the bytes written to it, used to size the segment.
+ */
+class GeoluxByteCounter : public Print {
+ public:
+    size_t write(uint8_t) override {
+        count++;
+        return 1;
+    }
+    using Print::write;
+    size_t count = 0;  ///< The number of bytes written
+};
+
+static void writeU16(Print* out, uint16_t value) {
+    out->write(static_cast<uint8_t>(value >> 8));
+    out->write(static_cast<uint8_t>(value & 0xFF));
+}
+
+static void writeU32(Print* out, uint32_t value) {
+    writeU16(out, static_cast<uint16_t>(value >> 16));
+    writeU16(out, static_cast<uint16_t>(value & 0xFFFF));
+}
+
+/**
+ * @brief Get the space an ASCII value takes after its directory.
+ *
+ * Values of up to 4 bytes, including the terminating null, fit inside the entry. Longer
+ * ones are stored after the directory, padded to an even length.
+ */
+static uint32_t valueSize(const char* text) {
+    uint32_t length = strlen(text) + 1;
+    if (length <= 4) { return 0; }
+    return (length + 1) & ~static_cast<uint32_t>(1);
+}
+
+static uint32_t directorySize(const exif_entry* entries, uint8_t count) {
+    uint32_t size = 2 + 12 * static_cast<uint32_t>(count) + 4;
+    for (uint8_t i = 0; i < count; i++) {
+        if (entries[i].text) { size += valueSize(entries[i].text); }
+    }
+    return size;
+}
+
+/**
+ * @brief Write an image file directory followed by its long values.
+ *
+ * @param out The output to write to
+ * @param entries The entries, in increasing tag order
+ * @param count The number of entries
+ * @param offset The offset of this directory from the start of the TIFF header
+ * @param exif_offset The offset of the Exif IFD, for the entry pointing to it
+ */
+static void writeDirectory(Print* out, const exif_entry* entries, uint8_t count,
+                           uint32_t offset, uint32_t exif_offset) {
+    uint32_t data_offset = offset + 2 + 12 * static_cast<uint32_t>(count) + 4;
+    writeU16(out, count);
+    for (uint8_t i = 0; i < count; i++) {
+        writeU16(out, entries[i].tag);
+        if (!entries[i].text) {
+            writeU16(out, 4);  // LONG
+            writeU32(out, 1);
+            writeU32(out, exif_offset);
+            continue;
+        }
+        uint32_t length = strlen(entries[i].text) + 1;
+        writeU16(out, 2);  // ASCII
+        writeU32(out, length);
+        if (length <= 4) {
+            out->write(reinterpret_cast<const uint8_t*>(entries[i].text), length);
+            for (uint32_t pad = length; pad < 4; pad++) {
+                out->write(static_cast<uint8_t>(0));
+            }
+        } else {
+            writeU32(out, data_offset);
+            data_offset += valueSize(entries[i].text);
+        }
+    }
+    writeU32(out, 0);  // no next directory
+    for (uint8_t i = 0; i < count; i++) {
+        if (!entries[i].text || !valueSize(entries[i].text)) { continue; }
+        uint32_t length = strlen(entries[i].text) + 1;
+        out->write(reinterpret_cast<const uint8_t*>(entries[i].text), length);
+        if (length & 1) { out->write(static_cast<uint8_t>(0)); }
+    }
+}
+
+
+GeoluxExifSink::GeoluxExifSink() : GeoluxImageSink() {}
+GeoluxExifSink::GeoluxExifSink(Print* output) : GeoluxImageSink(output) {}
+GeoluxExifSink::GeoluxExifSink(Print& output) : GeoluxImageSink(output) {}
+GeoluxExifSink::GeoluxExifSink(GeoluxImageSink* output) : GeoluxImageSink(output) {}
+GeoluxExifSink::GeoluxExifSink(GeoluxImageSink& output) : GeoluxImageSink(output) {}
+
+void GeoluxExifSink::setCameraInfo(const GeoluxCamera::geolux_info* info) {
+    _info = info;
+}
+
+void GeoluxExifSink::setCameraInfo(const GeoluxCamera::geolux_info& info) {
+    _info = &info;
+}
+
+void GeoluxExifSink::setTimestamp(const char* timestamp) {
+    if (!timestamp) {
+        _timestamp[0] = '\0';
+        return;
+    }
+    strncpy(_timestamp, timestamp, sizeof(_timestamp) - 1);
+    _timestamp[sizeof(_timestamp) - 1] = '\0';
+}
+
+void GeoluxExifSink::setTimestamp(uint16_t year, uint8_t month, uint8_t day,
+                                  uint8_t hour, uint8_t minute, uint8_t second) {
+    // keep each field to its width so the time stamp always fits
+    snprintf(_timestamp, sizeof(_timestamp), "%04u:%02u:%02u %02u:%02u:%02u",
+             year % 10000, month % 100, day % 100, hour % 100, minute % 100,
+             second % 100);
+}
+
+uint16_t GeoluxExifSink::getSegmentSize() {
+    GeoluxByteCounter counter;
+    return static_cast<uint16_t>(writeSegment(&counter));
+}
+
+bool GeoluxExifSink::beginImage(int32_t image_size) {
+    _soi_state     = 0;
+    _segment_bytes = 0;
+    if (image_size > 0) { image_size += getSegmentSize(); }
+    return GeoluxImageSink::beginImage(image_size);
+}
+
+bool GeoluxExifSink::endImage(uint32_t bytes_written) {
+    return GeoluxImageSink::endImage(bytes_written + _segment_bytes);
+}
+
+size_t GeoluxExifSink::write(const uint8_t* buffer, size_t size) {
+    if (!_output) { return 0; }
+    size_t consumed = 0;
+    // pass the start of image marker through and insert the segment right after it
+    while (_soi_state < 2 && consumed < size) {
+        uint8_t b = buffer[consumed];
+        if (!_output->write(b)) { return consumed; }
+        consumed++;
+        if (_soi_state == 0 && b == 0xFF) {
+            _soi_state = 1;
+        } else if (_soi_state == 1 && b == 0xD8) {
+            _segment_bytes = static_cast<uint16_t>(writeSegment(_output));
+            _soi_state     = 2;
+        } else {
+            DBG_GLX(GF("Image does not start with a JPEG marker; no EXIF inserted."));
+            _soi_state = 2;
+        }
+    }
+    if (consumed < size) { consumed += _output->write(buffer + consumed, size - consumed); }
+    return consumed;
+}
+
+size_t GeoluxExifSink::writeSegment(Print* out) {
+    char       description[128];
+    char       serial[11];
+    exif_entry ifd0[6];
+    exif_entry exif[2];
+    uint8_t    ifd0_count = 0;
+    uint8_t    exif_count = 0;
+
+    // the entries in each directory must be in increasing tag order
+    if (_info) {
+        snprintf(description, sizeof(description),
+                 "resolution=%s quality=%d exposure=%lu brightness=%lu ir_filter=%s "
+                 "focus=%d zoom=%d",
+                 _info->resolution, _info->quality,
+                 static_cast<unsigned long>(_info->exposure),
+                 static_cast<unsigned long>(_info->brightness), _info->ir_filter,
+                 _info->focus_position, _info->zoom_position);
+        ifd0[ifd0_count++] = {0x010E, description};  // ImageDescription
+    }
+    ifd0[ifd0_count++] = {0x010F, "Geolux"};  // Make
+    if (_info && _info->device_type[0]) {
+        ifd0[ifd0_count++] = {0x0110, _info->device_type};  // Model
+    }
+    if (_info && _info->firmware[0]) {
+        ifd0[ifd0_count++] = {0x0131, _info->firmware};  // Software
+    }
+    if (_timestamp[0]) {
+        ifd0[ifd0_count++] = {0x0132, _timestamp};  // DateTime
+        exif[exif_count++] = {0x9003, _timestamp};  // DateTimeOriginal
+    }
+    if (_info && _info->serial_number) {
+        snprintf(serial, sizeof(serial), "%lu",
+                 static_cast<unsigned long>(_info->serial_number));
+        exif[exif_count++] = {0xA431, serial};  // BodySerialNumber
+    }
+    if (exif_count) { ifd0[ifd0_count++] = {0x8769, nullptr}; }  // Exif IFD pointer
+
+    uint32_t ifd0_size = directorySize(ifd0, ifd0_count);
+    uint32_t tiff_size = 8 + ifd0_size;
+    if (exif_count) { tiff_size += directorySize(exif, exif_count); }
+
+    // APP1 marker and length, which counts itself but not the marker
+    out->write(static_cast<uint8_t>(0xFF));
+    out->write(static_cast<uint8_t>(0xE1));
+    writeU16(out, static_cast<uint16_t>(2 + 6 + tiff_size));
+    out->write(reinterpret_cast<const uint8_t*>("Exif\0\0"), 6);
+    // big-endian TIFF header, with the first directory right after it
+    out->write(static_cast<uint8_t>('M'));
+    out->write(static_cast<uint8_t>('M'));
+    writeU16(out, 0x002A);
+    writeU32(out, 8);
+    writeDirectory(out, ifd0, ifd0_count, 8, 8 + ifd0_size);
+    if (exif_count) { writeDirectory(out, exif, exif_count, 8 + ifd0_size, 0); }
+    return 2 + 2 + 6 + tiff_size;
+}
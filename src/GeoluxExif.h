@@ -0,0 +1,123 @@
+/**
+ * @file       GeoluxExif.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Contains an image sink that inserts an EXIF segment into the image as it is
+ * transferred.
+ */
+
+#ifndef SRC_GEOLUXEXIF_H_
+#define SRC_GEOLUXEXIF_H_
+
+#include <Arduino.h>
+#include "GeoluxCamera.h"
+#include "GeoluxImageSink.h"
+
+/**
+ * @brief An image sink that inserts an EXIF (APP1) segment right after the start of
+ * image marker, so each saved JPEG carries its own time stamp and camera settings.
+ *
+ * The segment is written to the output as soon as the start of image marker passes
+ * through and the rest of the image follows unchanged, so nothing but the two marker
+ * bytes is ever held back. The segment contains:
+ * - Make ("Geolux"), Model (device type), Software (firmware)
+ * - DateTime and DateTimeOriginal, from the caller supplied time stamp
+ * - BodySerialNumber
+ * - ImageDescription with the resolution, quality, exposure, brightness, IR filter,
+ * focus and zoom
+ *
+ * Use GeoluxCamera::getCameraInfo() to read the settings once and attach them with
+ * setCameraInfo(). The sink keeps a pointer to the info, so it must stay in scope for
+ * the transfer.
+ *
+ * The image sizes passed on to a following image sink include the inserted segment.
+ */
+class GeoluxExifSink : public GeoluxImageSink {
+
+ public:
+    /**
+     * @brief Construct a new GeoluxExifSink object with no output attached
+     */
+    GeoluxExifSink();
+    /**
+     * @brief Construct a new GeoluxExifSink object that writes on to another Print
+     *
+     * @param output The output to pass the image bytes to
+     */
+    explicit GeoluxExifSink(Print* output);
+    /** @copydoc GeoluxExifSink::GeoluxExifSink(Print* output) */
+    explicit GeoluxExifSink(Print& output);
+    /**
+     * @brief Construct a new GeoluxExifSink object that writes on to another image sink
+     *
+     * @param output The image sink to pass the image bytes to
+     */
+    explicit GeoluxExifSink(GeoluxImageSink* output);
+    /** @copydoc GeoluxExifSink::GeoluxExifSink(GeoluxImageSink* output) */
+    explicit GeoluxExifSink(GeoluxImageSink& output);
+
+    /**
+     * @brief Attach the camera information to describe in the EXIF segment.
+     *
+     * @param info The camera information, or nullptr to leave it out
+     */
+    void setCameraInfo(const GeoluxCamera::geolux_info* info);
+    /** @copydoc GeoluxExifSink::setCameraInfo(const GeoluxCamera::geolux_info* info) */
+    void setCameraInfo(const GeoluxCamera::geolux_info& info);
+    /**
+     * @brief Set the time stamp of the image.
+     *
+     * @param timestamp The time in the EXIF format "YYYY:MM:DD HH:MM:SS", or nullptr
+     * to leave the time stamp out
+     */
+    void setTimestamp(const char* timestamp);
+    /**
+     * @brief Set the time stamp of the image.
+     *
+     * @param year The four digit year
+     * @param month The month, 1-12
+     * @param day The day of the month
+     * @param hour The hour, 0-23
+     * @param minute The minute
+     * @param second The second
+     */
+    void setTimestamp(uint16_t year, uint8_t month, uint8_t day, uint8_t hour,
+                      uint8_t minute, uint8_t second);
+
+    /**
+     * @brief Get the size of the EXIF segment that will be inserted with the current
+     * information and time stamp.
+     *
+     * @return The size of the segment in bytes
+     */
+    uint16_t getSegmentSize();
+
+    bool beginImage(int32_t image_size) override;
+    bool endImage(uint32_t bytes_written) override;
+
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using GeoluxImageSink::write;
+
+ protected:
+    /**
+     * @brief Write the EXIF segment.
+     *
+     * @param out The output to write the segment to
+     * @return The number of bytes written
+     */
+    size_t writeSegment(Print* out);
+
+    /// The camera information, if any
+    const GeoluxCamera::geolux_info* _info = nullptr;
+    /// The EXIF time stamp; empty if not set
+    char _timestamp[20] = "";
+    /// 0 before the start of image marker, 1 after its first byte, 2 once it has
+    /// passed (or the image turned out not to start with one)
+    uint8_t _soi_state = 0;
+    /// The size of the segment inserted into the current image
+    uint16_t _segment_bytes = 0;
+};
+
+#endif  // SRC_GEOLUXEXIF_H_
@@ -0,0 +1,144 @@
+/**
+ * @file       GeoluxFileSink.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Contains an image sink that preallocates a file and writes it in whole
+ * sectors.
+ */
+
+#ifndef SRC_GEOLUXFILESINK_H_
+#define SRC_GEOLUXFILESINK_H_
+
+#include <Arduino.h>
+#include "GeoluxImageSink.h"
+
+/**
+ * @def GEOLUX_FILE_SECTOR_SIZE
+ * @brief The size of the staging buffer used by GeoluxFileSink; one SD card sector.
+ */
+#ifndef GEOLUX_FILE_SECTOR_SIZE
+#define GEOLUX_FILE_SECTOR_SIZE 512
+#endif
+
+/**
+ * @brief An image sink that writes each image to a file, preallocated from the image
+ * size the camera reports and written in whole sectors.
+ *
+ * When the image begins, the file is preallocated with contiguous clusters for the
+ * full image, so SdFat never has to search the FAT for the next cluster while the
+ * image is arriving. The image bytes are collected in a one sector staging buffer and
+ * only written out as whole, sector aligned blocks, which SdFat can send straight to
+ * the card without a read-modify-write of its cache. When the image ends the final
+ * partial sector is written and the file is truncated to the true length, releasing
+ * any clusters that were not needed.
+ *
+ * The file type is a template parameter so the library does not depend on SdFat, but
+ * the sink needs SdFat's preAllocate(), truncate() and sync(). It works with the SdFat
+ * File, File32, ExFile and FsFile classes. The file should be newly created and
+ * empty; if it cannot be preallocated the image is still written, just without the
+ * contiguous allocation.
+ *
+ * @tparam FileT The SdFat file class
+ */
+template <class FileT>
+class GeoluxFileSink : public GeoluxImageSink {
+
+ public:
+    /**
+     * @brief Construct a new GeoluxFileSink object
+     *
+     * @param file The file to write to; it must already be open for writing
+     */
+    explicit GeoluxFileSink(FileT* file) : GeoluxImageSink(file), _file(file) {}
+    /** @copydoc GeoluxFileSink::GeoluxFileSink(FileT* file) */
+    explicit GeoluxFileSink(FileT& file) : GeoluxImageSink(file), _file(&file) {}
+
+    /**
+     * @brief Attach a different file for the next image.
+     *
+     * @param file The file to write to; it must already be open for writing
+     */
+    void setFile(FileT* file) {
+        _file = file;
+        setOutput(file);
+    }
+    /** @copydoc GeoluxFileSink::setFile(FileT* file) */
+    void setFile(FileT& file) {
+        setFile(&file);
+    }
+
+    /**
+     * @brief Check whether the last image's file was preallocated.
+     *
+     * @return True if the file was preallocated, otherwise false
+     */
+    bool wasPreallocated() {
+        return _preallocated;
+    }
+
+    bool beginImage(int32_t image_size) override {
+        _buffered    = 0;
+        _file_length = 0;
+        _failed      = false;
+        _preallocated =
+            image_size > 0 && _file->preAllocate(static_cast<uint32_t>(image_size));
+        return GeoluxImageSink::beginImage(image_size);
+    }
+
+    bool endImage(uint32_t bytes_written) override {
+        writeBuffer();
+        // release any preallocated clusters past the end of the image
+        bool success = !_failed && _file->truncate(_file_length);
+        success &= _file->sync();
+        return GeoluxImageSink::endImage(bytes_written) && success;
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override {
+        if (_failed) { return 0; }
+        size_t accepted = 0;
+        while (accepted < size) {
+            size_t take = min(size - accepted,
+                              static_cast<size_t>(GEOLUX_FILE_SECTOR_SIZE - _buffered));
+            memcpy(_buffer + _buffered, buffer + accepted, take);
+            _buffered += take;
+            accepted += take;
+            if (_buffered == GEOLUX_FILE_SECTOR_SIZE && !writeBuffer()) {
+                return accepted - take;
+            }
+        }
+        return accepted;
+    }
+    using GeoluxImageSink::write;
+
+    /**
+     * @brief Does nothing; a partial sector is only written when the image ends.
+     */
+    void flush() override {}
+
+ protected:
+    /**
+     * @brief Write out whatever is in the staging buffer.
+     *
+     * @return True if the whole buffer was written, otherwise false
+     */
+    bool writeBuffer() {
+        if (!_buffered || _failed) { return !_failed; }
+        size_t written = _file->write(_buffer, _buffered);
+        _file_length += written;
+        _failed   = written != _buffered;
+        _buffered = 0;
+        return !_failed;
+    }
+
+    FileT*   _file;                  ///< The file to write to
+    uint16_t _buffered     = 0;      ///< The number of bytes in the staging buffer
+    uint32_t _file_length  = 0;      ///< The number of bytes written to the file
+    bool     _preallocated = false;  ///< True if the file was preallocated
+    bool     _failed       = false;  ///< True if a write to the file failed
+    /// The staging buffer for one sector
+    uint8_t _buffer[GEOLUX_FILE_SECTOR_SIZE];
+};
+
+#endif  // SRC_GEOLUXFILESINK_H_
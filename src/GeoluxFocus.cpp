@@ -0,0 +1,140 @@
+/**
+ * @file       GeoluxFocus.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#include "GeoluxFocus.h"
+
+#if GEOLUX_ENABLE_OPTICS && GEOLUX_ENABLE_INFO
+
+GeoluxFocusMemory::GeoluxFocusMemory(GeoluxCamera* camera) : _camera(camera) {
+    clear();
+}
+GeoluxFocusMemory::GeoluxFocusMemory(GeoluxCamera& camera) : _camera(&camera) {
+    clear();
+}
+
+bool GeoluxFocusMemory::focus(uint32_t timeout) {
+    _last_restored = false;
+    readAutofocusPoint();
+    GeoluxCamera::geolux_info info;
+    if (!_camera->getCameraInfo(info)) { return false; }
+    geolux_focus_entry* entry = findEntry(info.zoom_position, _point_x, _point_y);
+    if (entry && entry->restores < _refresh_interval) {
+        if (stepFocus(info.focus_position, entry->focus, timeout)) {
+            entry->restores++;
+            _last_restored = true;
+            return true;
+        }
+        DBG_GLX(GF("Couldn't restore the focus position"), entry->focus);
+    }
+    return runAutofocus(timeout);
+}
+
+bool GeoluxFocusMemory::runAutofocus(uint32_t timeout) {
+    _last_restored = false;
+    readAutofocusPoint();
+    if (!_camera->runAutofocus()) { return false; }
+    if (!_camera->waitForReady(GEOLUX_AUTOFOCUS_DELAY, timeout)) {
+        DBG_GLX(GF("Autofocus timed out!"));
+        return false;
+    }
+    GeoluxCamera::geolux_info info;
+    if (!_camera->getCameraInfo(info)) { return false; }
+    rememberFocus(info.zoom_position, _point_x, _point_y, info.focus_position);
+    return true;
+}
+
+bool GeoluxFocusMemory::moveFocusTo(int16_t target, uint32_t timeout) {
+    return stepFocus(_camera->getFocusPosition(), target, timeout);
+}
+
+bool GeoluxFocusMemory::setAutofocusPoint(int8_t x, int8_t y) {
+    if (!_camera->setAutofocusPoint(x, y)) { return false; }
+    _point_x     = x;
+    _point_y     = y;
+    _point_known = true;
+    return true;
+}
+
+void GeoluxFocusMemory::setRefreshInterval(uint16_t restores) {
+    _refresh_interval = restores;
+}
+
+bool GeoluxFocusMemory::lastFocusWasRestored() {
+    return _last_restored;
+}
+
+void GeoluxFocusMemory::rememberFocus(int8_t zoom, int8_t point_x, int8_t point_y,
+                                      int16_t focus) {
+    geolux_focus_entry* entry = findEntry(zoom, point_x, point_y);
+    for (uint8_t i = 0; !entry && i < GEOLUX_FOCUS_ENTRIES; i++) {
+        if (!_entries[i].valid) { entry = &_entries[i]; }
+    }
+    if (!entry) {
+        // all in use; replace the oldest
+        entry       = &_entries[_next_entry];
+        _next_entry = (_next_entry + 1) % GEOLUX_FOCUS_ENTRIES;
+    }
+    entry->zoom     = zoom;
+    entry->point_x  = point_x;
+    entry->point_y  = point_y;
+    entry->focus    = focus;
+    entry->restores = 0;
+    entry->valid    = true;
+}
+
+bool GeoluxFocusMemory::getEntry(uint8_t index, geolux_focus_entry* entry) {
+    if (index >= GEOLUX_FOCUS_ENTRIES) { return false; }
+    *entry = _entries[index];
+    return entry->valid;
+}
+
+void GeoluxFocusMemory::clear() {
+    memset(_entries, 0, sizeof(_entries));
+    _next_entry = 0;
+}
+
+GeoluxFocusMemory::geolux_focus_entry*
+GeoluxFocusMemory::findEntry(int8_t zoom, int8_t point_x, int8_t point_y) {
+    for (uint8_t i = 0; i < GEOLUX_FOCUS_ENTRIES; i++) {
+        geolux_focus_entry& entry = _entries[i];
+        if (entry.valid && entry.zoom == zoom && entry.point_x == point_x &&
+            entry.point_y == point_y) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+void GeoluxFocusMemory::readAutofocusPoint() {
+    if (_point_known) { return; }
+    _point_x     = _camera->getAutofocusX();
+    _point_y     = _camera->getAutofocusY();
+    _point_known = true;
+}
+
+bool GeoluxFocusMemory::stepFocus(int16_t position, int16_t target,
+                                  uint32_t timeout) {
+    uint32_t start_millis = millis();
+    // check where the lens landed and correct once, in case a step was lost
+    for (uint8_t attempt = 0; attempt < 2 && position != target; attempt++) {
+        int16_t remaining = target - position;
+        while (remaining) {
+            // the camera takes at most 100 steps per move
+            int8_t   step    = static_cast<int8_t>(constrain(remaining, -100, 100));
+            uint32_t elapsed = millis() - start_millis;
+            if (elapsed >= timeout || !_camera->moveFocus(step) ||
+                !_camera->waitForReady(0, timeout - elapsed)) {
+                return false;
+            }
+            remaining -= step;
+        }
+        position = _camera->getFocusPosition();
+    }
+    return position == target;
+}
+
+#endif  // GEOLUX_ENABLE_OPTICS && GEOLUX_ENABLE_INFO
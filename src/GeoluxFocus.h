@@ -0,0 +1,188 @@
+/**
+ * @file       GeoluxFocus.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Contains a memory of autofocus results, keyed by zoom position, used to
+ * restore the focus without a full autofocus sweep.
+ */
+
+#ifndef SRC_GEOLUXFOCUS_H_
+#define SRC_GEOLUXFOCUS_H_
+
+#include <Arduino.h>
+#include "GeoluxCamera.h"
+
+/**
+ * @def GEOLUX_FOCUS_ENTRIES
+ * @brief The number of zoom positions and autofocus points to remember the focus for.
+ */
+#ifndef GEOLUX_FOCUS_ENTRIES
+#if defined(__AVR__)
+#define GEOLUX_FOCUS_ENTRIES 4
+#else
+#define GEOLUX_FOCUS_ENTRIES 8
+#endif
+#endif
+
+/**
+ * @def GEOLUX_AUTOFOCUS_DELAY
+ * @brief The time in milliseconds to wait after starting an autofocus before asking
+ * the camera for its status.
+ */
+#ifndef GEOLUX_AUTOFOCUS_DELAY
+#define GEOLUX_AUTOFOCUS_DELAY 5000L
+#endif
+
+// the focus memory moves the lens and reads the positions back with get_info
+#if GEOLUX_ENABLE_OPTICS && GEOLUX_ENABLE_INFO
+
+/**
+ * @brief Remembers where autofocus leaves the lens at each zoom position and moves
+ * the focus straight back there, skipping the autofocus sweep.
+ *
+ * An autofocus takes about 7 seconds on firmware 2.0.1 and later and about 30 on
+ * older firmware. On a fixed mount it nearly always converges on the same focus
+ * position for a given zoom, so after one real autofocus the focus position is
+ * recorded with the zoom position and autofocus point. On the following calls to
+ * focus() the lens is moved to the recorded position with \#move_focus steps, which
+ * takes well under a second, and a full autofocus is only run again after
+ * setRefreshInterval() restores or when the recorded position can't be reached.
+ *
+ * The memory lives in RAM, so it survives the camera being powered down between
+ * images but not a reset of the board. Use getEntry() and rememberFocus() to save it
+ * to and load it from EEPROM or a file.
+ */
+class GeoluxFocusMemory {
+
+ public:
+    /// @brief A remembered focus position
+    typedef struct {
+        int8_t   zoom;      ///< The zoom position
+        int8_t   point_x;   ///< The horizontal autofocus point
+        int8_t   point_y;   ///< The vertical autofocus point
+        int16_t  focus;     ///< The focus position autofocus reached
+        uint16_t restores;  ///< The number of restores since the last autofocus
+        bool     valid;     ///< True if the entry is in use
+    } geolux_focus_entry;
+
+    /**
+     * @brief Construct a new GeoluxFocusMemory object
+     *
+     * @param camera The camera to focus
+     */
+    explicit GeoluxFocusMemory(GeoluxCamera* camera);
+    /** @copydoc GeoluxFocusMemory::GeoluxFocusMemory(GeoluxCamera* camera) */
+    explicit GeoluxFocusMemory(GeoluxCamera& camera);
+
+    /**
+     * @brief Focus the camera, restoring the remembered position for the current zoom
+     * if there is one and running a full autofocus otherwise.
+     *
+     * @param timeout The maximum time in milliseconds to wait for the focus
+     * @return True if the camera was focused, otherwise false
+     */
+    bool focus(uint32_t timeout = 60000L);
+    /**
+     * @brief Run a full autofocus and remember the result.
+     *
+     * @param timeout The maximum time in milliseconds to wait for the autofocus
+     * @return True if the autofocus finished, otherwise false
+     */
+    bool runAutofocus(uint32_t timeout = 60000L);
+    /**
+     * @brief Move the lens to a focus position with \#move_focus steps.
+     *
+     * @param target The focus position to move to
+     * @param timeout The maximum time in milliseconds to wait for the moves
+     * @return True if the lens reached the position, otherwise false
+     */
+    bool moveFocusTo(int16_t target, uint32_t timeout = 10000L);
+
+    /**
+     * @brief Set the autofocus point on the camera, so later focus positions are
+     * remembered and looked up for that point.
+     *
+     * @param x The horizontal autofocus point
+     * @param y The vertical autofocus point
+     * @return True if the camera accepted the point, otherwise false
+     */
+    bool setAutofocusPoint(int8_t x, int8_t y);
+    /**
+     * @brief Set how many times a remembered position is restored before a full
+     * autofocus is run again to refresh it.
+     *
+     * @param restores The number of restores; 0 to always run the full autofocus
+     */
+    void setRefreshInterval(uint16_t restores);
+    /**
+     * @brief Check whether the last call to focus() restored a remembered position.
+     *
+     * @return True if the focus was restored, false if a full autofocus was run
+     */
+    bool lastFocusWasRestored();
+
+    /**
+     * @brief Record a focus position for a zoom position and autofocus point.
+     *
+     * This is done automatically after each autofocus; call it directly to load
+     * positions saved earlier.
+     *
+     * @param zoom The zoom position
+     * @param point_x The horizontal autofocus point
+     * @param point_y The vertical autofocus point
+     * @param focus The focus position
+     */
+    void rememberFocus(int8_t zoom, int8_t point_x, int8_t point_y, int16_t focus);
+    /**
+     * @brief Get one of the remembered focus positions.
+     *
+     * @param index The entry, 0 to #GEOLUX_FOCUS_ENTRIES - 1
+     * @param entry The structure to copy the entry into
+     * @return True if the entry is in use, otherwise false
+     */
+    bool getEntry(uint8_t index, geolux_focus_entry* entry);
+    /**
+     * @brief Forget all remembered focus positions.
+     */
+    void clear();
+
+ protected:
+    /**
+     * @brief Find the remembered position for a zoom position and autofocus point.
+     *
+     * @param zoom The zoom position
+     * @param point_x The horizontal autofocus point
+     * @param point_y The vertical autofocus point
+     * @return The entry, or nullptr if there is none
+     */
+    geolux_focus_entry* findEntry(int8_t zoom, int8_t point_x, int8_t point_y);
+    /**
+     * @brief Read the autofocus point from the camera, if it isn't already known.
+     */
+    void readAutofocusPoint();
+    /**
+     * @brief Move the lens from a known focus position to another.
+     *
+     * @param position The current focus position
+     * @param target The focus position to move to
+     * @param timeout The maximum time in milliseconds to wait for the moves
+     * @return True if the lens reached the position, otherwise false
+     */
+    bool stepFocus(int16_t position, int16_t target, uint32_t timeout);
+
+    GeoluxCamera* _camera;                    ///< The camera to focus
+    uint16_t      _refresh_interval = 24;     ///< Restores between full autofocus runs
+    bool          _last_restored    = false;  ///< True if the last focus was restored
+    bool          _point_known      = false;  ///< True once the autofocus point is read
+    int8_t        _point_x          = 0;      ///< The horizontal autofocus point
+    int8_t        _point_y          = 0;      ///< The vertical autofocus point
+    uint8_t       _next_entry       = 0;      ///< The next entry to replace when full
+    /// The remembered focus positions
+    geolux_focus_entry _entries[GEOLUX_FOCUS_ENTRIES];
+};
+
+#endif  // GEOLUX_ENABLE_OPTICS && GEOLUX_ENABLE_INFO
+
+#endif  // SRC_GEOLUXFOCUS_H_
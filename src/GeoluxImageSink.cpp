@@ -0,0 +1,55 @@
+/**
+ * @file       GeoluxImageSink.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#include "GeoluxImageSink.h"
+
+GeoluxImageSink::GeoluxImageSink() : _output(nullptr), _output_sink(nullptr) {}
+GeoluxImageSink::GeoluxImageSink(Print* output)
+    : _output(output),
+      _output_sink(nullptr) {}
+GeoluxImageSink::GeoluxImageSink(Print& output)
+    : _output(&output),
+      _output_sink(nullptr) {}
+GeoluxImageSink::GeoluxImageSink(GeoluxImageSink* output)
+    : _output(output),
+      _output_sink(output) {}
+GeoluxImageSink::GeoluxImageSink(GeoluxImageSink& output)
+    : _output(&output),
+      _output_sink(&output) {}
+
+void GeoluxImageSink::setOutput(Print* output) {
+    _output      = output;
+    _output_sink = nullptr;
+}
+
+void GeoluxImageSink::setOutput(GeoluxImageSink* output) {
+    _output      = output;
+    _output_sink = output;
+}
+
+bool GeoluxImageSink::beginImage(int32_t image_size) {
+    if (_output_sink) { return _output_sink->beginImage(image_size); }
+    return true;
+}
+
+bool GeoluxImageSink::endImage(uint32_t bytes_written) {
+    if (_output_sink) { return _output_sink->endImage(bytes_written); }
+    return true;
+}
+
+size_t GeoluxImageSink::write(uint8_t b) {
+    return write(&b, 1);
+}
+
+size_t GeoluxImageSink::write(const uint8_t* buffer, size_t size) {
+    if (!_output) { return 0; }
+    return _output->write(buffer, size);
+}
+
+void GeoluxImageSink::flush() {
+    if (_output) { _output->flush(); }
+}
@@ -0,0 +1,91 @@
+/**
+ * @file       GeoluxImageSink.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Contains the base class for destinations and processing stages in the image
+ * transfer path.
+ */
+
+#ifndef SRC_GEOLUXIMAGESINK_H_
+#define SRC_GEOLUXIMAGESINK_H_
+
+#include <Arduino.h>
+
+/**
+ * @brief The base class for destinations and processing stages in the image transfer
+ * path.
+ *
+ * An image sink is a Print that GeoluxCamera::transferImage() writes the image bytes
+ * to, but it is also told when each image begins - with the size the camera reported
+ * - and when it ends. A sink may write the bytes on to another Print. If that next
+ * output is also an image sink, the begin and end of each image are passed along too,
+ * so stages can be chained: for example, a digest stage writing to a file stage.
+ *
+ * The base class just passes everything through to the next output.
+ */
+class GeoluxImageSink : public Print {
+
+ public:
+    /**
+     * @brief Construct a new GeoluxImageSink object with no output attached
+     */
+    GeoluxImageSink();
+    /**
+     * @brief Construct a new GeoluxImageSink object that writes on to another Print
+     *
+     * @param output The output to pass the image bytes to
+     */
+    explicit GeoluxImageSink(Print* output);
+    /** @copydoc GeoluxImageSink::GeoluxImageSink(Print* output) */
+    explicit GeoluxImageSink(Print& output);
+    /**
+     * @brief Construct a new GeoluxImageSink object that writes on to another image
+     * sink, passing along the begin and end of each image.
+     *
+     * @param output The image sink to pass the image bytes to
+     */
+    explicit GeoluxImageSink(GeoluxImageSink* output);
+    /** @copydoc GeoluxImageSink::GeoluxImageSink(GeoluxImageSink* output) */
+    explicit GeoluxImageSink(GeoluxImageSink& output);
+    /**
+     * @brief Destroy the GeoluxImageSink object - no action needed
+     */
+    virtual ~GeoluxImageSink() {}
+
+    /**
+     * @brief Attach the output to pass the image bytes to.
+     *
+     * @param output The output to pass the image bytes to
+     */
+    void setOutput(Print* output);
+    /** @copydoc GeoluxImageSink::setOutput(Print* output) */
+    void setOutput(GeoluxImageSink* output);
+
+    /**
+     * @brief Called before the first byte of an image is written.
+     *
+     * @param image_size The size of the image reported by the camera
+     * @return True if the sink is ready for the image; false aborts the transfer
+     */
+    virtual bool beginImage(int32_t image_size);
+    /**
+     * @brief Called after the last byte of an image is written.
+     *
+     * @param bytes_written The number of image bytes that were written
+     * @return True if the sink successfully finished the image, otherwise false
+     */
+    virtual bool endImage(uint32_t bytes_written);
+
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    void   flush() override;
+    using Print::write;
+
+ protected:
+    Print*           _output;       ///< The output to pass image bytes to
+    GeoluxImageSink* _output_sink;  ///< The output, if it is also an image sink
+};
+
+#endif  // SRC_GEOLUXIMAGESINK_H_
@@ -0,0 +1,726 @@
+/**
+ * @file       GeoluxJpeg.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#include "GeoluxJpeg.h"
+
+/// The sum of the entries in the standard IJG luminance quantization table, which
+/// libjpeg scales to quality 50
+static const uint32_t STD_LUMINANCE_SUM = 3688;
+
+bool GeoluxJpeg::parseHeader(const uint8_t* buf, size_t length,
+                             geolux_jpeg_header* header) {
+    memset(header, 0, sizeof(geolux_jpeg_header));
+    header->quality = -1;
+    if (length < 2 || buf[0] != 0xFF || buf[1] != 0xD8) { return false; }
+
+    bool   have_luminance = false;
+    size_t pos            = 2;
+    while (pos + 4 <= length) {
+        if (buf[pos] != 0xFF) { break; }
+        uint8_t marker = buf[pos + 1];
+        // skip fill bytes and markers that have no segment
+        if (marker == 0xFF) {
+            pos++;
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) {
+            pos += 2;
+            continue;
+        }
+        uint16_t segment_length = (static_cast<uint16_t>(buf[pos + 2]) << 8) |
+            buf[pos + 3];
+        if (segment_length < 2) { break; }
+        const uint8_t* segment = buf + pos + 4;
+        size_t         segment_end =
+            min(pos + 2 + static_cast<size_t>(segment_length), length);
+        size_t available = segment_end - (pos + 4);
+
+        if (marker == 0xDA) {
+            // start of scan; the headers are over
+            header->header_length = static_cast<uint16_t>(pos);
+            break;
+        } else if (marker == 0xDB) {
+            // a segment can hold several tables: each is a byte of precision (high
+            // nibble) and table id (low nibble) and 64 entries of 8 or 16 bits
+            size_t i = 0;
+            while (i < available) {
+                bool    wide     = segment[i] >> 4;
+                uint8_t table_id = segment[i] & 0x0F;
+                size_t  entries  = wide ? 128 : 64;
+                if (i + 1 + entries > available) { break; }
+                if (!have_luminance) {
+                    const uint8_t* table = segment + i + 1;
+                    uint32_t       sum   = 0;
+                    for (uint8_t j = 0; j < 64; j++) {
+                        if (wide) {
+                            sum += (static_cast<uint16_t>(table[2 * j]) << 8) |
+                                table[2 * j + 1];
+                        } else {
+                            sum += table[j];
+                        }
+                    }
+                    header->quality = estimateQuality(sum);
+                    have_luminance  = table_id == 0;
+                }
+                i += 1 + entries;
+            }
+        } else if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 &&
+                   marker != 0xC8 && marker != 0xCC) {
+            // a start of frame; C4, C8 and CC are Huffman, reserved and arithmetic
+            // coding segments that share the range
+            if (available >= 6) {
+                header->precision   = segment[0];
+                header->height      = (static_cast<uint16_t>(segment[1]) << 8) |
+                    segment[2];
+                header->width       = (static_cast<uint16_t>(segment[3]) << 8) |
+                    segment[4];
+                header->components  = segment[5];
+                header->progressive = (marker & 0x03) == 0x02;
+            }
+        }
+        pos += 2 + segment_length;
+    }
+    return header->width != 0;
+}
+
+bool GeoluxJpeg::parseHeader(const uint8_t* buf, size_t length,
+                             geolux_jpeg_header& header) {
+    return parseHeader(buf, length, &header);
+}
+
+int8_t GeoluxJpeg::estimateQuality(uint32_t table_sum) {
+    // at quality 100 every entry is 1
+    if (table_sum <= 64) { return 100; }
+    // libjpeg scales the standard table by 5000 / quality below 50 and by
+    // 200 - 2 * quality above, as a percentage; undo that from the average scaling
+    uint32_t scale = (table_sum * 100 + STD_LUMINANCE_SUM / 2) / STD_LUMINANCE_SUM;
+    int16_t  quality;
+    if (scale <= 100) {
+        quality = (200 - static_cast<int16_t>(scale) + 1) / 2;
+    } else {
+        quality = static_cast<int16_t>((5000 + scale / 2) / scale);
+    }
+    return static_cast<int8_t>(constrain(quality, 1, 100));
+}
+
+// parser states
+static const uint8_t JPEG_MARKER_START = 0;  ///< Expecting the 0xFF of a marker
+static const uint8_t JPEG_MARKER       = 1;  ///< Expecting the marker code
+static const uint8_t JPEG_LENGTH_HIGH  = 2;  ///< Expecting the segment length MSB
+static const uint8_t JPEG_LENGTH_LOW   = 3;  ///< Expecting the segment length LSB
+static const uint8_t JPEG_SEGMENT      = 4;  ///< Within a marker segment
+static const uint8_t JPEG_SCAN         = 5;  ///< Within entropy coded data
+static const uint8_t JPEG_SCAN_MARKER  = 6;  ///< After a 0xFF in entropy coded data
+static const uint8_t JPEG_DONE         = 7;  ///< Finished or stopped decoding
+
+/// The value of GeoluxJpegSink::_pending when the next step decodes a symbol
+static const uint8_t NO_PENDING = 0xFF;
+/// The first high frequency coefficient in zigzag order: the fifth anti-diagonal,
+/// where the horizontal and vertical frequencies add up to 4 or more
+static const uint8_t FIRST_HIGH_FREQUENCY = 10;
+
+/**
+ * @brief Count the blocks that GeoluxJpegSink::addBlock() adds to a row or column of
+ * thumbnail cells.
+ *
+ * @param cell The row or column of cells
+ * @param blocks The number of blocks down or across the image
+ * @param cells The number of cells down or across the thumbnail
+ * @return The number of blocks in the row or column
+ */
+static uint16_t blocksInCell(uint8_t cell, uint16_t blocks, uint8_t cells) {
+    // block b goes to cell b * cells / blocks, rounded down
+    uint32_t first = (static_cast<uint32_t>(cell) * blocks + cells - 1) / cells;
+    uint32_t end   = (static_cast<uint32_t>(cell + 1) * blocks + cells - 1) / cells;
+    return static_cast<uint16_t>(end - first);
+}
+
+GeoluxJpegSink::GeoluxJpegSink() : GeoluxImageSink() {
+    resetDecoder();
+}
+GeoluxJpegSink::GeoluxJpegSink(Print* output) : GeoluxImageSink(output) {
+    resetDecoder();
+}
+GeoluxJpegSink::GeoluxJpegSink(Print& output) : GeoluxImageSink(output) {
+    resetDecoder();
+}
+GeoluxJpegSink::GeoluxJpegSink(GeoluxImageSink* output) : GeoluxImageSink(output) {
+    resetDecoder();
+}
+GeoluxJpegSink::GeoluxJpegSink(GeoluxImageSink& output) : GeoluxImageSink(output) {
+    resetDecoder();
+}
+
+bool GeoluxJpegSink::beginImage(int32_t image_size) {
+    resetDecoder();
+    return GeoluxImageSink::beginImage(image_size);
+}
+
+void GeoluxJpegSink::resetDecoder() {
+    _state            = JPEG_MARKER_START;
+    _failed           = false;
+    _decoded          = false;
+    _table_pos        = 0;
+    _tables_defined   = 0;
+    _component_count  = 0;
+    _restart_interval = 0;
+    _cells_wide       = 0;
+    _cells_high       = 0;
+    _mcus_total       = 0;
+    _mcus_done        = 0;
+    _ac_total         = 0;
+    _ac_high          = 0;
+    for (uint8_t i = 0; i < 4; i++) { _dc_quant[i] = 1; }
+    memset(_sums, 0, sizeof(_sums));
+}
+
+bool GeoluxJpegSink::endImage(uint32_t bytes_written) {
+    _decoded = !_failed && _state == JPEG_DONE && _mcus_total &&
+        _mcus_done == _mcus_total;
+    if (_decoded) {
+        finishThumbnail();
+        // keep the ratio from overflowing
+        while (_ac_high > UINT32_MAX / 1000) {
+            _ac_high >>= 1;
+            _ac_total >>= 1;
+        }
+        _sharpness = _ac_total ? _ac_high * 1000 / _ac_total : 0;
+    } else {
+        _difference        = -1;
+        _brightness_change = 0;
+        _sharpness         = 0;
+    }
+    return GeoluxImageSink::endImage(bytes_written);
+}
+
+size_t GeoluxJpegSink::write(const uint8_t* buffer, size_t size) {
+    // only decode what the next output actually accepted
+    size_t written = _output ? _output->write(buffer, size) : size;
+    for (size_t i = 0; i < written && _state != JPEG_DONE; i++) {
+        parseByte(buffer[i]);
+    }
+    return written;
+}
+
+bool GeoluxJpegSink::wasDecoded() {
+    return _decoded;
+}
+
+const uint8_t* GeoluxJpegSink::getThumbnail() {
+    return _thumbnail;
+}
+
+uint8_t GeoluxJpegSink::getThumbnailWidth() {
+    return _thumb_wide;
+}
+
+uint8_t GeoluxJpegSink::getThumbnailHeight() {
+    return _thumb_high;
+}
+
+int16_t GeoluxJpegSink::getDifference() {
+    return _difference;
+}
+
+int16_t GeoluxJpegSink::getBrightnessChange() {
+    return _brightness_change;
+}
+
+uint16_t GeoluxJpegSink::getSharpness() {
+    return _sharpness;
+}
+
+void GeoluxJpegSink::clearThumbnail() {
+    _thumb_wide        = 0;
+    _thumb_high        = 0;
+    _difference        = -1;
+    _brightness_change = 0;
+}
+
+void GeoluxJpegSink::parseByte(uint8_t b) {
+    switch (_state) {
+        case JPEG_MARKER_START:
+            if (b == 0xFF) {
+                _state = JPEG_MARKER;
+            } else {
+                stop();
+            }
+            break;
+        case JPEG_MARKER:
+            // 0xFF may be repeated as fill before the marker code
+            if (b == 0xFF) { break; }
+            _marker = b;
+            if (b == 0xD9) {
+                stop();
+            } else if (b == 0xD8 || b == 0x01 || (b >= 0xD0 && b <= 0xD7)) {
+                // markers without a segment
+                _state = JPEG_MARKER_START;
+            } else {
+                _state = JPEG_LENGTH_HIGH;
+            }
+            break;
+        case JPEG_LENGTH_HIGH:
+            _remaining = static_cast<uint16_t>(b) << 8;
+            _state     = JPEG_LENGTH_LOW;
+            break;
+        case JPEG_LENGTH_LOW:
+            _remaining |= b;
+            if (_remaining < 2) {
+                stop();
+                break;
+            }
+            _remaining -= 2;
+            _segment_pos = 0;
+            _table_pos   = 0;
+            _state       = JPEG_SEGMENT;
+            if (!_remaining) { endSegment(); }
+            break;
+        case JPEG_SEGMENT:
+            segmentByte(b);
+            if (_state != JPEG_SEGMENT) { break; }
+            _segment_pos++;
+            if (!--_remaining) { endSegment(); }
+            break;
+        case JPEG_SCAN:
+            if (b == 0xFF) {
+                _state = JPEG_SCAN_MARKER;
+            } else {
+                feedBits(b);
+            }
+            break;
+        case JPEG_SCAN_MARKER:
+            if (b == 0x00) {
+                // a stuffed zero after a data byte of 0xFF
+                _state = JPEG_SCAN;
+                feedBits(0xFF);
+            } else if (b >= 0xD0 && b <= 0xD7) {
+                // a restart marker: the DC predictions and bit buffer start over
+                endInterval();
+                if (_state == JPEG_DONE) { break; }
+                for (uint8_t i = 0; i < _scan_count; i++) { _scan[i].dc_pred = 0; }
+                _bit_count = 0;
+                _mcus_left = min(static_cast<uint32_t>(_restart_interval),
+                                 _mcus_total - _mcus_done);
+                _state     = JPEG_SCAN;
+            } else if (b != 0xFF) {
+                // the end of the image or of the first scan; only the first scan is
+                // decoded
+                endInterval();
+                _state = JPEG_DONE;
+            }
+            break;
+        default: break;
+    }
+}
+
+void GeoluxJpegSink::segmentByte(uint8_t b) {
+    if (_marker == 0xC4) {
+        huffmanByte(b);
+    } else if (_marker == 0xDB) {
+        quantByte(b);
+    } else if (_segment_pos < sizeof(_segment)) {
+        _segment[_segment_pos] = b;
+    }
+}
+
+void GeoluxJpegSink::endSegment() {
+    _state = JPEG_MARKER_START;
+    if (_marker == 0xC0 || _marker == 0xC1) {
+        if (!startFrame()) { stop(); }
+    } else if (_marker >= 0xC2 && _marker <= 0xCF && _marker != 0xC4 &&
+               _marker != 0xC8 && _marker != 0xCC) {
+        // progressive, lossless and arithmetic coded frames aren't decoded
+        stop();
+    } else if (_marker == 0xC4) {
+        if (_table_pos) { stop(); }
+    } else if (_marker == 0xDD) {
+        if (_segment_pos < 2) {
+            stop();
+        } else {
+            _restart_interval = (static_cast<uint16_t>(_segment[0]) << 8) |
+                _segment[1];
+        }
+    } else if (_marker == 0xDA) {
+        if (startScan()) {
+            _state = JPEG_SCAN;
+        } else {
+            stop();
+        }
+    }
+}
+
+void GeoluxJpegSink::huffmanByte(uint8_t b) {
+    if (_table_pos == 0) {
+        // table class (0 for DC, 1 for AC) and identifier; baseline uses 0 and 1
+        uint8_t table_class = b >> 4;
+        uint8_t table_id    = b & 0x0F;
+        if (table_class > 1 || table_id > 1) {
+            stop();
+            return;
+        }
+        _table        = table_class * 2 + table_id;
+        _table_values = 0;
+        _table_code   = 0;
+        _table_pos    = 1;
+        return;
+    }
+    if (_table_pos <= 16) {
+        // the number of codes of each length, from which the canonical codes follow
+        huffman_table& table  = _huffman[_table];
+        uint8_t        length = _table_pos - 1;
+        table.first[length]   = static_cast<uint16_t>(_table_code);
+        table.index[length]   = static_cast<uint8_t>(_table_values);
+        _table_code += b;
+        _table_values += b;
+        table.end[length] = b ? static_cast<uint16_t>(_table_code) : 0;
+        // the codes of a length can't run past the all ones code
+        if (_table_code > (1UL << (length + 1)) ||
+            _table_values > (_table < 2 ? 12 : 162)) {
+            stop();
+            return;
+        }
+        _table_code <<= 1;
+        _table_pos++;
+        if (_table_pos == 17 && !_table_values) { _table_pos = 0; }
+        return;
+    }
+    uint8_t index = static_cast<uint8_t>(_table_pos - 17);
+    if (_table < 2) {
+        _dc_values[_table][index] = b;
+    } else {
+        _ac_values[_table - 2][index] = b;
+    }
+    _table_pos++;
+    if (index + 1 == _table_values) {
+        _tables_defined |= 1 << _table;
+        _table_pos = 0;
+    }
+}
+
+void GeoluxJpegSink::quantByte(uint8_t b) {
+    // each table is a byte of precision and identifier then 64 entries of 8 or 16
+    // bits, in zigzag order
+    if (_table_pos == 0) {
+        _table        = b & 0x03;
+        _table_values = (b >> 4) ? 128 : 64;
+        _table_pos    = 1;
+        return;
+    }
+    uint16_t entry = b;
+    uint8_t  index = _table_pos - 1;
+    if (_table_values == 128) {
+        index /= 2;
+        if (_table_pos & 1) {
+            // the high byte of a 16 bit entry
+            _quant_high = b;
+            _table_pos++;
+            return;
+        }
+        entry |= static_cast<uint16_t>(_quant_high) << 8;
+    }
+    if (index == 0) { _dc_quant[_table] = entry; }
+    if (_table < 2) { _ac_quant[_table][index] = entry > 255 ? 255 : entry; }
+    if (_table_pos++ == _table_values) { _table_pos = 0; }
+}
+
+bool GeoluxJpegSink::startFrame() {
+    if (_segment_pos < 6 || _segment[0] != 8) { return false; }
+    _height          = (static_cast<uint16_t>(_segment[1]) << 8) | _segment[2];
+    _width           = (static_cast<uint16_t>(_segment[3]) << 8) | _segment[4];
+    _component_count = _segment[5];
+    if (!_width || !_height || !_component_count || _component_count > 3 ||
+        _segment_pos < 6 + 3 * _component_count) {
+        return false;
+    }
+    _h_max = 1;
+    _v_max = 1;
+    for (uint8_t i = 0; i < _component_count; i++) {
+        frame_component& c = _components[i];
+        c.id               = _segment[6 + 3 * i];
+        c.h                = _segment[7 + 3 * i] >> 4;
+        c.v                = _segment[7 + 3 * i] & 0x0F;
+        c.quant            = _segment[8 + 3 * i] & 0x03;
+        if (c.h < 1 || c.h > 4 || c.v < 1 || c.v > 4) { return false; }
+        _h_max = max(_h_max, c.h);
+        _v_max = max(_v_max, c.v);
+    }
+    // the first component is luminance; chroma may be subsampled
+    const frame_component& luma = _components[0];
+    uint32_t               luma_wide =
+        (static_cast<uint32_t>(_width) * luma.h + _h_max - 1) / _h_max;
+    uint32_t luma_high =
+        (static_cast<uint32_t>(_height) * luma.v + _v_max - 1) / _v_max;
+    _blocks_wide = static_cast<uint16_t>((luma_wide + 7) / 8);
+    _blocks_high = static_cast<uint16_t>((luma_high + 7) / 8);
+    _cells_wide  = static_cast<uint8_t>(
+        min(_blocks_wide, static_cast<uint16_t>(GEOLUX_THUMBNAIL_WIDTH)));
+    _cells_high = static_cast<uint8_t>(
+        min(_blocks_high, static_cast<uint16_t>(GEOLUX_THUMBNAIL_HEIGHT)));
+    // scale the block means down if a cell's sum could overflow
+    uint32_t blocks_per_cell =
+        static_cast<uint32_t>(blocksInCell(0, _blocks_wide, _cells_wide) + 1) *
+        (blocksInCell(0, _blocks_high, _cells_high) + 1);
+    _level_shift = 0;
+    while (blocks_per_cell * (255 >> _level_shift) > UINT16_MAX) { _level_shift++; }
+    return true;
+}
+
+bool GeoluxJpegSink::startScan() {
+    _scan_count = _segment[0];
+    if (!_component_count || !_scan_count || _scan_count > _component_count ||
+        _segment_pos < 4 + 2 * _scan_count) {
+        return false;
+    }
+    bool has_luma = false;
+    for (uint8_t i = 0; i < _scan_count; i++) {
+        scan_component& s  = _scan[i];
+        uint8_t         id = _segment[1 + 2 * i];
+        s.component        = _component_count;
+        for (uint8_t j = 0; j < _component_count; j++) {
+            if (_components[j].id == id) { s.component = j; }
+        }
+        s.dc_table = _segment[2 + 2 * i] >> 4;
+        s.ac_table = _segment[2 + 2 * i] & 0x0F;
+        s.dc_pred  = 0;
+        if (s.component == _component_count || s.dc_table > 1 || s.ac_table > 1 ||
+            !(_tables_defined & (1 << s.dc_table)) ||
+            !(_tables_defined & (1 << (2 + s.ac_table)))) {
+            return false;
+        }
+        has_luma |= s.component == 0;
+    }
+    // a sequential scan covers coefficients 0-63 with no successive approximation
+    const uint8_t* spectral = _segment + 1 + 2 * _scan_count;
+    if (!has_luma || spectral[0] != 0 || spectral[1] != 63 || spectral[2] != 0) {
+        return false;
+    }
+
+    uint16_t mcus_high;
+    if (_scan_count > 1) {
+        // interleaved: each MCU holds h x v blocks of every component
+        _mcus_per_line = (_width + 8 * _h_max - 1) / (8 * _h_max);
+        mcus_high      = (_height + 8 * _v_max - 1) / (8 * _v_max);
+    } else {
+        // non-interleaved: each MCU is a single block
+        _mcus_per_line = _blocks_wide;
+        mcus_high      = _blocks_high;
+    }
+    _mcus_total = static_cast<uint32_t>(_mcus_per_line) * mcus_high;
+    _mcus_done  = 0;
+    _mcus_left  = _restart_interval
+         ? min(static_cast<uint32_t>(_restart_interval), _mcus_total)
+         : _mcus_total;
+    _luma_quant = _components[0].quant < 2 ? _ac_quant[_components[0].quant]
+                                           : nullptr;
+    _mcu_x      = 0;
+    _mcu_y      = 0;
+    _scan_index = 0;
+    _block      = 0;
+    _k          = 0;
+    _pending    = NO_PENDING;
+    _bit_count  = 0;
+    _padding    = 0;
+    return true;
+}
+
+void GeoluxJpegSink::feedBits(uint8_t b) {
+    // anything after the last block of an interval is padding
+    if (!_mcus_left) { return; }
+    _bits = (_bits << 8) | b;
+    _bit_count += 8;
+    // a symbol's code or its extra bits are never more than 16 bits
+    while (_bit_count >= 16 && _mcus_left && _state == JPEG_SCAN) { decodeStep(); }
+}
+
+void GeoluxJpegSink::endInterval() {
+    // the last blocks of the interval are still waiting for 16 bits to arrive
+    while (_mcus_left && _state != JPEG_DONE) {
+        decodeStep();
+        // a real stream never needs more bits than it sent
+        if (_padding) { stop(); }
+    }
+}
+
+void GeoluxJpegSink::decodeStep() {
+    scan_component& s = _scan[_scan_index];
+    if (_pending == NO_PENDING) {
+        uint8_t symbol;
+        if (!decodeSymbol(_k ? 2 + s.ac_table : s.dc_table, &symbol)) {
+            stop();
+            return;
+        }
+        if (_k == 0) {
+            // DC: the symbol is the size of the difference from the last block
+            if (symbol > 11) {
+                stop();
+                return;
+            }
+            _pending = symbol;
+        } else {
+            // AC: the symbol is a run of zeros and the size of the next value
+            uint8_t run  = symbol >> 4;
+            uint8_t size = symbol & 0x0F;
+            if (!size) {
+                if (run == 15) {
+                    // sixteen zeros
+                    _k += 16;
+                    if (_k > 63) { stop(); }
+                } else {
+                    // end of block
+                    endBlock();
+                }
+                return;
+            }
+            _k += run;
+            if (_k > 63) {
+                stop();
+                return;
+            }
+            _pending = size;
+        }
+        if (_bit_count < _pending) { return; }
+    }
+
+    // the value, in the sign-magnitude form JPEG calls EXTEND
+    int16_t value = 0;
+    if (_pending) {
+        value = static_cast<int16_t>(peekBits() >> (16 - _pending));
+        skipBits(_pending);
+        if (value < (1 << (_pending - 1))) { value -= (1 << _pending) - 1; }
+    }
+    _pending = NO_PENDING;
+    if (_k == 0) {
+        s.dc_pred += value;
+        _measure_block = s.component == 0 && addBlock(s.dc_pred);
+    } else if (_measure_block) {
+        // total the AC energy, as the magnitude of the dequantized coefficients
+        uint32_t magnitude = value < 0 ? -value : value;
+        if (_luma_quant) { magnitude *= _luma_quant[_k]; }
+        _ac_total += magnitude;
+        if (_k >= FIRST_HIGH_FREQUENCY) { _ac_high += magnitude; }
+        if (_ac_total & 0x80000000UL) {
+            _ac_total >>= 1;
+            _ac_high >>= 1;
+        }
+    }
+    if (++_k > 63) { endBlock(); }
+}
+
+bool GeoluxJpegSink::decodeSymbol(uint8_t table, uint8_t* symbol) {
+    const huffman_table& t    = _huffman[table];
+    uint16_t             look = peekBits();
+    for (uint8_t length = 0; length < 16; length++) {
+        uint16_t code = look >> (15 - length);
+        if (code < t.end[length]) {
+            skipBits(length + 1);
+            uint8_t index = t.index[length] + (code - t.first[length]);
+            *symbol       = table < 2 ? _dc_values[table][index]
+                                      : _ac_values[table - 2][index];
+            return true;
+        }
+    }
+    return false;
+}
+
+uint16_t GeoluxJpegSink::peekBits() {
+    if (_bit_count >= 16) { return static_cast<uint16_t>(_bits >> (_bit_count - 16)); }
+    return static_cast<uint16_t>((_bits << (16 - _bit_count)) |
+                                 (0xFFFFUL >> _bit_count));
+}
+
+void GeoluxJpegSink::skipBits(uint8_t count) {
+    if (count > _bit_count) {
+        _padding += count - _bit_count;
+        _bit_count = 0;
+    } else {
+        _bit_count -= count;
+    }
+}
+
+bool GeoluxJpegSink::addBlock(int16_t dc) {
+    uint16_t block_x = _mcu_x;
+    uint16_t block_y = _mcu_y;
+    if (_scan_count > 1) {
+        const frame_component& c = _components[0];
+        block_x                  = _mcu_x * c.h + _block % c.h;
+        block_y                  = _mcu_y * c.v + _block / c.h;
+    }
+    // interleaved MCUs can run past the edge of the image
+    if (block_x >= _blocks_wide || block_y >= _blocks_high) { return false; }
+    // the DC coefficient is 8 times the mean of the block, less the level shift
+    int32_t level = static_cast<int32_t>(dc) * _dc_quant[_components[0].quant] / 8;
+    level         = constrain(level + 128, 0, 255);
+    uint8_t cell_x = static_cast<uint32_t>(block_x) * _cells_wide / _blocks_wide;
+    uint8_t cell_y = static_cast<uint32_t>(block_y) * _cells_high / _blocks_high;
+    _sums[cell_y * GEOLUX_THUMBNAIL_WIDTH + cell_x] += level >> _level_shift;
+    return true;
+}
+
+void GeoluxJpegSink::endBlock() {
+    _k = 0;
+    const frame_component& c = _components[_scan[_scan_index].component];
+    if (_scan_count > 1 && ++_block < c.h * c.v) { return; }
+    _block = 0;
+    if (++_scan_index < _scan_count) { return; }
+    _scan_index = 0;
+    _mcus_done++;
+    _mcus_left--;
+    if (++_mcu_x == _mcus_per_line) {
+        _mcu_x = 0;
+        _mcu_y++;
+    }
+}
+
+void GeoluxJpegSink::finishThumbnail() {
+    // turn the sums into means, in place, and total both thumbnails
+    uint16_t cells      = _cells_wide * _cells_high;
+    bool     comparable = _thumb_wide == _cells_wide && _thumb_high == _cells_high;
+    int32_t  new_total  = 0;
+    int32_t  old_total  = 0;
+    for (uint8_t y = 0; y < _cells_high; y++) {
+        uint16_t rows = blocksInCell(y, _blocks_high, _cells_high);
+        for (uint8_t x = 0; x < _cells_wide; x++) {
+            uint16_t  cols = blocksInCell(x, _blocks_wide, _cells_wide);
+            uint16_t& sum  = _sums[y * GEOLUX_THUMBNAIL_WIDTH + x];
+            sum = (static_cast<uint32_t>(sum) << _level_shift) / (rows * cols);
+            new_total += sum;
+            old_total += _thumbnail[y * _cells_wide + x];
+        }
+    }
+
+    // compare the cells with the change in overall brightness taken out, scaled up by
+    // the number of cells to stay in integers
+    _difference        = -1;
+    _brightness_change = 0;
+    if (comparable) {
+        uint32_t total_difference = 0;
+        for (uint8_t y = 0; y < _cells_high; y++) {
+            for (uint8_t x = 0; x < _cells_wide; x++) {
+                int32_t new_cell = _sums[y * GEOLUX_THUMBNAIL_WIDTH + x];
+                int32_t old_cell = _thumbnail[y * _cells_wide + x];
+                int32_t d = (new_cell * cells - new_total) -
+                    (old_cell * cells - old_total);
+                total_difference += d < 0 ? -d : d;
+            }
+        }
+        _difference = total_difference / (static_cast<uint32_t>(cells) * cells);
+        _brightness_change = (new_total - old_total) / cells;
+    }
+
+    for (uint8_t y = 0; y < _cells_high; y++) {
+        for (uint8_t x = 0; x < _cells_wide; x++) {
+            _thumbnail[y * _cells_wide + x] = _sums[y * GEOLUX_THUMBNAIL_WIDTH + x];
+        }
+    }
+    _thumb_wide = _cells_wide;
+    _thumb_high = _cells_high;
+}
+
+void GeoluxJpegSink::stop() {
+    _failed = true;
+    _state  = JPEG_DONE;
+}
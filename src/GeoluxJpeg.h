@@ -0,0 +1,399 @@
+/**
+ * @file       GeoluxJpeg.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Contains a parser for the header segments at the start of a JPEG image and an
+ * image sink that decodes a low resolution thumbnail as the image is transferred.
+ */
+
+#ifndef SRC_GEOLUXJPEG_H_
+#define SRC_GEOLUXJPEG_H_
+
+#include <Arduino.h>
+#include "GeoluxImageSink.h"
+
+/**
+ * @def GEOLUX_THUMBNAIL_WIDTH
+ * @brief The maximum width of the thumbnail built by GeoluxJpegSink, in cells.
+ */
+/**
+ * @def GEOLUX_THUMBNAIL_HEIGHT
+ * @brief The maximum height of the thumbnail built by GeoluxJpegSink, in cells.
+ *
+ * The thumbnail takes 3 bytes of RAM per cell.
+ */
+#ifndef GEOLUX_THUMBNAIL_WIDTH
+#if defined(__AVR__)
+#define GEOLUX_THUMBNAIL_WIDTH 16
+#else
+#define GEOLUX_THUMBNAIL_WIDTH 32
+#endif
+#endif
+#ifndef GEOLUX_THUMBNAIL_HEIGHT
+#if defined(__AVR__)
+#define GEOLUX_THUMBNAIL_HEIGHT 12
+#else
+#define GEOLUX_THUMBNAIL_HEIGHT 24
+#endif
+#endif
+
+/**
+ * @brief Reads the frame header and quantization tables from the start of a JPEG
+ * image.
+ *
+ * Only the marker segments before the first scan are looked at, so the first few
+ * hundred bytes of an image are enough to describe it.
+ */
+class GeoluxJpeg {
+
+ public:
+    /// @brief The description of an image read from its JPEG header
+    typedef struct {
+        uint16_t width;          ///< The image width in pixels; 0 if no frame header
+        uint16_t height;         ///< The image height in pixels
+        uint8_t  components;     ///< The number of color components; 1 for grayscale
+        uint8_t  precision;      ///< The sample precision in bits, normally 8
+        bool     progressive;    ///< True for a progressive rather than baseline image
+        int8_t   quality;        ///< The estimated JPEG quality, 1-100; -1 if unknown
+        uint16_t header_length;  ///< The offset of the first scan; 0 if not reached
+    } geolux_jpeg_header;
+
+    /**
+     * @brief Parse the header segments at the start of a JPEG image.
+     *
+     * The quality is estimated by comparing the luminance quantization table to the
+     * standard IJG table that libjpeg scales by its quality setting. An image made
+     * with custom tables still gets an estimate, but it only shows how coarsely the
+     * image was quantized.
+     *
+     * @param buf The start of the image
+     * @param length The number of bytes in the buffer
+     * @param header The structure to fill in
+     * @return True if a frame header with the image dimensions was found, otherwise
+     * false
+     */
+    static bool parseHeader(const uint8_t* buf, size_t length,
+                            geolux_jpeg_header* header);
+    /** @copydoc GeoluxJpeg::parseHeader(const uint8_t* buf, size_t length,
+     * geolux_jpeg_header* header) */
+    static bool parseHeader(const uint8_t* buf, size_t length,
+                            geolux_jpeg_header& header);
+
+    /**
+     * @brief Estimate the IJG quality setting that produced a luminance quantization
+     * table.
+     *
+     * The order of the table doesn't matter. Below a quality of about 10 many entries
+     * are clipped at 255 and the estimate reads high.
+     *
+     * @param table_sum The sum of the 64 entries of the table
+     * @return The estimated quality, 1-100
+     */
+    static int8_t estimateQuality(uint32_t table_sum);
+};
+
+/**
+ * @brief An image sink that decodes the coefficients of a baseline JPEG as the image
+ * streams past, building a luminance thumbnail, scoring how much the scene changed
+ * since the last image and measuring how sharp the image is.
+ *
+ * The DC coefficient of each 8x8 block is the mean brightness of the block, so the DC
+ * values alone are a 1/8 scale image. Only the Huffman codes are decoded; there is no
+ * inverse DCT and nothing is held back from the output. The block means are averaged
+ * into a grid of at most #GEOLUX_THUMBNAIL_WIDTH by #GEOLUX_THUMBNAIL_HEIGHT cells,
+ * so the RAM used doesn't depend on the image size: about 850 bytes for the Huffman
+ * and quantization tables plus 3 bytes per cell.
+ *
+ * After each image the thumbnail is compared to the one from the image before. The
+ * difference score is the mean absolute difference of the cells, 0-255, after the
+ * change in overall brightness is taken out, so a passing cloud scores low and a
+ * moved object scores high. Use it to decide whether an image is worth keeping or
+ * uploading.
+ *
+ * The AC coefficients of each luminance block hold its detail. A focused image has
+ * more of that detail at high frequencies than a blurred one, so the share of the AC
+ * energy at high frequencies is a focus score that doesn't need the image decoded.
+ * Compare it to the score of an image taken just after autofocus and only refocus
+ * when it drops.
+ *
+ * Only baseline and extended sequential Huffman coded images with 8-bit samples are
+ * decoded; others pass through to the output untouched without a thumbnail.
+ */
+class GeoluxJpegSink : public GeoluxImageSink {
+
+ public:
+    /**
+     * @brief Construct a new GeoluxJpegSink object with no output attached
+     */
+    GeoluxJpegSink();
+    /**
+     * @brief Construct a new GeoluxJpegSink object that writes on to another Print
+     *
+     * @param output The output to pass the image bytes to
+     */
+    explicit GeoluxJpegSink(Print* output);
+    /** @copydoc GeoluxJpegSink::GeoluxJpegSink(Print* output) */
+    explicit GeoluxJpegSink(Print& output);
+    /**
+     * @brief Construct a new GeoluxJpegSink object that writes on to another image sink
+     *
+     * @param output The image sink to pass the image bytes to
+     */
+    explicit GeoluxJpegSink(GeoluxImageSink* output);
+    /** @copydoc GeoluxJpegSink::GeoluxJpegSink(GeoluxImageSink* output) */
+    explicit GeoluxJpegSink(GeoluxImageSink& output);
+
+    bool beginImage(int32_t image_size) override;
+    bool endImage(uint32_t bytes_written) override;
+
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using GeoluxImageSink::write;
+
+    /**
+     * @brief Check whether the last image was decoded.
+     *
+     * @return True if the last image was decoded and the thumbnail is from it
+     */
+    bool wasDecoded();
+    /**
+     * @brief Get the thumbnail of the last decoded image.
+     *
+     * @return The thumbnail as rows of 8-bit luminance values, top row first
+     */
+    const uint8_t* getThumbnail();
+    /**
+     * @brief Get the width of the thumbnail.
+     *
+     * @return The number of cells across the thumbnail; 0 if no image was decoded
+     */
+    uint8_t getThumbnailWidth();
+    /**
+     * @brief Get the height of the thumbnail.
+     *
+     * @return The number of cells down the thumbnail; 0 if no image was decoded
+     */
+    uint8_t getThumbnailHeight();
+    /**
+     * @brief Get how much the scene changed between the last two decoded images.
+     *
+     * @return The mean absolute difference of the thumbnail cells, 0-255, with the
+     * change in overall brightness taken out; -1 if the last image was not decoded or
+     * there is no earlier thumbnail of the same size to compare it to
+     */
+    int16_t getDifference();
+    /**
+     * @brief Get the change in overall brightness between the last two decoded images.
+     *
+     * @return The change in the mean luminance, -255 to 255; 0 if the images could not
+     * be compared
+     */
+    int16_t getBrightnessChange();
+    /**
+     * @brief Get the sharpness of the last decoded image.
+     *
+     * The score is the share of the dequantized luminance AC energy in the high
+     * frequencies, those with horizontal and vertical frequencies adding to 4 or more.
+     * It depends on the scene as well as the focus, so compare it between images of
+     * the same scene. Noise in dim light raises it, and stronger compression lowers it.
+     *
+     * @return The sharpness, in parts per thousand; 0 if the last image was not
+     * decoded
+     */
+    uint16_t getSharpness();
+    /**
+     * @brief Forget the last thumbnail, so the next image is not compared to anything.
+     */
+    void clearThumbnail();
+
+ protected:
+    /// @brief A Huffman table, decoded in canonical order by code length
+    typedef struct {
+        uint16_t end[16];    ///< One past the last code of each length; 0 if none
+        uint16_t first[16];  ///< The first code of each length
+        uint8_t  index[16];  ///< The value index of the first code of each length
+    } huffman_table;
+    /// @brief A color component of the frame
+    typedef struct {
+        uint8_t id;     ///< The component identifier
+        uint8_t h;      ///< The horizontal sampling factor
+        uint8_t v;      ///< The vertical sampling factor
+        uint8_t quant;  ///< The quantization table used
+    } frame_component;
+    /// @brief A color component of the scan
+    typedef struct {
+        uint8_t component;  ///< The index of the frame component
+        uint8_t dc_table;   ///< The DC Huffman table used
+        uint8_t ac_table;   ///< The AC Huffman table used
+        int16_t dc_pred;    ///< The DC value of the previous block
+    } scan_component;
+
+    /**
+     * @brief Parse the next byte of the image.
+     *
+     * @param b The byte
+     */
+    void parseByte(uint8_t b);
+    /**
+     * @brief Handle the next byte of a marker segment.
+     *
+     * @param b The byte
+     */
+    void segmentByte(uint8_t b);
+    /**
+     * @brief Handle the end of a marker segment.
+     */
+    void endSegment();
+    /**
+     * @brief Handle the next byte of a Huffman table segment.
+     *
+     * @param b The byte
+     */
+    void huffmanByte(uint8_t b);
+    /**
+     * @brief Handle the next byte of a quantization table segment.
+     *
+     * @param b The byte
+     */
+    void quantByte(uint8_t b);
+    /**
+     * @brief Set up the thumbnail from a frame header.
+     *
+     * @return True if the frame can be decoded, otherwise false
+     */
+    bool startFrame();
+    /**
+     * @brief Set up the entropy decoder from a scan header.
+     *
+     * @return True if the scan can be decoded, otherwise false
+     */
+    bool startScan();
+    /**
+     * @brief Add the next byte of entropy coded data and decode what it completes.
+     *
+     * @param b The byte, with any stuffed zero removed
+     */
+    void feedBits(uint8_t b);
+    /**
+     * @brief Decode the remaining blocks of a restart interval when a marker ends it.
+     */
+    void endInterval();
+    /**
+     * @brief Decode one Huffman symbol or the extra bits that follow it.
+     */
+    void decodeStep();
+    /**
+     * @brief Decode a Huffman symbol.
+     *
+     * @param table The table to use; 0-1 for DC tables, 2-3 for AC tables
+     * @param symbol The decoded symbol
+     * @return True if a code was found, otherwise false
+     */
+    bool decodeSymbol(uint8_t table, uint8_t* symbol);
+    /**
+     * @brief Get the next 16 bits of entropy coded data without using them.
+     *
+     * When fewer than 16 bits are waiting, the rest are filled with ones, as the
+     * encoder pads the end of an interval.
+     *
+     * @return The next 16 bits
+     */
+    uint16_t peekBits();
+    /**
+     * @brief Use up bits of entropy coded data.
+     *
+     * @param count The number of bits
+     */
+    void skipBits(uint8_t count);
+    /**
+     * @brief Add the DC value of a luminance block to the thumbnail.
+     *
+     * @param dc The quantized DC coefficient
+     * @return True if the block is within the image, otherwise false
+     */
+    bool addBlock(int16_t dc);
+    /**
+     * @brief Move on to the next block once the current one is finished.
+     */
+    void endBlock();
+    /**
+     * @brief Build the thumbnail from the block sums and compare it to the last one.
+     */
+    void finishThumbnail();
+    /**
+     * @brief Stop decoding the image; it is still passed through to the output.
+     */
+    void stop();
+
+    uint8_t  _state;           ///< The parser state
+    uint8_t  _marker;          ///< The marker of the current segment
+    uint16_t _remaining;       ///< The bytes left in the current segment
+    uint16_t _segment_pos;     ///< The position within the current segment
+    uint8_t  _segment[16];     ///< The start of the current segment
+    bool     _failed;          ///< True if the image could not be decoded
+    bool     _decoded = false; ///< True if the last image was decoded
+    uint16_t _table_pos;       ///< The position within the current table
+    uint8_t  _table;           ///< The table being defined
+    uint16_t _table_values;    ///< The number of values in the table being defined
+    uint32_t _table_code;      ///< The next code of the table being defined
+    uint8_t  _tables_defined;  ///< A bit for each Huffman table defined
+
+    huffman_table _huffman[4];         ///< The DC and AC Huffman tables
+    uint8_t       _dc_values[2][12];   ///< The values of the DC Huffman tables
+    uint8_t       _ac_values[2][162];  ///< The values of the AC Huffman tables
+    uint16_t      _dc_quant[4];        ///< The DC entry of each quantization table
+    uint8_t       _ac_quant[2][64];    ///< Quantization tables 0 and 1, up to 255
+    uint8_t       _quant_high;         ///< The high byte of a 16 bit table entry
+
+    uint16_t        _width;             ///< The image width
+    uint16_t        _height;            ///< The image height
+    frame_component _components[3];     ///< The frame components
+    uint8_t         _component_count;   ///< The number of frame components
+    uint8_t         _h_max;             ///< The largest horizontal sampling factor
+    uint8_t         _v_max;             ///< The largest vertical sampling factor
+    uint16_t        _restart_interval;  ///< The MCUs per restart interval; 0 for none
+    scan_component  _scan[3];           ///< The scan components
+    uint8_t         _scan_count;        ///< The number of scan components
+
+    uint32_t _bits;           ///< Entropy coded bits waiting to be decoded
+    uint8_t  _bit_count;      ///< The number of bits waiting
+    uint8_t  _padding;        ///< The padding bits used at the end of an interval
+    uint8_t  _scan_index;     ///< The scan component of the current block
+    uint8_t  _block;          ///< The block of the component within the MCU
+    uint8_t  _k;              ///< The index of the next coefficient in the block
+    uint8_t  _pending;        ///< The size of the value after the last symbol
+    uint16_t _mcu_x;          ///< The column of the current MCU
+    uint16_t _mcu_y;          ///< The row of the current MCU
+    uint16_t _mcus_per_line;  ///< The number of MCUs across the image
+    uint32_t _mcus_total;     ///< The number of MCUs in the scan
+    uint32_t _mcus_done;      ///< The number of MCUs decoded
+    uint32_t _mcus_left;      ///< The MCUs left in the restart interval
+
+    const uint8_t* _luma_quant;     ///< The luminance quantization table, if kept
+    bool           _measure_block;  ///< True if the block is luminance in the image
+    uint32_t       _ac_total;       ///< The AC energy of the image
+    uint32_t       _ac_high;        ///< The high frequency AC energy of the image
+    uint16_t       _sharpness = 0;  ///< The sharpness of the last image
+
+    uint16_t _blocks_wide;            ///< The luminance blocks across the image
+    uint16_t _blocks_high;            ///< The luminance blocks down the image
+    uint8_t  _cells_wide;             ///< The width of the thumbnail being built
+    uint8_t  _cells_high;             ///< The height of the thumbnail being built
+    uint8_t  _level_shift;            ///< The shift that keeps the cell sums in range
+    uint8_t  _thumb_wide        = 0;  ///< The width of the finished thumbnail
+    uint8_t  _thumb_high        = 0;  ///< The height of the finished thumbnail
+    int16_t  _difference        = -1; ///< The difference from the last thumbnail
+    int16_t  _brightness_change = 0;  ///< The brightness change from the last one
+    /// The sums of the block means in each cell
+    uint16_t _sums[GEOLUX_THUMBNAIL_WIDTH * GEOLUX_THUMBNAIL_HEIGHT];
+    /// The finished thumbnail
+    uint8_t _thumbnail[GEOLUX_THUMBNAIL_WIDTH * GEOLUX_THUMBNAIL_HEIGHT];
+ private:
+    /**
+     * @brief Start the decoder over without passing anything on to the next output.
+     */
+    void resetDecoder();
+};
+
+#endif  // SRC_GEOLUXJPEG_H_
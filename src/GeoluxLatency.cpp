@@ -0,0 +1,148 @@
+/**
+ * @file       GeoluxLatency.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#include "GeoluxLatency.h"
+#include "GeoluxCamera.h"
+
+GeoluxLatencyHistogram::GeoluxLatencyHistogram() {
+    reset();
+}
+
+void GeoluxLatencyHistogram::record(uint32_t latency_ms) {
+    uint8_t bucket = 0;
+    for (uint32_t v = latency_ms; v && bucket < GEOLUX_LATENCY_BUCKETS - 1; v >>= 1) {
+        bucket++;
+    }
+    if (_buckets[bucket] != UINT16_MAX) { _buckets[bucket]++; }
+    if (!_count || latency_ms < _min) { _min = latency_ms; }
+    if (latency_ms > _max) { _max = latency_ms; }
+    _sum += latency_ms;
+    _count++;
+}
+
+void GeoluxLatencyHistogram::reset() {
+    memset(_buckets, 0, sizeof(_buckets));
+    _count = 0;
+    _min   = 0;
+    _max   = 0;
+    _sum   = 0;
+}
+
+uint32_t GeoluxLatencyHistogram::getCount() {
+    return _count;
+}
+
+uint32_t GeoluxLatencyHistogram::getMin() {
+    return _min;
+}
+
+uint32_t GeoluxLatencyHistogram::getMax() {
+    return _max;
+}
+
+uint32_t GeoluxLatencyHistogram::getMean() {
+    if (!_count) { return 0; }
+    return _sum / _count;
+}
+
+uint32_t GeoluxLatencyHistogram::getPercentile(uint8_t percentile) {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < GEOLUX_LATENCY_BUCKETS; i++) { total += _buckets[i]; }
+    if (!total) { return 0; }
+    // the number of values that must be at or below the returned latency
+    uint32_t target = (total * min(percentile, static_cast<uint8_t>(100)) + 99) / 100;
+    if (!target) { target = 1; }
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < GEOLUX_LATENCY_BUCKETS; i++) {
+        seen += _buckets[i];
+        if (seen >= target) {
+            // report the top edge of the bucket, kept within the recorded range
+            uint32_t upper = i ? (static_cast<uint32_t>(1) << i) - 1 : 0;
+            if (i == GEOLUX_LATENCY_BUCKETS - 1 || upper > _max) { upper = _max; }
+            if (upper < _min) { upper = _min; }
+            return upper;
+        }
+    }
+    return _max;
+}
+
+uint16_t GeoluxLatencyHistogram::getBucketCount(uint8_t bucket) {
+    if (bucket >= GEOLUX_LATENCY_BUCKETS) { return 0; }
+    return _buckets[bucket];
+}
+
+
+void GeoluxLatencyStats::recordCommand(geolux_command command, uint32_t latency_ms) {
+    if (command < CMD_COUNT) { _commands[command].record(latency_ms); }
+}
+
+void GeoluxLatencyStats::recordWait(geolux_wait operation, uint32_t latency_ms) {
+    if (operation < WAIT_COUNT) { _waits[operation].record(latency_ms); }
+}
+
+GeoluxLatencyHistogram& GeoluxLatencyStats::getCommandHistogram(geolux_command command) {
+    if (command >= CMD_COUNT) { command = CMD_GET_STATUS; }
+    return _commands[command];
+}
+
+GeoluxLatencyHistogram& GeoluxLatencyStats::getWaitHistogram(geolux_wait operation) {
+    if (operation >= WAIT_COUNT) { operation = WAIT_OTHER; }
+    return _waits[operation];
+}
+
+void GeoluxLatencyStats::reset() {
+    for (uint8_t i = 0; i < CMD_COUNT; i++) { _commands[i].reset(); }
+    for (uint8_t i = 0; i < WAIT_COUNT; i++) { _waits[i].reset(); }
+}
+
+/**
+ * @brief Print one row of the latency table
+ *
+ * @param outStream The stream to print to
+ * @param name The name of the row
+ * @param hist The histogram to print
+ */
+static void printHistogramRow(Stream* outStream, GsmConstStr name,
+                              GeoluxLatencyHistogram& hist) {
+    if (!hist.getCount()) { return; }
+    outStream->print(name);
+    outStream->print(GF(": n="));
+    outStream->print(hist.getCount());
+    outStream->print(GF(" min="));
+    outStream->print(hist.getMin());
+    outStream->print(GF(" p50="));
+    outStream->print(hist.getPercentile(50));
+    outStream->print(GF(" p99="));
+    outStream->print(hist.getPercentile(99));
+    outStream->print(GF(" max="));
+    outStream->print(hist.getMax());
+    outStream->print(GF(" mean="));
+    outStream->print(hist.getMean());
+    outStream->println(GF(" ms"));
+}
+
+void GeoluxLatencyStats::printStats(Stream* outStream) {
+    printHistogramRow(outStream, GF("get_status"), _commands[CMD_GET_STATUS]);
+    printHistogramRow(outStream, GF("take_snapshot"), _commands[CMD_TAKE_SNAPSHOT]);
+    printHistogramRow(outStream, GF("get_image"), _commands[CMD_GET_IMAGE]);
+    printHistogramRow(outStream, GF("get_info"), _commands[CMD_GET_INFO]);
+    printHistogramRow(outStream, GF("set_*"), _commands[CMD_SET]);
+    printHistogramRow(outStream, GF("move_*"), _commands[CMD_MOVE]);
+    printHistogramRow(outStream, GF("run_autofocus"), _commands[CMD_RUN_AUTOFOCUS]);
+    printHistogramRow(outStream, GF("reset"), _commands[CMD_RESET]);
+    printHistogramRow(outStream, GF("sleep"), _commands[CMD_SLEEP]);
+    printHistogramRow(outStream, GF("wait after snapshot"), _waits[WAIT_SNAPSHOT]);
+    printHistogramRow(outStream, GF("wait after autofocus"), _waits[WAIT_AUTOFOCUS]);
+    printHistogramRow(outStream, GF("wait after settings"), _waits[WAIT_SETTINGS]);
+    printHistogramRow(outStream, GF("wait after move"), _waits[WAIT_MOVE]);
+    printHistogramRow(outStream, GF("wait after reset"), _waits[WAIT_RESET]);
+    printHistogramRow(outStream, GF("wait"), _waits[WAIT_OTHER]);
+}
+
+void GeoluxLatencyStats::printStats(Stream& outStream) {
+    printStats(&outStream);
+}
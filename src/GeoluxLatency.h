@@ -0,0 +1,187 @@
+/**
+ * @file       GeoluxLatency.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Contains fixed-memory latency histograms for the commands sent to the camera.
+ */
+
+#ifndef SRC_GEOLUXLATENCY_H_
+#define SRC_GEOLUXLATENCY_H_
+
+#include <Arduino.h>
+
+/**
+ * @def GEOLUX_LATENCY_BUCKETS
+ * @brief The number of buckets in each latency histogram.
+ *
+ * The first bucket holds 0 ms latencies. Each bucket after that holds latencies from
+ * 2^(n-1) to 2^n-1 ms. The last bucket holds everything longer. The default of 18
+ * buckets resolves latencies up to ~65 seconds.
+ */
+#ifndef GEOLUX_LATENCY_BUCKETS
+#define GEOLUX_LATENCY_BUCKETS 18
+#endif
+
+/**
+ * @brief A log2-bucketed histogram of latencies in milliseconds.
+ *
+ * Each histogram uses a fixed amount of memory no matter how many values are recorded.
+ * Percentiles are reported as the upper edge of the bucket they fall in, so they are
+ * accurate to within a factor of two.
+ */
+class GeoluxLatencyHistogram {
+
+ public:
+    /**
+     * @brief Construct a new, empty, GeoluxLatencyHistogram object
+     */
+    GeoluxLatencyHistogram();
+
+    /**
+     * @brief Add a latency to the histogram.
+     *
+     * @param latency_ms The latency in milliseconds
+     */
+    void record(uint32_t latency_ms);
+    /**
+     * @brief Clear all recorded latencies.
+     */
+    void reset();
+
+    /**
+     * @brief Get the number of recorded latencies.
+     *
+     * @return The number of recorded latencies
+     */
+    uint32_t getCount();
+    /**
+     * @brief Get the shortest recorded latency.
+     *
+     * @return The shortest recorded latency in milliseconds, or 0 if none are recorded
+     */
+    uint32_t getMin();
+    /**
+     * @brief Get the longest recorded latency.
+     *
+     * @return The longest recorded latency in milliseconds
+     */
+    uint32_t getMax();
+    /**
+     * @brief Get the mean of the recorded latencies.
+     *
+     * @return The mean latency in milliseconds, or 0 if none are recorded
+     */
+    uint32_t getMean();
+    /**
+     * @brief Get an approximate percentile of the recorded latencies.
+     *
+     * @param percentile The percentile to get, between 0 and 100
+     * @return The latency in milliseconds that the given percent of recorded latencies
+     * are at or below, or 0 if none are recorded
+     */
+    uint32_t getPercentile(uint8_t percentile);
+    /**
+     * @brief Get the number of latencies recorded in a single bucket.
+     *
+     * @param bucket The bucket number, between 0 and #GEOLUX_LATENCY_BUCKETS - 1
+     * @return The number of latencies in the bucket
+     */
+    uint16_t getBucketCount(uint8_t bucket);
+
+ protected:
+    uint16_t _buckets[GEOLUX_LATENCY_BUCKETS];  ///< The (saturating) bucket counts
+    uint32_t _count;                            ///< The number of recorded latencies
+    uint32_t _min;                              ///< The shortest recorded latency
+    uint32_t _max;                              ///< The longest recorded latency
+    uint32_t _sum;                              ///< The sum of all recorded latencies
+};
+
+
+/**
+ * @brief A set of latency histograms for every command type sent to the camera and for
+ * the time spent in GeoluxCamera::waitForReady() after each type of operation.
+ *
+ * Attach a stats object to a camera with GeoluxCamera::setLatencyStats(). No memory is
+ * used for latency tracking unless a stats object is attached.
+ */
+class GeoluxLatencyStats {
+
+ public:
+    /// @brief The types of commands sent to the camera
+    typedef enum {
+        CMD_GET_STATUS = 0,  ///< The \#get_status command
+        CMD_TAKE_SNAPSHOT,   ///< The \#take_snapshot command
+        CMD_GET_IMAGE,       ///< The \#get_image command, timed to the end of the chunk
+        CMD_GET_INFO,        ///< The \#get_info command, timed to the end of the info
+        CMD_SET,             ///< Any of the \#set_* commands
+        CMD_MOVE,            ///< The \#move_focus and \#move_zoom commands
+        CMD_RUN_AUTOFOCUS,   ///< The \#run_autofocus command
+        CMD_RESET,           ///< The \#reset command
+        CMD_SLEEP,           ///< The \#sleep command
+        CMD_COUNT,           ///< The number of command types
+    } geolux_command;
+    /// @brief The operations that can be waited on with GeoluxCamera::waitForReady()
+    typedef enum {
+        WAIT_SNAPSHOT = 0,  ///< Waiting for a snapshot to finish
+        WAIT_AUTOFOCUS,     ///< Waiting for autofocus to finish
+        WAIT_SETTINGS,      ///< Waiting for a settings change to apply
+        WAIT_MOVE,          ///< Waiting for a focus or zoom move to finish
+        WAIT_RESET,         ///< Waiting for the camera to be ready after a reset
+        WAIT_OTHER,         ///< Waiting without any preceding operation
+        WAIT_COUNT,         ///< The number of wait types
+    } geolux_wait;
+
+    /**
+     * @brief Record the response time of a command.
+     *
+     * @param command The type of command
+     * @param latency_ms The time from sending the command to receiving the full
+     * response, in milliseconds
+     */
+    void recordCommand(geolux_command command, uint32_t latency_ms);
+    /**
+     * @brief Record the time spent waiting for the camera to be ready.
+     *
+     * @param operation The type of operation that was waited on
+     * @param latency_ms The time spent waiting, in milliseconds
+     */
+    void recordWait(geolux_wait operation, uint32_t latency_ms);
+
+    /**
+     * @brief Get the histogram for a command type.
+     *
+     * @param command The type of command
+     * @return The histogram for that command type
+     */
+    GeoluxLatencyHistogram& getCommandHistogram(geolux_command command);
+    /**
+     * @brief Get the histogram for waits after an operation type.
+     *
+     * @param operation The type of operation
+     * @return The histogram for waits after that operation
+     */
+    GeoluxLatencyHistogram& getWaitHistogram(geolux_wait operation);
+
+    /**
+     * @brief Clear all of the histograms.
+     */
+    void reset();
+
+    /**
+     * @brief Print a table of the count, minimum, median, 99th percentile, maximum and
+     * mean latency of every histogram with data.
+     *
+     * @param outStream A stream to print the table to
+     */
+    void printStats(Stream* outStream);
+    /** @copydoc GeoluxLatencyStats::printStats(Stream* outStream) */
+    void printStats(Stream& outStream);
+
+ protected:
+    GeoluxLatencyHistogram _commands[CMD_COUNT];  ///< The per-command histograms
+    GeoluxLatencyHistogram _waits[WAIT_COUNT];    ///< The per-operation wait histograms
+};
+
+#endif  // SRC_GEOLUXLATENCY_H_
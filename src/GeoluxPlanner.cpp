@@ -0,0 +1,212 @@
+/**
+ * @file       GeoluxPlanner.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#include "GeoluxPlanner.h"
+
+// typical JPEG size at quality 0, 10, ... 100, in percent of the size at quality 50
+static const uint16_t quality_curve[11] = {12,  41,  59,  76,  88, 100,
+                                           115, 140, 178, 240, 590};
+
+GeoluxCapturePlanner::GeoluxCapturePlanner() {
+    reset();
+}
+
+GeoluxCapturePlanner::geolux_capture_estimate GeoluxCapturePlanner::estimate() {
+    return predict(_pixels, _quality);
+}
+
+GeoluxCapturePlanner::geolux_capture_estimate
+GeoluxCapturePlanner::estimate(const char* resolution, uint8_t quality) {
+    return predict(parsePixels(resolution), static_cast<int8_t>(quality));
+}
+
+bool GeoluxCapturePlanner::fits(uint32_t window_ms) {
+    return estimate().total_ms <= window_ms;
+}
+
+bool GeoluxCapturePlanner::fits(uint32_t window_ms, const char* resolution,
+                                uint8_t quality) {
+    return estimate(resolution, quality).total_ms <= window_ms;
+}
+
+void GeoluxCapturePlanner::recordWait(GeoluxLatencyStats::geolux_wait operation,
+                                      uint32_t                        latency_ms) {
+    if (operation == GeoluxLatencyStats::WAIT_SNAPSHOT) {
+        addToAverage(_snapshot_ms, latency_ms);
+        geolux_planner_mode* mode = currentMode();
+        if (mode) { addToAverage(mode->snapshot_ms, latency_ms); }
+    } else if (operation == GeoluxLatencyStats::WAIT_SETTINGS) {
+        addToAverage(_settle_ms, latency_ms);
+    }
+}
+
+void GeoluxCapturePlanner::recordTransfer(uint32_t bytes, uint32_t transfer_ms,
+                                          int32_t chunk_size, int32_t image_size) {
+    // a few bytes in a few milliseconds says nothing about the rate
+    if (bytes >= 512 && transfer_ms) {
+        if (chunk_size != _chunk_size) {
+            _transfer_rate = 0;
+            _chunk_size    = chunk_size;
+        }
+        uint32_t rate = bytes / transfer_ms * 1000 +
+            (bytes % transfer_ms) * 1000 / transfer_ms;
+        addToAverage(_transfer_rate, rate);
+    }
+    geolux_planner_mode* mode = currentMode();
+    if (mode && image_size > 0) { addToAverage(mode->image_size, image_size); }
+}
+
+void GeoluxCapturePlanner::setResolution(const char* resolution) {
+    _pixels = parsePixels(resolution);
+}
+
+void GeoluxCapturePlanner::setQuality(int8_t quality) {
+    _quality = quality;
+}
+
+void GeoluxCapturePlanner::setTransferRate(uint32_t bytes_per_second) {
+    _default_rate = bytes_per_second ? bytes_per_second : 1;
+}
+
+void GeoluxCapturePlanner::setPowerDraw(uint16_t busy_mw, uint16_t transfer_mw) {
+    _busy_mw     = busy_mw;
+    _transfer_mw = transfer_mw;
+}
+
+void GeoluxCapturePlanner::setMargin(uint8_t percent) {
+    _margin = percent;
+}
+
+void GeoluxCapturePlanner::reset() {
+    memset(_modes, 0, sizeof(_modes));
+    _transfer_rate = 0;
+    _settle_ms     = 0;
+    _snapshot_ms   = 0;
+    _chunk_size    = 0;
+    _next_mode     = 0;
+}
+
+uint32_t GeoluxCapturePlanner::getTransferRate() {
+    return _transfer_rate ? _transfer_rate : _default_rate;
+}
+
+uint32_t GeoluxCapturePlanner::getSettleTime() {
+    return _settle_ms ? _settle_ms : GEOLUX_PLANNER_SETTLE_MS;
+}
+
+uint32_t GeoluxCapturePlanner::parsePixels(const char* resolution) {
+    if (!resolution) { return 0; }
+    const char* x = strchr(resolution, 'x');
+    if (!x) { return 0; }
+    return static_cast<uint32_t>(atol(resolution)) *
+        static_cast<uint32_t>(atol(x + 1));
+}
+
+uint16_t GeoluxCapturePlanner::qualityFactor(int8_t quality) {
+    if (quality <= 0) { quality = 50; }
+    if (quality > 100) { quality = 100; }
+    uint8_t i = quality / 10;
+    if (i == 10) { return quality_curve[i]; }
+    return quality_curve[i] +
+        (quality_curve[i + 1] - quality_curve[i]) * (quality % 10) / 10;
+}
+
+void GeoluxCapturePlanner::addToAverage(uint32_t& average, uint32_t value) {
+    if (!average) {
+        average = value ? value : 1;
+    } else {
+        average = average - average / 4 + value / 4;
+    }
+}
+
+GeoluxCapturePlanner::geolux_capture_estimate
+GeoluxCapturePlanner::predict(uint32_t pixels, int8_t quality) {
+    geolux_capture_estimate est = {0, 0, 0, 0, 0, 0};
+    bool current = pixels == _pixels && quality == _quality && _pixels && _quality > 0;
+    if (!current) { est.settle_ms = getSettleTime(); }
+    if (!pixels) { pixels = _pixels; }
+    if (quality <= 0) { quality = _quality; }
+
+    // the snapshot time is taken as half fixed and half proportional to the pixels
+    geolux_planner_mode* mode = nearestMode(pixels, quality, false);
+    if (mode && pixels) {
+        est.snapshot_ms = static_cast<uint32_t>(
+            static_cast<float>(mode->snapshot_ms) * (pixels + mode->pixels) /
+            (2.0f * mode->pixels));
+    } else {
+        est.snapshot_ms = _snapshot_ms ? _snapshot_ms : GEOLUX_PLANNER_SNAPSHOT_MS;
+    }
+
+    mode = nearestMode(pixels, quality, true);
+    if (mode && pixels) {
+        est.image_size = static_cast<uint32_t>(
+            static_cast<float>(mode->image_size) * pixels / mode->pixels *
+            qualityFactor(quality) / qualityFactor(mode->quality));
+    } else if (mode) {
+        est.image_size = mode->image_size;
+    } else {
+        // nothing transferred yet; assume 800x600 if the resolution isn't known
+        uint32_t kpixels = pixels ? pixels / 1000 : 480;
+        est.image_size   = kpixels * GEOLUX_PLANNER_BYTES_PER_KPIXEL *
+            qualityFactor(quality) / 100;
+    }
+
+    uint32_t rate   = getTransferRate();
+    est.transfer_ms = est.image_size / rate * 1000 +
+        (est.image_size % rate) * 1000 / rate;
+
+    uint32_t busy_ms = est.settle_ms + est.snapshot_ms;
+    est.total_ms     = busy_ms + est.transfer_ms;
+    est.total_ms += est.total_ms / 100 * _margin;
+    est.energy_mj    = busy_ms / 1000 * _busy_mw + busy_ms % 1000 * _busy_mw / 1000 +
+        est.transfer_ms / 1000 * _transfer_mw +
+        est.transfer_ms % 1000 * _transfer_mw / 1000;
+    return est;
+}
+
+GeoluxCapturePlanner::geolux_planner_mode*
+GeoluxCapturePlanner::nearestMode(uint32_t pixels, int8_t quality, bool need_size) {
+    geolux_planner_mode* best       = nullptr;
+    uint32_t             best_score = UINT32_MAX;
+    for (uint8_t i = 0; i < GEOLUX_PLANNER_MODES; i++) {
+        geolux_planner_mode* mode = &_modes[i];
+        if (!mode->pixels || !(need_size ? mode->image_size : mode->snapshot_ms)) {
+            continue;
+        }
+        // any difference in pixels counts for more than any difference in quality
+        uint32_t pixel_diff = mode->pixels > pixels ? mode->pixels - pixels
+                                                    : pixels - mode->pixels;
+        if (pixel_diff > 0xFFFFFFUL) { pixel_diff = 0xFFFFFFUL; }
+        uint32_t score = (pixel_diff << 8) + abs(mode->quality - quality);
+        if (score < best_score) {
+            best       = mode;
+            best_score = score;
+        }
+    }
+    return best;
+}
+
+GeoluxCapturePlanner::geolux_planner_mode* GeoluxCapturePlanner::currentMode() {
+    if (!_pixels || _quality <= 0) { return nullptr; }
+    geolux_planner_mode* free_mode = nullptr;
+    for (uint8_t i = 0; i < GEOLUX_PLANNER_MODES; i++) {
+        if (_modes[i].pixels == _pixels && _modes[i].quality == _quality) {
+            return &_modes[i];
+        }
+        if (!_modes[i].pixels && !free_mode) { free_mode = &_modes[i]; }
+    }
+    if (!free_mode) {
+        // all in use; replace the oldest
+        free_mode  = &_modes[_next_mode];
+        _next_mode = (_next_mode + 1) % GEOLUX_PLANNER_MODES;
+    }
+    free_mode->pixels      = _pixels;
+    free_mode->quality     = _quality;
+    free_mode->snapshot_ms = 0;
+    free_mode->image_size  = 0;
+    return free_mode;
+}
@@ -0,0 +1,272 @@
+/**
+ * @file       GeoluxPlanner.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Contains running models of the snapshot, transfer and settings times, used to
+ * predict how long a capture will keep the camera busy.
+ */
+
+#ifndef SRC_GEOLUXPLANNER_H_
+#define SRC_GEOLUXPLANNER_H_
+
+#include <Arduino.h>
+#include "GeoluxLatency.h"
+
+/**
+ * @def GEOLUX_PLANNER_MODES
+ * @brief The number of resolution and quality combinations to keep snapshot time and
+ * image size models for.
+ */
+#ifndef GEOLUX_PLANNER_MODES
+#if defined(__AVR__)
+#define GEOLUX_PLANNER_MODES 4
+#else
+#define GEOLUX_PLANNER_MODES 8
+#endif
+#endif
+
+/**
+ * @def GEOLUX_PLANNER_BYTES_PER_KPIXEL
+ * @brief The image size assumed, in bytes per thousand pixels at quality 50, before any
+ * image has been transferred.
+ */
+#ifndef GEOLUX_PLANNER_BYTES_PER_KPIXEL
+#define GEOLUX_PLANNER_BYTES_PER_KPIXEL 250
+#endif
+
+/**
+ * @def GEOLUX_PLANNER_SNAPSHOT_MS
+ * @brief The snapshot time to assume, in milliseconds, before any snapshot has been
+ * timed.
+ */
+#ifndef GEOLUX_PLANNER_SNAPSHOT_MS
+#define GEOLUX_PLANNER_SNAPSHOT_MS 1500L
+#endif
+
+/**
+ * @def GEOLUX_PLANNER_SETTLE_MS
+ * @brief The time to apply a settings change to assume, in milliseconds, before any
+ * change has been timed.
+ */
+#ifndef GEOLUX_PLANNER_SETTLE_MS
+#define GEOLUX_PLANNER_SETTLE_MS 2500L
+#endif
+
+/**
+ * @brief Keeps running models of how long the camera takes to take a snapshot, to
+ * apply new settings and to transfer each byte, and uses them to predict the time and
+ * energy of a capture without sending anything to the camera.
+ *
+ * Attach a planner to a camera with GeoluxCamera::setCapturePlanner(). The camera
+ * then reports the time spent in waitForReady() after each snapshot and settings
+ * change, the time and size of each image transfer, and any resolution and quality
+ * set or read with getCameraInfo(). Each time and size is tracked as an
+ * exponentially weighted moving average, with a weight of 1/4 on the newest value.
+ *
+ * Snapshot times and image sizes are kept separately for up to #GEOLUX_PLANNER_MODES
+ * combinations of resolution and quality. An estimate for a combination that hasn't
+ * been seen is scaled from the closest one that has, using the number of pixels and a
+ * typical curve of JPEG size against quality. The transfer rate is for the chunk size
+ * of the last transfer; it starts over when the chunk size changes.
+ */
+class GeoluxCapturePlanner {
+
+ public:
+    /// @brief A prediction of the time and energy of a capture
+    typedef struct {
+        uint32_t settle_ms;    ///< The time to apply new settings, if they change
+        uint32_t snapshot_ms;  ///< The time to take the snapshot
+        uint32_t transfer_ms;  ///< The time to transfer the image
+        uint32_t total_ms;     ///< The total time, including the safety margin
+        uint32_t image_size;   ///< The expected image size in bytes
+        uint32_t energy_mj;    ///< The camera energy in millijoules
+    } geolux_capture_estimate;
+
+    /**
+     * @brief Construct a new GeoluxCapturePlanner object
+     */
+    GeoluxCapturePlanner();
+
+    /**
+     * @brief Predict the time and energy of a capture at the current settings.
+     *
+     * @return The prediction
+     */
+    geolux_capture_estimate estimate();
+    /**
+     * @brief Predict the time and energy of a capture at other settings, including
+     * the time to change to them.
+     *
+     * @param resolution The resolution, as a string like "1280x720"
+     * @param quality The JPEG quality
+     * @return The prediction
+     */
+    geolux_capture_estimate estimate(const char* resolution, uint8_t quality);
+    /**
+     * @brief Check whether a capture at the current settings is expected to finish in
+     * the given time.
+     *
+     * @param window_ms The time available, in milliseconds
+     * @return True if the capture is expected to fit, otherwise false
+     */
+    bool fits(uint32_t window_ms);
+    /**
+     * @brief Check whether a capture at other settings is expected to finish in the
+     * given time.
+     *
+     * @param window_ms The time available, in milliseconds
+     * @param resolution The resolution, as a string like "1280x720"
+     * @param quality The JPEG quality
+     * @return True if the capture is expected to fit, otherwise false
+     */
+    bool fits(uint32_t window_ms, const char* resolution, uint8_t quality);
+
+    /**
+     * @brief Record the time spent waiting for the camera after an operation.
+     *
+     * Called by the camera; only snapshot and settings waits are used.
+     *
+     * @param operation The type of operation that was waited on
+     * @param latency_ms The time spent waiting, in milliseconds
+     */
+    void recordWait(GeoluxLatencyStats::geolux_wait operation, uint32_t latency_ms);
+    /**
+     * @brief Record an image transfer.
+     *
+     * Called by the camera at the end of each transfer.
+     *
+     * @param bytes The number of bytes transferred
+     * @param transfer_ms The time the transfer took, in milliseconds
+     * @param chunk_size The chunk size used
+     * @param image_size The size of the whole image
+     */
+    void recordTransfer(uint32_t bytes, uint32_t transfer_ms, int32_t chunk_size,
+                        int32_t image_size);
+    /**
+     * @brief Tell the planner the camera's current resolution.
+     *
+     * @param resolution The resolution, as a string like "1280x720"
+     */
+    void setResolution(const char* resolution);
+    /**
+     * @brief Tell the planner the camera's current JPEG quality.
+     *
+     * @param quality The JPEG quality
+     */
+    void setQuality(int8_t quality);
+
+    /**
+     * @brief Set the transfer rate to assume before any transfer is recorded.
+     *
+     * @param bytes_per_second The transfer rate; defaults to 11520, the rate of
+     * 115200 baud
+     */
+    void setTransferRate(uint32_t bytes_per_second);
+    /**
+     * @brief Set the power drawn by the camera while it is busy.
+     *
+     * @param busy_mw The power while applying settings and taking a snapshot, in
+     * milliwatts; defaults to 1500
+     * @param transfer_mw The power while transferring, in milliwatts; defaults to
+     * 1000
+     */
+    void setPowerDraw(uint16_t busy_mw, uint16_t transfer_mw);
+    /**
+     * @brief Set the margin added to the total time for the variation in each step.
+     *
+     * @param percent The margin in percent; defaults to 25
+     */
+    void setMargin(uint8_t percent);
+    /**
+     * @brief Forget all recorded times and sizes.
+     */
+    void reset();
+
+    /**
+     * @brief Get the modeled transfer rate.
+     *
+     * @return The transfer rate in bytes per second
+     */
+    uint32_t getTransferRate();
+    /**
+     * @brief Get the modeled time to apply a settings change.
+     *
+     * @return The settings time in milliseconds
+     */
+    uint32_t getSettleTime();
+
+ protected:
+    /// @brief The models for one resolution and quality
+    typedef struct {
+        uint32_t pixels;       ///< The number of pixels in the image
+        uint32_t snapshot_ms;  ///< The average snapshot time, or 0 if none
+        uint32_t image_size;   ///< The average image size, or 0 if none
+        int8_t   quality;      ///< The JPEG quality
+    } geolux_planner_mode;
+
+    /**
+     * @brief Get the number of pixels in a resolution.
+     *
+     * @param resolution The resolution, as a string like "1280x720"
+     * @return The number of pixels, or 0 if the string isn't a resolution
+     */
+    static uint32_t parsePixels(const char* resolution);
+    /**
+     * @brief Get the typical size of an image at a JPEG quality, relative to the
+     * size at quality 50.
+     *
+     * @param quality The JPEG quality
+     * @return The relative size, in percent
+     */
+    static uint16_t qualityFactor(int8_t quality);
+    /**
+     * @brief Add a value to a moving average.
+     *
+     * @param average The average, 0 if nothing has been added yet
+     * @param value The value to add
+     */
+    static void addToAverage(uint32_t& average, uint32_t value);
+    /**
+     * @brief Predict a capture at a number of pixels and quality.
+     *
+     * @param pixels The number of pixels in the image
+     * @param quality The JPEG quality
+     * @return The prediction
+     */
+    geolux_capture_estimate predict(uint32_t pixels, int8_t quality);
+    /**
+     * @brief Find the models closest to a number of pixels and quality, preferring
+     * the same number of pixels.
+     *
+     * @param pixels The number of pixels in the image
+     * @param quality The JPEG quality
+     * @param need_size True to only consider models with an image size, false to only
+     * consider models with a snapshot time
+     * @return The models, or nullptr if there are none
+     */
+    geolux_planner_mode* nearestMode(uint32_t pixels, int8_t quality, bool need_size);
+    /**
+     * @brief Find the models for the current settings, making room for them if they
+     * are new.
+     *
+     * @return The models, or nullptr if the current settings aren't known
+     */
+    geolux_planner_mode* currentMode();
+
+    geolux_planner_mode _modes[GEOLUX_PLANNER_MODES];  ///< The per-settings models
+    uint32_t _transfer_rate = 0;      ///< The average bytes per second, or 0 if none
+    uint32_t _default_rate  = 11520;  ///< The bytes per second to assume
+    uint32_t _settle_ms     = 0;      ///< The average settings time, or 0 if none
+    uint32_t _snapshot_ms   = 0;      ///< The average snapshot time at any settings
+    uint32_t _pixels        = 0;      ///< The current number of pixels, if known
+    int32_t  _chunk_size    = 0;      ///< The chunk size of the transfer rate
+    uint16_t _busy_mw       = 1500;   ///< The power while busy
+    uint16_t _transfer_mw   = 1000;   ///< The power while transferring
+    int8_t   _quality       = -1;     ///< The current JPEG quality, if known
+    uint8_t  _margin        = 25;     ///< The margin in percent
+    uint8_t  _next_mode     = 0;      ///< The next mode to replace when full
+};
+
+#endif  // SRC_GEOLUXPLANNER_H_
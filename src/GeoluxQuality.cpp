@@ -0,0 +1,145 @@
+/**
+ * @file       GeoluxQuality.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#include "GeoluxQuality.h"
+
+GeoluxQualityController::GeoluxQualityController(GeoluxCamera* camera,
+                                                 uint32_t      target_size)
+    : _camera(camera),
+      _target(target_size) {}
+GeoluxQualityController::GeoluxQualityController(GeoluxCamera& camera,
+                                                 uint32_t      target_size)
+    : _camera(&camera),
+      _target(target_size) {}
+
+bool GeoluxQualityController::update(int32_t image_size) {
+    if (image_size <= 0 || !_target) { return false; }
+
+    // smooth the sizes with a weight of 1/4 on the newest
+    uint32_t filtered = filterSize(image_size);
+    if (!_smoothed) {
+        _smoothed = filtered;
+    } else {
+        _smoothed = _smoothed - _smoothed / 4 + filtered / 4;
+    }
+    if (_since_change < 255) { _since_change++; }
+    if (_since_change < _hold) { return false; }
+
+    uint32_t band  = _target / 100 * _tolerance;
+    uint32_t upper = _target + band;
+    uint32_t lower = _target > band ? _target - band : 0;
+    if (_smoothed >= lower && _smoothed <= upper) { return false; }
+    if (!readQuality()) { return false; }
+
+    // one quality point for every 4% the size is off the target
+    uint32_t error = _smoothed > _target ? _smoothed - _target : _target - _smoothed;
+    uint32_t step  = error / (_target / 25 ? _target / 25 : 1);
+    if (step > _max_step) { step = _max_step; }
+    if (!step) { step = 1; }
+
+    if (_smoothed > upper) {
+        if (_quality > _min_quality) {
+            int16_t quality = _quality - static_cast<int16_t>(step);
+            return changeQuality(quality < _min_quality ? _min_quality : quality);
+        }
+        if (!_limit_kb) {
+            // out of quality to give; let the camera squeeze the large images
+            uint32_t limit_kb = upper / 1024;
+            if (limit_kb > UINT16_MAX) { limit_kb = UINT16_MAX; }
+            return changeSizeLimit(limit_kb ? limit_kb : 1);
+        }
+    } else {
+        if (_limit_kb) { return changeSizeLimit(0); }
+        if (_quality < _max_quality) {
+            int16_t quality = _quality + static_cast<int16_t>(step);
+            return changeQuality(quality > _max_quality ? _max_quality : quality);
+        }
+    }
+    return false;
+}
+
+void GeoluxQualityController::setTarget(uint32_t target_size) {
+    _target = target_size;
+}
+
+void GeoluxQualityController::setTolerance(uint8_t percent) {
+    _tolerance = percent;
+}
+
+void GeoluxQualityController::setQualityRange(uint8_t min_quality,
+                                              uint8_t max_quality) {
+    _min_quality = constrain(min_quality, 1, 100);
+    _max_quality = constrain(max_quality, _min_quality, 100);
+}
+
+void GeoluxQualityController::setMaximumStep(uint8_t step) {
+    _max_step = step ? step : 1;
+}
+
+void GeoluxQualityController::setHoldCaptures(uint8_t captures) {
+    _hold = captures;
+}
+
+int8_t GeoluxQualityController::getQuality() {
+    return _quality;
+}
+
+uint32_t GeoluxQualityController::getSmoothedSize() {
+    return _smoothed;
+}
+
+bool GeoluxQualityController::isSizeLimited() {
+    return _limit_kb != 0;
+}
+
+uint16_t GeoluxQualityController::getChangeCount() {
+    return _changes;
+}
+
+bool GeoluxQualityController::readQuality() {
+    if (_quality <= 0) { _quality = _camera->getQuality(); }
+    return _quality > 0;
+}
+
+uint32_t GeoluxQualityController::filterSize(uint32_t image_size) {
+    _recent[_recent_count % 3] = image_size;
+    _recent_count++;
+    if (_recent_count < 3) { return image_size; }
+    if (_recent_count == 6) { _recent_count = 3; }
+    uint32_t lo = _recent[0] < _recent[1] ? _recent[0] : _recent[1];
+    uint32_t hi = _recent[0] < _recent[1] ? _recent[1] : _recent[0];
+    if (hi > _recent[2]) { hi = _recent[2]; }
+    return lo > hi ? lo : hi;
+}
+
+void GeoluxQualityController::restartAverage() {
+    // the old sizes were taken at the old settings
+    _since_change = 0;
+    _smoothed     = 0;
+    _recent_count = 0;
+    _changes++;
+}
+
+bool GeoluxQualityController::changeQuality(uint8_t quality) {
+    // the hold starts whether or not the camera takes the setting
+    restartAverage();
+    DBG_GLX(GF("Changing the JPEG quality from"), _quality, GF("to"), quality);
+    if (!_camera->setQuality(quality)) {
+        _quality = -1;
+        return false;
+    }
+    _quality = quality;
+    return true;
+}
+
+bool GeoluxQualityController::changeSizeLimit(uint16_t size_kb) {
+    restartAverage();
+    DBG_GLX(GF("Changing the JPEG maximum size to"), size_kb, GF("kB"));
+    if (!_camera->setJPEGMaximumSize(size_kb)) { return false; }
+    _limit_kb = size_kb;
+    return true;
+}
@@ -0,0 +1,176 @@
+/**
+ * @file       GeoluxQuality.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Contains a controller that adjusts the JPEG quality between captures to keep
+ * the image size near a target.
+ */
+
+#ifndef SRC_GEOLUXQUALITY_H_
+#define SRC_GEOLUXQUALITY_H_
+
+#include <Arduino.h>
+#include "GeoluxCamera.h"
+
+/**
+ * @brief Adjusts the camera's JPEG quality between captures to keep images near a
+ * byte budget.
+ *
+ * The size of an image at a fixed quality changes a lot with the scene: an infrared
+ * night image may be a tenth the size of a textured day image, and the transfer time
+ * and power follow the size. Pass the size of each image to update() and the
+ * controller will lower the quality when images are too large and raise it again when
+ * they are small.
+ *
+ * To keep from changing the settings for every image:
+ * - Each size is replaced by the median of it and the two before it, so a single
+ * unusual image doesn't cause a change, and then smoothed with an exponentially
+ * weighted moving average.
+ * - Nothing is changed while the smoothed size is within the tolerance of the target.
+ * - After a change, at least setHoldCaptures() images must be taken before the next
+ * one, so the effect of the change is seen before it's changed again.
+ * - Each change moves the quality by at most setMaximumStep() points.
+ *
+ * When the quality is at its minimum and images are still too big, the camera's own
+ * JPEG maximum size is set to the top of the tolerance band, so the camera will cut
+ * the quality further for the images that need it. That limit is cleared again before
+ * the quality is raised.
+ */
+class GeoluxQualityController {
+
+ public:
+    /**
+     * @brief Construct a new GeoluxQualityController object
+     *
+     * @param camera The camera to control
+     * @param target_size The target image size in bytes
+     */
+    GeoluxQualityController(GeoluxCamera* camera, uint32_t target_size);
+    /** @copydoc GeoluxQualityController::GeoluxQualityController(GeoluxCamera* camera,
+     * uint32_t target_size) */
+    GeoluxQualityController(GeoluxCamera& camera, uint32_t target_size);
+
+    /**
+     * @brief Record the size of an image and, if needed, change the quality for the
+     * next capture.
+     *
+     * Call this once per image, with the size from GeoluxCamera::getImageSize(),
+     * after the image is transferred.
+     *
+     * @param image_size The size of the image in bytes
+     * @return True if a setting was sent to the camera, otherwise false
+     */
+    bool update(int32_t image_size);
+
+    /**
+     * @brief Set the target image size.
+     *
+     * @param target_size The target image size in bytes
+     */
+    void setTarget(uint32_t target_size);
+    /**
+     * @brief Set how far the smoothed image size can be from the target before the
+     * quality is changed.
+     *
+     * @param percent The tolerance in percent of the target; defaults to 20
+     */
+    void setTolerance(uint8_t percent);
+    /**
+     * @brief Set the range the quality is kept within.
+     *
+     * @param min_quality The lowest quality to set; defaults to 30
+     * @param max_quality The highest quality to set; defaults to 90
+     */
+    void setQualityRange(uint8_t min_quality, uint8_t max_quality);
+    /**
+     * @brief Set the largest change of quality made at once.
+     *
+     * @param step The largest change in quality points; defaults to 10
+     */
+    void setMaximumStep(uint8_t step);
+    /**
+     * @brief Set the number of images to take after a change before the settings can
+     * be changed again.
+     *
+     * @param captures The number of images; defaults to 3
+     */
+    void setHoldCaptures(uint8_t captures);
+
+    /**
+     * @brief Get the quality the controller last set or read from the camera.
+     *
+     * @return The quality, or -1 if it isn't known yet
+     */
+    int8_t getQuality();
+    /**
+     * @brief Get the smoothed image size since the last change.
+     *
+     * @return The smoothed size in bytes, or 0 if no image has been recorded since
+     */
+    uint32_t getSmoothedSize();
+    /**
+     * @brief Check whether the camera's JPEG maximum size is currently set by the
+     * controller.
+     *
+     * @return True if the size limit is set, otherwise false
+     */
+    bool isSizeLimited();
+    /**
+     * @brief Get the number of settings sent to the camera.
+     *
+     * @return The number of settings sent
+     */
+    uint16_t getChangeCount();
+
+ protected:
+    /**
+     * @brief Read the quality from the camera, if it isn't already known.
+     *
+     * @return True if the quality is known, otherwise false
+     */
+    bool readQuality();
+    /**
+     * @brief Record a size and get the median of it and the two sizes before it.
+     *
+     * @param image_size The size of the image in bytes
+     * @return The median size, or the new size if fewer than three are recorded
+     */
+    uint32_t filterSize(uint32_t image_size);
+    /**
+     * @brief Start the hold and the size averages over after a setting is sent.
+     */
+    void restartAverage();
+    /**
+     * @brief Send a new quality to the camera.
+     *
+     * @param quality The quality to set
+     * @return True if the camera accepted the quality, otherwise false
+     */
+    bool changeQuality(uint8_t quality);
+    /**
+     * @brief Set or clear the camera's JPEG maximum size.
+     *
+     * @param size_kb The maximum size in kB, or 0 to clear it
+     * @return True if the camera accepted the size, otherwise false
+     */
+    bool changeSizeLimit(uint16_t size_kb);
+
+    GeoluxCamera* _camera;              ///< The camera to control
+    uint32_t      _target;              ///< The target image size
+    uint32_t      _recent[3];           ///< The last three image sizes
+    uint32_t      _smoothed     = 0;    ///< The smoothed image size
+    uint16_t      _limit_kb     = 0;    ///< The JPEG maximum size set, in kB
+    uint16_t      _changes      = 0;    ///< The number of settings sent
+    int8_t        _quality      = -1;   ///< The current quality
+    uint8_t       _tolerance    = 20;   ///< The tolerance in percent
+    uint8_t       _min_quality  = 30;   ///< The lowest quality to set
+    uint8_t       _max_quality  = 90;   ///< The highest quality to set
+    uint8_t       _max_step     = 10;   ///< The largest change at once
+    uint8_t       _hold         = 3;    ///< Images to take between changes
+    uint8_t       _since_change = 0;    ///< Images taken since the last change
+    uint8_t       _recent_count = 0;    ///< The number of recent sizes recorded
+};
+
+#endif  // SRC_GEOLUXQUALITY_H_
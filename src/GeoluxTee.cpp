@@ -0,0 +1,220 @@
+/**
+ * @file       GeoluxTee.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#include "GeoluxTee.h"
+#include "GeoluxCamera.h"
+
+// The states of an output while an image is transferred
+static const uint8_t TEE_SENDING  = 0;  ///< Bytes go to the output
+static const uint8_t TEE_SPILLING = 1;  ///< Bytes go to the secondary output
+static const uint8_t TEE_DROPPING = 2;  ///< Bytes are discarded
+
+GeoluxTeeSink::GeoluxTeeSink() : GeoluxImageSink() {}
+
+bool GeoluxTeeSink::addOutput(Print* output, geolux_tee_policy policy, Print* spill) {
+    return addOutput(output, nullptr, policy, spill);
+}
+
+bool GeoluxTeeSink::addOutput(Print& output, geolux_tee_policy policy, Print* spill) {
+    return addOutput(&output, nullptr, policy, spill);
+}
+
+bool GeoluxTeeSink::addOutput(GeoluxImageSink* output, geolux_tee_policy policy,
+                              Print* spill) {
+    return addOutput(output, output, policy, spill);
+}
+
+bool GeoluxTeeSink::addOutput(GeoluxImageSink& output, geolux_tee_policy policy,
+                              Print* spill) {
+    return addOutput(&output, &output, policy, spill);
+}
+
+bool GeoluxTeeSink::addOutput(Print* output, GeoluxImageSink* sink,
+                              geolux_tee_policy policy, Print* spill) {
+    if (_output_count >= GEOLUX_TEE_MAX_OUTPUTS) { return false; }
+    tee_output& out = _outputs[_output_count++];
+    memset(&out, 0, sizeof(tee_output));
+    out.output = output;
+    out.sink   = sink;
+    out.spill  = spill;
+    // spilling without somewhere to spill to would lose the bytes silently
+    out.policy = (policy == TEE_SPILL && !spill) ? TEE_DROP : policy;
+    return true;
+}
+
+uint8_t GeoluxTeeSink::getOutputCount() {
+    return _output_count;
+}
+
+uint32_t GeoluxTeeSink::getBytesWritten(uint8_t index) {
+    return index < _output_count ? _outputs[index].written : 0;
+}
+
+uint32_t GeoluxTeeSink::getBytesDropped(uint8_t index) {
+    return index < _output_count ? _outputs[index].dropped : 0;
+}
+
+uint32_t GeoluxTeeSink::getBytesSpilled(uint8_t index) {
+    return index < _output_count ? _outputs[index].spilled : 0;
+}
+
+uint32_t GeoluxTeeSink::getSpillOffset(uint8_t index) {
+    if (index >= _output_count) { return 0; }
+    return _outputs[index].mode == TEE_SPILLING ? _outputs[index].spill_at
+                                                : _image_bytes;
+}
+
+uint32_t GeoluxTeeSink::getThroughput(uint8_t index) {
+    if (index >= _output_count || !_outputs[index].write_us) { return 0; }
+    return static_cast<uint32_t>(static_cast<uint64_t>(_outputs[index].written) *
+                                 1000000UL / _outputs[index].write_us);
+}
+
+void GeoluxTeeSink::printStats(Stream* outStream) {
+    for (uint8_t i = 0; i < _output_count; i++) {
+        outStream->print(GF("output "));
+        outStream->print(i);
+        outStream->print(GF(": written="));
+        outStream->print(_outputs[i].written);
+        outStream->print(GF(" dropped="));
+        outStream->print(_outputs[i].dropped);
+        outStream->print(GF(" spilled="));
+        outStream->print(_outputs[i].spilled);
+        outStream->print(GF(" rate="));
+        outStream->print(getThroughput(i));
+        outStream->println(GF(" B/s"));
+    }
+}
+
+void GeoluxTeeSink::printStats(Stream& outStream) {
+    printStats(&outStream);
+}
+
+bool GeoluxTeeSink::beginImage(int32_t image_size) {
+    _image_bytes  = 0;
+    bool accepted = false;
+    for (uint8_t i = 0; i < _output_count; i++) {
+        tee_output& out = _outputs[i];
+        out.mode        = TEE_SENDING;
+        out.buffered    = 0;
+        out.written     = 0;
+        out.dropped     = 0;
+        out.spilled     = 0;
+        out.spill_at    = 0;
+        out.write_us    = 0;
+        out.next_us     = micros();
+        // an output that refuses the image is skipped, without stopping the others
+        if (out.sink && !out.sink->beginImage(image_size)) {
+            DBG_GLX(GF("Tee output"), i, GF("refused the image"));
+            out.mode = TEE_DROPPING;
+        } else {
+            accepted = true;
+        }
+    }
+    return accepted;
+}
+
+bool GeoluxTeeSink::endImage(uint32_t) {
+    bool success = true;
+    for (uint8_t i = 0; i < _output_count; i++) {
+        tee_output& out = _outputs[i];
+        if (out.mode == TEE_SENDING) { drain(out, true); }
+        out.output->flush();
+        if (out.spill) { out.spill->flush(); }
+        if (out.sink && !out.sink->endImage(out.written)) { success = false; }
+        if (out.dropped) { success = false; }
+    }
+    return success;
+}
+
+size_t GeoluxTeeSink::write(const uint8_t* buffer, size_t size) {
+    for (uint8_t i = 0; i < _output_count; i++) { feed(_outputs[i], buffer, size); }
+    _image_bytes += size;
+    return size;
+}
+
+void GeoluxTeeSink::flush() {
+    for (uint8_t i = 0; i < _output_count; i++) {
+        if (_outputs[i].mode == TEE_SENDING) { drain(_outputs[i], true); }
+    }
+}
+
+void GeoluxTeeSink::drain(tee_output& out, bool all) {
+    if (!all) {
+        // leave a slow output alone for as long as its last write took
+        if (static_cast<int32_t>(micros() - out.next_us) < 0) { return; }
+    }
+    while (out.buffered) {
+        size_t length = out.buffered;
+        if (!all) {
+            int available = out.output->availableForWrite();
+            if (available > 0) {
+                length = min(length, static_cast<size_t>(available));
+            } else if (length < GEOLUX_TEE_WRITE_SIZE) {
+                // wait for a full block rather than sending tiny writes
+                return;
+            } else {
+                length = GEOLUX_TEE_WRITE_SIZE;
+            }
+        }
+        uint32_t start   = micros();
+        size_t   written = out.output->write(out.buffer, length);
+        uint32_t elapsed = micros() - start;
+        out.write_us += elapsed;
+        out.next_us = micros() + elapsed;
+        out.written += written;
+        out.buffered -= written;
+        memmove(out.buffer, out.buffer + written, out.buffered);
+        if (!all || !written) { return; }
+    }
+}
+
+void GeoluxTeeSink::feed(tee_output& out, const uint8_t* buffer, size_t size) {
+    if (out.mode == TEE_DROPPING) {
+        out.dropped += size;
+        return;
+    }
+    if (out.mode == TEE_SPILLING) {
+        out.spilled += out.spill->write(buffer, size);
+        return;
+    }
+    // give the output its turn before adding the new bytes
+    drain(out, false);
+    while (size) {
+        if (out.buffered == GEOLUX_TEE_BUFFER_SIZE) {
+            if (out.policy == TEE_BLOCK) {
+                drain(out, true);
+                // an output that takes nothing can't be waited for
+                if (out.buffered == GEOLUX_TEE_BUFFER_SIZE) { out.mode = TEE_DROPPING; }
+            } else if (out.policy == TEE_SPILL) {
+                // everything the output has not taken yet goes to the secondary, in
+                // order, followed by the rest of the image
+                out.mode     = TEE_SPILLING;
+                out.spill_at = out.written;
+                out.spilled += out.spill->write(out.buffer, out.buffered);
+                out.buffered = 0;
+            } else {
+                out.mode = TEE_DROPPING;
+            }
+            if (out.mode == TEE_DROPPING) {
+                DBG_GLX(GF("Tee output fell behind; dropping the rest of the image"));
+                out.dropped += out.buffered;
+                out.buffered = 0;
+            }
+            if (out.mode != TEE_SENDING) {
+                feed(out, buffer, size);
+                return;
+            }
+        }
+        size_t take = min(size, static_cast<size_t>(GEOLUX_TEE_BUFFER_SIZE -
+                                                     out.buffered));
+        memcpy(out.buffer + out.buffered, buffer, take);
+        out.buffered += take;
+        buffer += take;
+        size -= take;
+    }
+}
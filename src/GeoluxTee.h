@@ -0,0 +1,230 @@
+/**
+ * @file       GeoluxTee.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Contains an image sink that copies the image to several outputs, each with
+ * its own buffer and flow control.
+ */
+
+#ifndef SRC_GEOLUXTEE_H_
+#define SRC_GEOLUXTEE_H_
+
+#include <Arduino.h>
+#include "GeoluxImageSink.h"
+
+/**
+ * @def GEOLUX_TEE_MAX_OUTPUTS
+ * @brief The maximum number of outputs a GeoluxTeeSink can copy to.
+ */
+#ifndef GEOLUX_TEE_MAX_OUTPUTS
+#define GEOLUX_TEE_MAX_OUTPUTS 3
+#endif
+
+/**
+ * @def GEOLUX_TEE_BUFFER_SIZE
+ * @brief The size of the buffer held for each output of a GeoluxTeeSink.
+ */
+#ifndef GEOLUX_TEE_BUFFER_SIZE
+#if defined(__AVR__)
+#define GEOLUX_TEE_BUFFER_SIZE 64
+#else
+#define GEOLUX_TEE_BUFFER_SIZE 512
+#endif
+#endif
+
+/**
+ * @def GEOLUX_TEE_WRITE_SIZE
+ * @brief The most bytes written to a non-blocking output each time new image data
+ * arrives, when the output doesn't report how much it can take.
+ */
+#ifndef GEOLUX_TEE_WRITE_SIZE
+#define GEOLUX_TEE_WRITE_SIZE 64
+#endif
+
+/**
+ * @brief An image sink that copies the image to several outputs - for example an SD
+ * card file and a network upload - in a single transfer.
+ *
+ * Each output has its own buffer. Every time image data arrives, each output is given
+ * at most one bounded write: as many bytes as its availableForWrite() reports, or
+ * #GEOLUX_TEE_WRITE_SIZE bytes if it doesn't report. After each bounded write the
+ * output is left alone for as long as the write took, so no output can take more
+ * than half of the time the transfer has to drain the camera's serial port. The rest
+ * waits in its buffer. If an output falls so far behind that its buffer fills, its
+ * flow control policy decides what happens:
+ * - TEE_BLOCK: wait for the output to take the whole buffer. The transfer, and every
+ * other output, waits with it. Use this for the output that must be complete, like
+ * the SD card.
+ * - TEE_DROP: give up on the output for the rest of the image. It never slows the
+ * transfer down.
+ * - TEE_SPILL: send the buffered bytes and the rest of the image to the output's
+ * secondary output instead. The primary output keeps the start of the image and the
+ * secondary the remainder, from the offset reported by getSpillOffset(), so it can be
+ * sent on later.
+ *
+ * If an output is an image sink, it is also told when each image begins and ends.
+ */
+class GeoluxTeeSink : public GeoluxImageSink {
+
+ public:
+    /// @brief What to do when an output's buffer is full
+    typedef enum {
+        TEE_BLOCK = 0,  ///< Wait for the output to catch up
+        TEE_DROP,       ///< Stop sending the image to the output
+        TEE_SPILL,      ///< Send the rest of the image to the secondary output
+    } geolux_tee_policy;
+
+    /**
+     * @brief Construct a new GeoluxTeeSink object with no outputs
+     */
+    GeoluxTeeSink();
+
+    /**
+     * @brief Add an output to copy the image to.
+     *
+     * @param output The output
+     * @param policy What to do when the output's buffer is full; optional with a
+     * default of TEE_BLOCK
+     * @param spill The secondary output for the TEE_SPILL policy
+     * @return True if the output was added; false if there is no room for another
+     */
+    bool addOutput(Print* output, geolux_tee_policy policy = TEE_BLOCK,
+                   Print* spill = nullptr);
+    /**
+     * @copydoc GeoluxTeeSink::addOutput(Print* output, geolux_tee_policy policy,
+     * Print* spill)
+     */
+    bool addOutput(Print& output, geolux_tee_policy policy = TEE_BLOCK,
+                   Print* spill = nullptr);
+    /**
+     * @brief Add an image sink to copy the image to, passing along the begin and end
+     * of each image.
+     *
+     * @param output The image sink
+     * @param policy What to do when the sink's buffer is full; optional with a default
+     * of TEE_BLOCK
+     * @param spill The secondary output for the TEE_SPILL policy
+     * @return True if the output was added; false if there is no room for another
+     */
+    bool addOutput(GeoluxImageSink* output, geolux_tee_policy policy = TEE_BLOCK,
+                   Print* spill = nullptr);
+    /**
+     * @copydoc GeoluxTeeSink::addOutput(GeoluxImageSink* output,
+     * geolux_tee_policy policy, Print* spill)
+     */
+    bool addOutput(GeoluxImageSink& output, geolux_tee_policy policy = TEE_BLOCK,
+                   Print* spill = nullptr);
+    /**
+     * @brief Get the number of outputs.
+     *
+     * @return The number of outputs
+     */
+    uint8_t getOutputCount();
+
+    /**
+     * @brief Get the number of bytes of the last image written to an output.
+     *
+     * @param index The index of the output, in the order they were added
+     * @return The number of bytes written
+     */
+    uint32_t getBytesWritten(uint8_t index);
+    /**
+     * @brief Get the number of bytes of the last image dropped for an output.
+     *
+     * @param index The index of the output
+     * @return The number of bytes dropped
+     */
+    uint32_t getBytesDropped(uint8_t index);
+    /**
+     * @brief Get the number of bytes of the last image sent to an output's secondary
+     * output.
+     *
+     * @param index The index of the output
+     * @return The number of bytes spilled
+     */
+    uint32_t getBytesSpilled(uint8_t index);
+    /**
+     * @brief Get the offset in the last image where an output started spilling.
+     *
+     * @param index The index of the output
+     * @return The offset of the first spilled byte; the image size if nothing spilled
+     */
+    uint32_t getSpillOffset(uint8_t index);
+    /**
+     * @brief Get the rate an output accepted the last image at, counting only the time
+     * spent writing to it.
+     *
+     * @param index The index of the output
+     * @return The throughput in bytes per second
+     */
+    uint32_t getThroughput(uint8_t index);
+    /**
+     * @brief Print the per-output statistics for the last image.
+     *
+     * @param outStream The stream to print to
+     */
+    void printStats(Stream* outStream);
+    /** @copydoc GeoluxTeeSink::printStats(Stream* outStream) */
+    void printStats(Stream& outStream);
+
+    bool beginImage(int32_t image_size) override;
+    bool endImage(uint32_t bytes_written) override;
+
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using GeoluxImageSink::write;
+    void flush() override;
+
+ protected:
+    /// @brief The state of one output
+    typedef struct {
+        Print*            output;    ///< The output
+        GeoluxImageSink*  sink;      ///< The output, if it is an image sink
+        Print*            spill;     ///< The secondary output
+        geolux_tee_policy policy;    ///< The flow control policy
+        uint8_t           mode;      ///< Sending, spilling, or dropping
+        uint16_t          buffered;  ///< The number of bytes in the buffer
+        uint32_t          written;   ///< The bytes written to the output
+        uint32_t          dropped;   ///< The bytes dropped
+        uint32_t          spilled;   ///< The bytes sent to the secondary output
+        uint32_t          spill_at;  ///< The image offset spilling started at
+        uint32_t          write_us;  ///< The time spent writing to the output
+        uint32_t          next_us;   ///< The earliest time for the next bounded write
+        uint8_t           buffer[GEOLUX_TEE_BUFFER_SIZE];  ///< The output's buffer
+    } tee_output;
+
+    /**
+     * @brief Write buffered bytes to an output.
+     *
+     * @param out The output
+     * @param all True to write the whole buffer, false for one bounded write
+     */
+    void drain(tee_output& out, bool all);
+    /**
+     * @brief Add new image bytes to one output, applying its policy if its buffer is
+     * full.
+     *
+     * @param out The output
+     * @param buffer The new bytes
+     * @param size The number of new bytes
+     */
+    void feed(tee_output& out, const uint8_t* buffer, size_t size);
+    /**
+     * @brief Add an output.
+     *
+     * @param output The output
+     * @param sink The output, if it is an image sink
+     * @param policy The flow control policy
+     * @param spill The secondary output
+     * @return True if the output was added
+     */
+    bool addOutput(Print* output, GeoluxImageSink* sink, geolux_tee_policy policy,
+                   Print* spill);
+
+    tee_output _outputs[GEOLUX_TEE_MAX_OUTPUTS];  ///< The outputs
+    uint8_t    _output_count = 0;                 ///< The number of outputs
+    uint32_t   _image_bytes  = 0;                 ///< The image bytes received
+};
+
+#endif  // SRC_GEOLUXTEE_H_
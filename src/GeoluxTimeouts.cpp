@@ -0,0 +1,44 @@
+/**
+ * @file       GeoluxTimeouts.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#include "GeoluxTimeouts.h"
+
+GeoluxTimeouts::GeoluxTimeouts()
+    : response(5000L),
+      transfer(120000L),
+      ready(60000L),
+      restart(10000L),
+      us_per_byte(0),
+      stream(15),
+      char_gap(10),
+      dump_wait(25),
+      dump_gap(1),
+      chunk(0) {}
+
+GeoluxTimeouts::GeoluxTimeouts(uint32_t baud) : GeoluxTimeouts() {
+    if (!baud) { return; }
+    // a start bit, 8 data bits and a stop bit
+    uint32_t byte_us = (10000000UL + baud - 1) / baud;
+    uint32_t byte_ms = (byte_us + 999) / 1000;
+    // allow a pause of a few milliseconds plus 16 characters between characters
+    char_gap  = static_cast<uint16_t>(5 + (16 * byte_us + 999) / 1000);
+    stream    = char_gap + 5;
+    dump_wait = 2 * char_gap;
+    dump_gap  = static_cast<uint16_t>(byte_ms);
+    // twice the time on the wire, plus time for the camera to answer each chunk
+    us_per_byte = 2 * byte_us;
+    chunk       = 500;
+    transfer    = 10000L;
+}
+
+uint32_t GeoluxTimeouts::transferTimeout(int32_t image_size, int32_t chunk_size) {
+    if (image_size <= 0) { return transfer; }
+    uint32_t size   = static_cast<uint32_t>(image_size);
+    uint32_t chunks = chunk_size > 0 ? (size + chunk_size - 1) / chunk_size : 1;
+    return transfer + chunks * chunk + size / 1000 * us_per_byte +
+        size % 1000 * us_per_byte / 1000;
+}
@@ -0,0 +1,67 @@
+/**
+ * @file       GeoluxTimeouts.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Contains the timeouts used while talking to the camera.
+ */
+
+#ifndef SRC_GEOLUXTIMEOUTS_H_
+#define SRC_GEOLUXTIMEOUTS_H_
+
+#include <Arduino.h>
+
+/**
+ * @brief The time allowed for each step of talking to the camera.
+ *
+ * The default constructor gives fixed timeouts long enough for any link. Passing the
+ * baud rate instead sizes the timeouts that depend on the link from the time it takes
+ * to send one byte: the gaps between characters, the time to read out the end of a
+ * response, and the part of an image transfer spent on the wire. This lets a fast
+ * link give up sooner on a transfer that has stalled, and keeps a slow link, like
+ * SoftwareSerial, from timing out part way through a chunk or a large image.
+ *
+ * The timeouts for the camera itself to answer, to take a snapshot or to restart
+ * don't depend on the link and are the same either way. Any of the values can be
+ * changed after construction.
+ *
+ * Pass a policy to the GeoluxCamera constructor or to GeoluxCamera::setTimeouts().
+ */
+class GeoluxTimeouts {
+
+ public:
+    /**
+     * @brief Construct a new GeoluxTimeouts object with fixed timeouts
+     */
+    GeoluxTimeouts();
+    /**
+     * @brief Construct a new GeoluxTimeouts object with the link timeouts sized for a
+     * baud rate.
+     *
+     * @param baud The baud rate of the link to the camera, assuming 10 bits per byte
+     */
+    explicit GeoluxTimeouts(uint32_t baud);
+
+    /**
+     * @brief Get the time allowed for a whole image transfer.
+     *
+     * @param image_size The number of bytes to transfer
+     * @param chunk_size The size of chunks requested from the camera
+     * @return The time allowed in milliseconds
+     */
+    uint32_t transferTimeout(int32_t image_size, int32_t chunk_size);
+
+    uint32_t response;     ///< The wait for the first byte of any response
+    uint32_t transfer;     ///< The fixed part of the time allowed for an image
+    uint32_t ready;        ///< The default wait for waitForReady()
+    uint32_t restart;      ///< The wait for the start-up banner after a reset
+    uint32_t us_per_byte;  ///< The time allowed per image byte, in microseconds
+    uint16_t stream;       ///< The stream timeout while reading out a response
+    uint16_t char_gap;     ///< The longest gap between characters of an image chunk
+    uint16_t dump_wait;    ///< The wait for stray characters before a command
+    uint16_t dump_gap;     ///< The pause between stray characters being dumped
+    uint16_t chunk;        ///< The time allowed for each chunk of an image
+};
+
+#endif  // SRC_GEOLUXTIMEOUTS_H_
@@ -0,0 +1,278 @@
+/**
+ * @file       GeoluxTrace.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#include "GeoluxTrace.h"
+
+static const char GEOLUX_TRACE_MAGIC[] = "GLXT";
+
+GeoluxTraceRecorder::GeoluxTraceRecorder(Stream* cameraStream, Print* traceOutput)
+    : _camera(cameraStream),
+      _trace(traceOutput),
+      _pending_count(0),
+      _pending_rx(false),
+      _pending_start(0),
+      _last_byte_time(0),
+      _last_record(0),
+      _bytes_received(0),
+      _bytes_sent(0),
+      _held_count(0),
+      _arrivals(0),
+      _unread(0) {}
+GeoluxTraceRecorder::GeoluxTraceRecorder(Stream& cameraStream, Print& traceOutput)
+    : GeoluxTraceRecorder(&cameraStream, &traceOutput) {}
+
+void GeoluxTraceRecorder::begin() {
+    _trace->write(reinterpret_cast<const uint8_t*>(GEOLUX_TRACE_MAGIC), 4);
+    _trace->write(static_cast<uint8_t>(GEOLUX_TRACE_VERSION));
+    _pending_count = 0;
+    _held_count    = 0;
+    _arrivals      = 0;
+    _unread        = 0;
+    _last_record   = micros();
+}
+
+void GeoluxTraceRecorder::flushTrace() {
+    endRecord();
+    writeHeld();
+}
+
+void GeoluxTraceRecorder::getByteCounts(uint32_t& received, uint32_t& sent) {
+    received = _bytes_received;
+    sent     = _bytes_sent;
+}
+
+void GeoluxTraceRecorder::logByte(uint8_t b, bool from_camera, uint32_t now) {
+    if (_pending_count &&
+        (_pending_rx != from_camera || _pending_count >= GEOLUX_TRACE_BUFFER_SIZE ||
+         now - _last_byte_time > GEOLUX_TRACE_COALESCE_US)) {
+        endRecord();
+    }
+    if (!_pending_count) {
+        _pending_rx    = from_camera;
+        _pending_start = now;
+    }
+    _pending[_pending_count++] = b;
+    _last_byte_time            = now;
+    if (from_camera) {
+        _bytes_received++;
+    } else {
+        _bytes_sent++;
+    }
+}
+
+void GeoluxTraceRecorder::endRecord() {
+    if (!_pending_count) { return; }
+    // bytes that arrived before a command was sent may be read after it
+    if (static_cast<int32_t>(_pending_start - _last_record) < 0) {
+        _pending_start = _last_record;
+    }
+    uint8_t tag = _pending_count;
+    if (_pending_rx) { tag |= 0x80; }
+    holdByte(tag);
+    // write the time since the last record as an unsigned LEB128 varint
+    uint32_t delta = _pending_start - _last_record;
+    do {
+        uint8_t b = delta & 0x7F;
+        delta >>= 7;
+        if (delta) { b |= 0x80; }
+        holdByte(b);
+    } while (delta);
+    for (uint8_t i = 0; i < _pending_count; i++) { holdByte(_pending[i]); }
+    _last_record   = _pending_start;
+    _pending_count = 0;
+}
+
+void GeoluxTraceRecorder::holdByte(uint8_t b) {
+    if (_held_count >= GEOLUX_TRACE_OUTPUT_SIZE) { writeHeld(); }
+    _held[_held_count++] = b;
+}
+
+void GeoluxTraceRecorder::writeHeld() {
+    if (!_held_count) { return; }
+    _trace->write(_held, _held_count);
+    _held_count = 0;
+}
+
+void GeoluxTraceRecorder::noteArrivals(int available) {
+    if (available < _unread) {
+        // something else read from the camera stream; start counting again
+        _arrivals = 0;
+        _unread   = 0;
+    }
+    if (available == _unread) { return; }
+    if (_arrivals < GEOLUX_TRACE_ARRIVALS) {
+        _arrival_time[_arrivals]  = micros();
+        _arrival_count[_arrivals] = 0;
+        _arrivals++;
+    }
+    _arrival_count[_arrivals - 1] += available - _unread;
+    _unread = available;
+}
+
+int GeoluxTraceRecorder::available() {
+    int available = _camera->available();
+    noteArrivals(available);
+    return available;
+}
+
+int GeoluxTraceRecorder::read() {
+    int b = _camera->read();
+    if (b < 0) { return b; }
+    uint32_t arrived = micros();
+    if (_arrivals) {
+        // take the time the oldest unread byte was first seen
+        arrived = _arrival_time[0];
+        _unread--;
+        if (!--_arrival_count[0]) {
+            _arrivals--;
+            for (uint8_t i = 0; i < _arrivals; i++) {
+                _arrival_time[i]  = _arrival_time[i + 1];
+                _arrival_count[i] = _arrival_count[i + 1];
+            }
+        }
+    }
+    logByte(static_cast<uint8_t>(b), true, arrived);
+    return b;
+}
+
+int GeoluxTraceRecorder::peek() {
+    return _camera->peek();
+}
+
+size_t GeoluxTraceRecorder::write(uint8_t b) {
+    logByte(b, false, micros());
+    writeHeld();
+    return _camera->write(b);
+}
+
+size_t GeoluxTraceRecorder::write(const uint8_t* buffer, size_t size) {
+    uint32_t now = micros();
+    for (size_t i = 0; i < size; i++) { logByte(buffer[i], false, now); }
+    writeHeld();
+    return _camera->write(buffer, size);
+}
+
+void GeoluxTraceRecorder::flush() {
+    _camera->flush();
+}
+
+
+GeoluxTracePlayer::GeoluxTracePlayer(Stream* traceInput, bool realtime)
+    : _trace(traceInput),
+      _realtime(realtime),
+      _eof(false),
+      _record_rx(false),
+      _record_length(0),
+      _remaining(0),
+      _record_time(0),
+      _anchor_micros(0),
+      _anchor_time(0),
+      _mismatches(0) {}
+GeoluxTracePlayer::GeoluxTracePlayer(Stream& traceInput, bool realtime)
+    : GeoluxTracePlayer(&traceInput, realtime) {}
+
+bool GeoluxTracePlayer::begin() {
+    for (uint8_t i = 0; i < 4; i++) {
+        if (_trace->read() != GEOLUX_TRACE_MAGIC[i]) {
+            _eof = true;
+            return false;
+        }
+    }
+    if (_trace->read() != GEOLUX_TRACE_VERSION) {
+        _eof = true;
+        return false;
+    }
+    _eof           = false;
+    _remaining     = 0;
+    _record_time   = 0;
+    _anchor_time   = 0;
+    _anchor_micros = micros();
+    _mismatches    = 0;
+    return true;
+}
+
+void GeoluxTracePlayer::setRealtime(bool realtime) {
+    _realtime = realtime;
+}
+
+bool GeoluxTracePlayer::finished() {
+    return !loadRecord();
+}
+
+uint32_t GeoluxTracePlayer::getMismatchCount() {
+    return _mismatches;
+}
+
+bool GeoluxTracePlayer::loadRecord() {
+    if (_remaining) { return true; }
+    if (_eof) { return false; }
+    int tag = _trace->read();
+    if (tag <= 0 || !(tag & 0x7F)) {
+        _eof = true;
+        return false;
+    }
+    uint32_t delta = 0;
+    uint8_t  shift = 0;
+    int      b;
+    do {
+        b = _trace->read();
+        if (b < 0 || shift > 28) {
+            _eof = true;
+            return false;
+        }
+        delta |= static_cast<uint32_t>(b & 0x7F) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    _record_rx     = tag & 0x80;
+    _record_length = tag & 0x7F;
+    _remaining     = _record_length;
+    _record_time += delta;
+    return true;
+}
+
+int GeoluxTracePlayer::available() {
+    if (!loadRecord() || !_record_rx) { return 0; }
+    // hold the data until the same amount of time has passed since the last command
+    // as had passed when it was recorded
+    if (_realtime && micros() - _anchor_micros < _record_time - _anchor_time) {
+        return 0;
+    }
+    return _remaining;
+}
+
+int GeoluxTracePlayer::read() {
+    if (!available()) { return -1; }
+    _remaining--;
+    return _trace->read();
+}
+
+int GeoluxTracePlayer::peek() {
+    if (!available()) { return -1; }
+    return _trace->peek();
+}
+
+size_t GeoluxTracePlayer::write(uint8_t b) {
+    // drop any recorded responses the library never read before this command
+    while (loadRecord() && _record_rx) {
+        _trace->read();
+        _remaining--;
+    }
+    if (!loadRecord()) {
+        _mismatches++;
+        return 1;
+    }
+    // re-anchor the replay clock to the start of each recorded command
+    if (_remaining == _record_length) {
+        _anchor_micros = micros();
+        _anchor_time   = _record_time;
+    }
+    if (_trace->read() != b) { _mismatches++; }
+    _remaining--;
+    return 1;
+}
+
+void GeoluxTracePlayer::flush() {}
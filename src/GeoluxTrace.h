@@ -0,0 +1,259 @@
+/**
+ * @file       GeoluxTrace.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Contains stream decorators to record and replay the serial traffic between
+ * the library and a HydroCAM.
+ *
+ * A trace starts with the five byte header "GLXT" followed by the format version.
+ * After the header, the trace is a series of records. Each record starts with a tag
+ * byte, where the high bit gives the direction of the data (set for bytes received
+ * from the camera, clear for bytes sent to the camera) and the lower seven bits give
+ * the number of data bytes in the record (1-127). The tag is followed by the number of
+ * microseconds since the start of the previous record as an unsigned LEB128 varint
+ * and then the data bytes themselves.
+ */
+
+#ifndef SRC_GEOLUXTRACE_H_
+#define SRC_GEOLUXTRACE_H_
+
+#include <Arduino.h>
+
+/**
+ * @def GEOLUX_TRACE_BUFFER_SIZE
+ * @brief The number of bytes the recorder holds before writing a record to the trace.
+ *
+ * Must be between 1 and 127.
+ */
+#ifndef GEOLUX_TRACE_BUFFER_SIZE
+#define GEOLUX_TRACE_BUFFER_SIZE 32
+#endif
+static_assert(GEOLUX_TRACE_BUFFER_SIZE >= 1 && GEOLUX_TRACE_BUFFER_SIZE <= 127,
+              "GEOLUX_TRACE_BUFFER_SIZE must be between 1 and 127");
+
+/**
+ * @def GEOLUX_TRACE_OUTPUT_SIZE
+ * @brief The number of bytes of finished records the recorder holds in RAM until the
+ * library next sends to the camera.
+ *
+ * The records for a whole response, or a whole image chunk, need to fit to keep the
+ * trace output out of the receive loop. When this fills up, it is written out
+ * immediately instead. Use a smaller chunk size while recording an image transfer
+ * if there isn't enough memory.
+ */
+#ifndef GEOLUX_TRACE_OUTPUT_SIZE
+#if defined(__AVR__)
+#define GEOLUX_TRACE_OUTPUT_SIZE 256
+#else
+#define GEOLUX_TRACE_OUTPUT_SIZE 2048
+#endif
+#endif
+
+/**
+ * @def GEOLUX_TRACE_COALESCE_US
+ * @brief The longest gap, in microseconds, between two bytes in the same direction
+ * that will still be stored in the same record.
+ *
+ * At 115200 baud a character takes ~87µs, so anything longer than a few character
+ * times is a real pause in the traffic and gets its own timestamp.
+ */
+#ifndef GEOLUX_TRACE_COALESCE_US
+#define GEOLUX_TRACE_COALESCE_US 250
+#endif
+
+/// The version of the trace format written by the recorder
+#define GEOLUX_TRACE_VERSION 1
+
+/// The number of separate arrivals of unread bytes the recorder keeps times for
+#define GEOLUX_TRACE_ARRIVALS 8
+
+/**
+ * @brief A stream decorator that passes all traffic through to the camera stream while
+ * logging every byte, in both directions, with a microsecond timestamp to a trace.
+ *
+ * Give the recorder to GeoluxCamera::begin() in place of the camera's serial port.
+ * Bytes from the camera are time stamped when available() first reports them, rather
+ * than when the library gets around to reading them, so the trace keeps the camera's
+ * timing and not the library's.
+ *
+ * Finished records are held in RAM and only written to the trace output when the
+ * library next sends something to the camera or when flushTrace() is called, so a
+ * slow trace output (like an SD card) doesn't stall the library's receive loop.
+ */
+class GeoluxTraceRecorder : public Stream {
+
+ public:
+    /**
+     * @brief Construct a new GeoluxTraceRecorder object
+     *
+     * @param cameraStream The stream instance the camera is attached to
+     * @param traceOutput The output to write the binary trace to
+     */
+    GeoluxTraceRecorder(Stream* cameraStream, Print* traceOutput);
+    /** @copydoc GeoluxTraceRecorder::GeoluxTraceRecorder(Stream* cameraStream, Print*
+     * traceOutput) */
+    GeoluxTraceRecorder(Stream& cameraStream, Print& traceOutput);
+
+    /**
+     * @brief Write the trace header.
+     *
+     * This must be called once before any traffic is recorded.
+     */
+    void begin();
+    /**
+     * @brief Write any pending and held records out to the trace.
+     *
+     * Call this before closing the trace output.
+     */
+    void flushTrace();
+
+    /**
+     * @brief Get the number of bytes recorded in each direction.
+     *
+     * @param received Filled with the number of bytes received from the camera
+     * @param sent Filled with the number of bytes sent to the camera
+     */
+    void getByteCounts(uint32_t& received, uint32_t& sent);
+
+    int    available() override;
+    int    read() override;
+    int    peek() override;
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    void   flush() override;
+    using Print::write;
+
+ protected:
+    /**
+     * @brief Add a byte to the pending record, starting a new record if needed.
+     *
+     * @param b The byte to log
+     * @param from_camera True if the byte was received from the camera
+     * @param now The micros() time of the byte
+     */
+    void logByte(uint8_t b, bool from_camera, uint32_t now);
+    /**
+     * @brief Move the pending record, if any, into the held records.
+     */
+    void endRecord();
+    /**
+     * @brief Add a byte to the held records, writing them out first if they're full.
+     *
+     * @param b The byte to add
+     */
+    void holdByte(uint8_t b);
+    /**
+     * @brief Write all of the held records out to the trace.
+     */
+    void writeHeld();
+    /**
+     * @brief Note the time of any bytes from the camera that weren't available
+     * before.
+     *
+     * @param available The number of bytes the camera stream reports as available
+     */
+    void noteArrivals(int available);
+
+    Stream*  _camera;           ///< The stream the camera is attached to
+    Print*   _trace;            ///< The output for the trace
+    uint8_t  _pending[GEOLUX_TRACE_BUFFER_SIZE];  ///< Bytes in the pending record
+    uint8_t  _pending_count;    ///< The number of bytes in the pending record
+    bool     _pending_rx;       ///< True if the pending record is from the camera
+    uint32_t _pending_start;    ///< The micros() time of the pending record
+    uint32_t _last_byte_time;   ///< The micros() time of the last logged byte
+    uint32_t _last_record;      ///< The micros() time of the last written record
+    uint32_t _bytes_received;   ///< The number of bytes received from the camera
+    uint32_t _bytes_sent;       ///< The number of bytes sent to the camera
+    uint8_t  _held[GEOLUX_TRACE_OUTPUT_SIZE];  ///< Finished records not yet written
+    uint16_t _held_count;       ///< The number of bytes in the held records
+    uint32_t _arrival_time[GEOLUX_TRACE_ARRIVALS];   ///< When unread bytes arrived
+    uint16_t _arrival_count[GEOLUX_TRACE_ARRIVALS];  ///< Unread bytes per arrival
+    uint8_t  _arrivals;         ///< The number of arrivals with unread bytes
+    int      _unread;           ///< The number of bytes known to be unread
+};
+
+
+/**
+ * @brief A stream that plays a trace written by GeoluxTraceRecorder back into a
+ * GeoluxCamera object in place of a real camera.
+ *
+ * Bytes the library writes are matched against the recorded outgoing traffic. Each
+ * time the library starts sending a recorded command, the replay clock is re-anchored
+ * to that command so the camera's responses become available with the same delays they
+ * had in the original session - or immediately if real-time playback is disabled.
+ */
+class GeoluxTracePlayer : public Stream {
+
+ public:
+    /**
+     * @brief Construct a new GeoluxTracePlayer object
+     *
+     * @param traceInput The stream to read the binary trace from
+     * @param realtime True to replay with the original timing, false to make all
+     * recorded data available as fast as possible; optional with a default of true.
+     */
+    GeoluxTracePlayer(Stream* traceInput, bool realtime = true);
+    /** @copydoc GeoluxTracePlayer::GeoluxTracePlayer(Stream* traceInput, bool
+     * realtime) */
+    GeoluxTracePlayer(Stream& traceInput, bool realtime = true);
+
+    /**
+     * @brief Read and check the trace header.
+     *
+     * @return True if the trace header is valid, otherwise false
+     */
+    bool begin();
+    /**
+     * @brief Select real time or as-fast-as-possible playback.
+     *
+     * @param realtime True to replay with the original timing
+     */
+    void setRealtime(bool realtime);
+    /**
+     * @brief Check if the whole trace has been played.
+     *
+     * @return True if there are no more records in the trace
+     */
+    bool finished();
+    /**
+     * @brief Get the number of bytes written by the library that did not match the
+     * trace.
+     *
+     * A non-zero count means the library's behavior has diverged from the recorded
+     * session and the rest of the replay may not be meaningful.
+     *
+     * @return The number of mismatched bytes
+     */
+    uint32_t getMismatchCount();
+
+    int    available() override;
+    int    read() override;
+    int    peek() override;
+    size_t write(uint8_t b) override;
+    void   flush() override;
+    using Print::write;
+
+ protected:
+    /**
+     * @brief Read the next record header from the trace, if the current record is used
+     * up.
+     *
+     * @return True if there is a record with data remaining
+     */
+    bool loadRecord();
+
+    Stream*  _trace;          ///< The stream to read the trace from
+    bool     _realtime;       ///< True to replay with the original timing
+    bool     _eof;            ///< True when the trace has run out
+    bool     _record_rx;      ///< True if the current record is from the camera
+    uint8_t  _record_length;  ///< The number of bytes in the current record
+    uint8_t  _remaining;      ///< The number of bytes left in the current record
+    uint32_t _record_time;    ///< The trace time of the current record, in µs
+    uint32_t _anchor_micros;  ///< The micros() time of the last re-anchor
+    uint32_t _anchor_time;    ///< The trace time of the last re-anchor, in µs
+    uint32_t _mismatches;     ///< The number of written bytes not matching the trace
+};
+
+#endif  // SRC_GEOLUXTRACE_H_
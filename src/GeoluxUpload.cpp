@@ -0,0 +1,162 @@
+/**
+ * @file       GeoluxUpload.cpp
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ */
+
+#include "GeoluxUpload.h"
+#include "GeoluxCamera.h"
+
+/**
+ * @brief Send a list of strings to the client, or just count them.
+ *
+ * The multipart headers are built the same way for counting and for sending, so the
+ * Content-Length always matches what is sent.
+ *
+ * @param client The client to send to, or nullptr to only count
+ * @param parts The strings to send
+ * @param count The number of strings
+ * @return The total length of the strings
+ */
+static uint32_t sendParts(Client* client, const char* const* parts, uint8_t count) {
+    uint32_t length = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (client) { client->print(parts[i]); }
+        length += strlen(parts[i]);
+    }
+    return length;
+}
+
+GeoluxUploadSink::GeoluxUploadSink(Client* client)
+    : GeoluxImageSink(),
+      _client(client) {}
+GeoluxUploadSink::GeoluxUploadSink(Client& client)
+    : GeoluxImageSink(),
+      _client(&client) {}
+
+void GeoluxUploadSink::setServer(const char* host, uint16_t port, const char* path) {
+    _host = host;
+    _port = port;
+    _path = path;
+}
+
+void GeoluxUploadSink::setFileName(const char* filename) {
+    _filename = filename;
+}
+
+void GeoluxUploadSink::setFieldName(const char* field_name) {
+    _field_name = field_name;
+}
+
+void GeoluxUploadSink::setResponseTimeout(uint32_t timeout_ms) {
+    _timeout = timeout_ms;
+}
+
+uint32_t GeoluxUploadSink::getContentLength(uint32_t image_size) {
+    return writePreamble(nullptr) + image_size + writeEpilogue(nullptr);
+}
+
+int16_t GeoluxUploadSink::getStatusCode() {
+    return _status_code;
+}
+
+bool GeoluxUploadSink::beginImage(int32_t image_size) {
+    _status_code = 0;
+    _buffered    = 0;
+    _failed      = false;
+    _remaining   = image_size > 0 ? static_cast<uint32_t>(image_size) : 0;
+    if (!_remaining) { return false; }
+    // a new boundary for each image, so it is unlikely to appear in the image data
+    snprintf(_boundary, sizeof(_boundary), "GeoluxBoundary%08lX",
+             static_cast<unsigned long>(micros()));
+
+    if (!_client->connect(_host, _port)) {
+        DBG_GLX(GF("Could not connect to"), _host, GF("port"), _port);
+        return false;
+    }
+    _client->print(GF("POST "));
+    _client->print(_path);
+    _client->print(GF(" HTTP/1.1\r\nHost: "));
+    _client->print(_host);
+    _client->print(GF("\r\nContent-Type: multipart/form-data; boundary="));
+    _client->print(_boundary);
+    _client->print(GF("\r\nContent-Length: "));
+    _client->print(getContentLength(_remaining));
+    _client->print(GF("\r\nConnection: close\r\n\r\n"));
+    writePreamble(_client);
+    return GeoluxImageSink::beginImage(image_size);
+}
+
+bool GeoluxUploadSink::endImage(uint32_t bytes_written) {
+    writeBuffer();
+    if (_failed || _remaining) {
+        // the body would not match the Content-Length; drop the connection so the
+        // server discards the request instead of storing a broken image
+        DBG_GLX(GF("Upload incomplete;"), _remaining, GF("image bytes not sent"));
+        _client->stop();
+        GeoluxImageSink::endImage(bytes_written);
+        return false;
+    }
+    writeEpilogue(_client);
+
+    // wait for the status line, "HTTP/1.1 200 OK"
+    uint32_t start_time = millis();
+    while (!_client->available() && _client->connected() &&
+           millis() - start_time < _timeout);
+    uint32_t prev_timeout = _client->getTimeout();
+    _client->setTimeout(_timeout);
+    if (_client->find(' ')) { _status_code = static_cast<int16_t>(_client->parseInt()); }
+    _client->setTimeout(prev_timeout);
+    _client->stop();
+    DBG_GLX(GF("Upload response status:"), _status_code);
+
+    bool success = _status_code >= 200 && _status_code < 300;
+    return GeoluxImageSink::endImage(bytes_written) && success;
+}
+
+size_t GeoluxUploadSink::write(const uint8_t* buffer, size_t size) {
+    if (_failed) { return 0; }
+    // never send more than the Content-Length allows for the image
+    size = min(size, static_cast<size_t>(_remaining));
+    size_t accepted = 0;
+    while (accepted < size) {
+        size_t take = min(size - accepted,
+                          static_cast<size_t>(GEOLUX_UPLOAD_BUFFER_SIZE - _buffered));
+        memcpy(_buffer + _buffered, buffer + accepted, take);
+        _buffered += take;
+        accepted += take;
+        _remaining -= take;
+        if (_buffered == GEOLUX_UPLOAD_BUFFER_SIZE && !writeBuffer()) {
+            return accepted - take;
+        }
+    }
+    return accepted;
+}
+
+void GeoluxUploadSink::flush() {
+    writeBuffer();
+}
+
+uint32_t GeoluxUploadSink::writePreamble(Client* client) {
+    const char* const parts[] = {"--",
+                                 _boundary,
+                                 "\r\nContent-Disposition: form-data; name=\"",
+                                 _field_name,
+                                 "\"; filename=\"",
+                                 _filename,
+                                 "\"\r\nContent-Type: image/jpeg\r\n\r\n"};
+    return sendParts(client, parts, sizeof(parts) / sizeof(parts[0]));
+}
+
+uint32_t GeoluxUploadSink::writeEpilogue(Client* client) {
+    const char* const parts[] = {"\r\n--", _boundary, "--\r\n"};
+    return sendParts(client, parts, sizeof(parts) / sizeof(parts[0]));
+}
+
+bool GeoluxUploadSink::writeBuffer() {
+    if (!_buffered || _failed) { return !_failed; }
+    _failed   = _client->write(_buffer, _buffered) != _buffered;
+    _buffered = 0;
+    return !_failed;
+}
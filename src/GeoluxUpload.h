@@ -0,0 +1,146 @@
+/**
+ * @file       GeoluxUpload.h
+ * @author     Sara Damiano
+ * @copyright  Stroud Water Research Center
+ * @date       October 2026
+ *
+ * @brief Contains an image sink that uploads the image to a web server as it is
+ * transferred.
+ */
+
+#ifndef SRC_GEOLUXUPLOAD_H_
+#define SRC_GEOLUXUPLOAD_H_
+
+#include <Arduino.h>
+#include <Client.h>
+#include "GeoluxImageSink.h"
+
+/**
+ * @def GEOLUX_UPLOAD_BUFFER_SIZE
+ * @brief The number of image bytes collected before they are written to the client.
+ *
+ * Cellular and WiFi clients send each write as its own packet or modem command, so
+ * writing the image a byte at a time would be very slow.
+ */
+#ifndef GEOLUX_UPLOAD_BUFFER_SIZE
+#if defined(__AVR__)
+#define GEOLUX_UPLOAD_BUFFER_SIZE 64
+#else
+#define GEOLUX_UPLOAD_BUFFER_SIZE 256
+#endif
+#endif
+
+/**
+ * @brief An image sink that streams the image straight to a web server as a
+ * multipart/form-data HTTP POST, with no copy on an SD card.
+ *
+ * The exact Content-Length is worked out from the image size when the image begins,
+ * so the request is sent in a single pass without chunked encoding. If the camera
+ * delivers fewer bytes than it reported, the connection is dropped without finishing
+ * the request so the server does not store a truncated image; any extra bytes are
+ * not sent.
+ *
+ * Any Arduino Client can be used - for example a TinyGSM, WiFi or Ethernet client.
+ * The host, path, field name and file name strings are not copied, so they must stay
+ * in scope for the transfer.
+ */
+class GeoluxUploadSink : public GeoluxImageSink {
+
+ public:
+    /**
+     * @brief Construct a new GeoluxUploadSink object
+     *
+     * @param client The client to connect to the server with
+     */
+    explicit GeoluxUploadSink(Client* client);
+    /** @copydoc GeoluxUploadSink::GeoluxUploadSink(Client* client) */
+    explicit GeoluxUploadSink(Client& client);
+
+    /**
+     * @brief Set the server to upload to.
+     *
+     * @param host The host name or IP address of the server
+     * @param port The port of the server
+     * @param path The path to post the image to
+     */
+    void setServer(const char* host, uint16_t port = 80, const char* path = "/");
+    /**
+     * @brief Set the file name sent with the image.
+     *
+     * @param filename The file name; optional with a default of "image.jpg"
+     */
+    void setFileName(const char* filename);
+    /**
+     * @brief Set the name of the form field the image is sent in.
+     *
+     * @param field_name The field name; optional with a default of "image"
+     */
+    void setFieldName(const char* field_name);
+    /**
+     * @brief Set how long to wait for the server to respond after the image is sent.
+     *
+     * @param timeout_ms The timeout in milliseconds; optional with a default of 10000
+     */
+    void setResponseTimeout(uint32_t timeout_ms);
+
+    /**
+     * @brief Get the total length of the request body for an image.
+     *
+     * @param image_size The size of the image
+     * @return The Content-Length of the request
+     */
+    uint32_t getContentLength(uint32_t image_size);
+    /**
+     * @brief Get the HTTP status code the server returned for the last image.
+     *
+     * @return The status code, or 0 if no response was received
+     */
+    int16_t getStatusCode();
+
+    bool beginImage(int32_t image_size) override;
+    bool endImage(uint32_t bytes_written) override;
+
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using GeoluxImageSink::write;
+    void flush() override;
+
+ protected:
+    /**
+     * @brief Write the multipart headers that come before the image.
+     *
+     * @param client The client to write to, or nullptr to only count the length
+     * @return The length of the headers
+     */
+    uint32_t writePreamble(Client* client);
+    /**
+     * @brief Write the closing multipart boundary that comes after the image.
+     *
+     * @param client The client to write to, or nullptr to only count the length
+     * @return The length of the closing boundary
+     */
+    uint32_t writeEpilogue(Client* client);
+    /**
+     * @brief Write out whatever is in the staging buffer.
+     *
+     * @return True if the whole buffer was written, otherwise false
+     */
+    bool writeBuffer();
+
+    Client*     _client;                     ///< The client to upload with
+    const char* _host        = "";           ///< The server host
+    uint16_t    _port        = 80;           ///< The server port
+    const char* _path        = "/";          ///< The path to post to
+    const char* _filename    = "image.jpg";  ///< The file name sent with the image
+    const char* _field_name  = "image";      ///< The form field name
+    uint32_t    _timeout     = 10000L;       ///< The response timeout, in ms
+    uint32_t    _remaining   = 0;            ///< The image bytes still to send
+    uint16_t    _buffered    = 0;            ///< The number of bytes in the buffer
+    int16_t     _status_code = 0;            ///< The last HTTP status code
+    bool        _failed      = false;        ///< True if a write to the client failed
+    /// The multipart boundary
+    char _boundary[24] = "";
+    /// The staging buffer for writes to the client
+    uint8_t _buffer[GEOLUX_UPLOAD_BUFFER_SIZE];
+};
+
+#endif  // SRC_GEOLUXUPLOAD_H_